@@ -0,0 +1,62 @@
+#include <rbtree.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// rbtree_find 를 하나씩 부르는 것과 rbtree_find_batch 로 묶어 찾는 것의 비교
+// 사용법: ./bench-find-batch [n] [lookups]
+
+static double now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+  size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : n;
+
+  key_t *keys = malloc(n * sizeof(key_t));
+  key_t *probes = malloc(lookups * sizeof(key_t));
+  node_t **out = malloc(lookups * sizeof(node_t *));
+  if (keys == NULL || probes == NULL || out == NULL)
+  {
+    return 1;
+  }
+  srand(42);
+  rbtree *t = new_rbtree();
+  for (size_t i = 0; i < n; i++)
+  {
+    keys[i] = rand();
+    rbtree_insert(t, keys[i]);
+  }
+  // 절반은 트리에 있는 키, 절반은 (거의) 없는 키
+  for (size_t i = 0; i < lookups; i++)
+  {
+    probes[i] = i % 2 ? keys[rand() % n] : rand();
+  }
+
+  size_t hits = 0;
+  double start = now_ns();
+  for (size_t i = 0; i < lookups; i++)
+  {
+    hits += rbtree_find(t, probes[i]) != NULL;
+  }
+  double single_ns = (now_ns() - start) / lookups;
+
+  start = now_ns();
+  size_t batch_hits = rbtree_find_batch(t, probes, lookups, out);
+  double batch_ns = (now_ns() - start) / lookups;
+
+  printf("n=%zu lookups=%zu hits=%zu/%zu (ns/op)\n", n, lookups, hits, batch_hits);
+  printf("%-22s %10.1f\n", "rbtree_find", single_ns);
+  printf("%-22s %10.1f\n", "rbtree_find_batch", batch_ns);
+
+  delete_rbtree(t);
+  free(out);
+  free(probes);
+  free(keys);
+  return hits == batch_hits ? 0 : 1;
+}
@@ -0,0 +1,331 @@
+#include <rbtree.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// insert / find(hit, miss) / erase / to_array 마이크로 벤치마크
+// rbtree.h 의 기본 API만 쓰므로 src/compact 같은 다른 엔진에도 그대로 빌드됨
+//
+// 사용법: ./bench-rbtree [-n 최대크기] [-m 최소크기] [-d random|sorted|reverse|dups|all] [-p] [-s seed]
+//   크기는 최소부터 10배씩 늘려 최대까지 측정 (기본 1e3 ~ 1e8)
+//   -p 를 주면 new_rbtree_with_pool(n) 으로 만든 트리를 사용
+//
+// ns/op 는 단계 전체 시간 / 연산 수, 백분위 지연은 일부 연산(최대 SAMPLE_MAX 개)을 개별 측정한 값
+// -DRBTREE_STATS 로 빌드하면 insert / erase 단계의 회전 수도 함께 출력
+
+#define SAMPLE_MAX 100000
+
+typedef enum
+{
+  DIST_RANDOM,
+  DIST_SORTED,
+  DIST_REVERSE,
+  DIST_DUPS,
+  DIST_COUNT
+} dist_t;
+
+static const char *dist_name[DIST_COUNT] = {"random", "sorted", "reverse", "dups"};
+
+static uint64_t rng_state = 88172645463325252ull;
+
+// xorshift64: 실행마다 같은 키가 나오도록 자체 난수 사용
+static uint64_t rng_next(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return rng_state;
+}
+
+static inline uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// 트리에 넣는 키는 모두 짝수, 없는 키 탐색은 홀수로 하여 반드시 miss 가 나게 함
+static void make_keys(key_t *keys, size_t n, dist_t dist)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    uint64_t v;
+    switch (dist)
+    {
+    case DIST_SORTED:
+      v = i;
+      break;
+    case DIST_REVERSE:
+      v = n - 1 - i;
+      break;
+    case DIST_DUPS:
+      // 키 종류가 n/100 개뿐이라 키마다 평균 100개씩 중복
+      v = rng_next() % (n / 100 + 1);
+      break;
+    default:
+      v = rng_next() % 0x3fffffff;
+      break;
+    }
+    keys[i] = (key_t)(v * 2);
+  }
+}
+
+// 탐색/삭제 순서: 키 배열을 무작위로 섞은 인덱스
+static void make_order(size_t *order, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    order[i] = i;
+  }
+  for (size_t i = n; i > 1; i--)
+  {
+    size_t j = rng_next() % i;
+    size_t tmp = order[i - 1];
+    order[i - 1] = order[j];
+    order[j] = tmp;
+  }
+}
+
+typedef struct
+{
+  uint64_t *samples; // 개별 측정한 지연 (ns)
+  size_t count;
+  size_t every; // 몇 번째 연산마다 측정할지
+  uint64_t start;
+} phase_timer;
+
+static void timer_begin(phase_timer *tm, uint64_t *samples, size_t ops)
+{
+  tm->samples = samples;
+  tm->count = 0;
+  tm->every = ops / SAMPLE_MAX + 1;
+  tm->start = now_ns();
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+  const uint64_t x = *(const uint64_t *)a;
+  const uint64_t y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static void report(const char *dist, size_t n, const char *op, phase_timer *tm, size_t ops,
+                   long long rotations)
+{
+  uint64_t total = now_ns() - tm->start;
+  qsort(tm->samples, tm->count, sizeof(uint64_t), cmp_u64);
+  uint64_t p[4] = {0, 0, 0, 0};
+  const double q[4] = {0.50, 0.90, 0.99, 0.999};
+  for (int i = 0; i < 4 && tm->count > 0; i++)
+  {
+    p[i] = tm->samples[(size_t)(q[i] * (tm->count - 1))];
+  }
+  printf("%-8s %10zu %-10s %9.1f %7llu %7llu %7llu %7llu", dist, n, op,
+         ops ? (double)total / ops : 0.0, (unsigned long long)p[0], (unsigned long long)p[1],
+         (unsigned long long)p[2], (unsigned long long)p[3]);
+  if (rotations >= 0)
+  {
+    printf(" %11lld", rotations);
+  }
+  printf("\n");
+  fflush(stdout);
+}
+
+// i 번째 연산을 표본으로 측정할지 여부
+#define SAMPLED(tm, i) ((i) % (tm).every == 0)
+
+// 회전 수 (통계 빌드가 아니면 -1 로 출력하지 않음)
+#ifdef RBTREE_STATS
+static long long total_rotations(const rbtree *t)
+{
+  rbtree_stats s;
+  rbtree_get_stats(t, &s);
+  return (long long)(s.left_rotations + s.right_rotations);
+}
+#else
+#define total_rotations(t) (-1LL)
+#endif
+
+static void bench_one(size_t n, dist_t dist, int pooled, key_t *keys, size_t *order, key_t *out,
+                      uint64_t *samples)
+{
+  const char *dname = dist_name[dist];
+  phase_timer tm;
+  volatile size_t sink = 0;
+
+  make_keys(keys, n, dist);
+  make_order(order, n);
+
+  rbtree *t = pooled ? new_rbtree_with_pool(n) : new_rbtree();
+  if (t == NULL)
+  {
+    fprintf(stderr, "out of memory at n=%zu\n", n);
+    exit(1);
+  }
+
+  // insert: 분포 순서 그대로 삽입 (sorted/reverse 는 한쪽으로만 자라는 최악의 입력)
+  long long rot = total_rotations(t);
+  timer_begin(&tm, samples, n);
+  for (size_t i = 0; i < n; i++)
+  {
+    if (SAMPLED(tm, i))
+    {
+      uint64_t s = now_ns();
+      rbtree_insert(t, keys[i]);
+      tm.samples[tm.count++] = now_ns() - s;
+    }
+    else
+    {
+      rbtree_insert(t, keys[i]);
+    }
+  }
+  report(dname, n, "insert", &tm, n, rot < 0 ? -1 : total_rotations(t) - rot);
+
+  // find (hit): 무작위 순서로 존재하는 키 탐색
+  timer_begin(&tm, samples, n);
+  for (size_t i = 0; i < n; i++)
+  {
+    const key_t k = keys[order[i]];
+    if (SAMPLED(tm, i))
+    {
+      uint64_t s = now_ns();
+      sink += rbtree_find(t, k) != NULL;
+      tm.samples[tm.count++] = now_ns() - s;
+    }
+    else
+    {
+      sink += rbtree_find(t, k) != NULL;
+    }
+  }
+  report(dname, n, "find-hit", &tm, n, -1);
+
+  // find (miss): 홀수 키는 트리에 없음
+  timer_begin(&tm, samples, n);
+  for (size_t i = 0; i < n; i++)
+  {
+    const key_t k = keys[order[i]] + 1;
+    if (SAMPLED(tm, i))
+    {
+      uint64_t s = now_ns();
+      sink += rbtree_find(t, k) != NULL;
+      tm.samples[tm.count++] = now_ns() - s;
+    }
+    else
+    {
+      sink += rbtree_find(t, k) != NULL;
+    }
+  }
+  report(dname, n, "find-miss", &tm, n, -1);
+
+  // to_array: 전체 스냅샷, 키 하나당 비용으로 출력 (표본은 호출 한 번)
+  timer_begin(&tm, samples, 1);
+  {
+    uint64_t s = now_ns();
+    sink += rbtree_to_array(t, out, n);
+    tm.samples[tm.count++] = now_ns() - s;
+  }
+  report(dname, n, "to_array", &tm, n, -1);
+
+  // erase: 무작위 순서로 찾아서 삭제
+  rot = total_rotations(t);
+  timer_begin(&tm, samples, n);
+  for (size_t i = 0; i < n; i++)
+  {
+    const key_t k = keys[order[i]];
+    if (SAMPLED(tm, i))
+    {
+      uint64_t s = now_ns();
+      rbtree_erase(t, rbtree_find(t, k));
+      tm.samples[tm.count++] = now_ns() - s;
+    }
+    else
+    {
+      rbtree_erase(t, rbtree_find(t, k));
+    }
+  }
+  report(dname, n, "erase", &tm, n, rot < 0 ? -1 : total_rotations(t) - rot);
+
+  delete_rbtree(t);
+  (void)sink;
+}
+
+int main(int argc, char *argv[])
+{
+  size_t max_n = 100000000, min_n = 1000;
+  int only = -1, pooled = 0, opt;
+
+  while ((opt = getopt(argc, argv, "n:m:d:ps:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'n':
+      max_n = (size_t)strtod(optarg, NULL);
+      break;
+    case 'm':
+      min_n = (size_t)strtod(optarg, NULL);
+      break;
+    case 'd':
+      for (int d = 0; d < DIST_COUNT; d++)
+      {
+        if (strcmp(optarg, dist_name[d]) == 0)
+        {
+          only = d;
+        }
+      }
+      break;
+    case 'p':
+      pooled = 1;
+      break;
+    case 's':
+      rng_state = strtoull(optarg, NULL, 10) | 1;
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-n max] [-m min] [-d random|sorted|reverse|dups|all] [-p] [-s seed]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (min_n == 0)
+  {
+    min_n = 1;
+  }
+
+  key_t *keys = malloc(max_n * sizeof(key_t));
+  key_t *out = malloc(max_n * sizeof(key_t));
+  size_t *order = malloc(max_n * sizeof(size_t));
+  uint64_t *samples = malloc((SAMPLE_MAX + 1) * sizeof(uint64_t));
+  if (keys == NULL || out == NULL || order == NULL || samples == NULL)
+  {
+    fprintf(stderr, "out of memory for n=%zu\n", max_n);
+    return 1;
+  }
+
+  printf("node_t=%zu bytes%s\n", sizeof(node_t), pooled ? ", pooled" : "");
+  printf("%-8s %10s %-10s %9s %7s %7s %7s %7s", "dist", "n", "op", "ns/op", "p50", "p90", "p99",
+         "p99.9");
+#ifdef RBTREE_STATS
+  printf(" %11s", "rotations");
+#endif
+  printf("\n");
+
+  for (int d = 0; d < DIST_COUNT; d++)
+  {
+    if (only >= 0 && d != only)
+    {
+      continue;
+    }
+    for (size_t n = min_n; n <= max_n; n *= 10)
+    {
+      bench_one(n, (dist_t)d, pooled, keys, order, out, samples);
+    }
+  }
+
+  free(samples);
+  free(order);
+  free(out);
+  free(keys);
+  return 0;
+}
@@ -0,0 +1,384 @@
+#include <rbtree.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// insert / erase / find 를 무작위로 섞어 오래 돌리는 스트레스 드라이버
+// rbtree.h 의 기본 API 와 rbtree_validate 만 쓰므로 bench-rbtree 처럼 다른 엔진에도 그대로 빌드됨
+//
+// 사용법: ./stress-rbtree [-n 연산수] [-k 키범위] [-v 검사간격] [-p] [-s seed] [-b 기준파일] [-t 비율%] [-a 절대%]
+//   - 키마다 들어간 개수를 따로 세어 두고(모델) 모든 find / erase 결과를 모델과 비교
+//   - 검사 간격마다 rbtree_validate, to_array, min / max 를 모델과 비교 (-v 1 이면 연산마다 검사)
+//   - 트리가 커졌다 작아졌다 하도록 n/8 연산마다 insert 위주와 erase 위주 구간을 번갈아 둠
+//   - 연산 종류마다 트리 호출 시간만 재서 ns/op 와 p99 를 출력
+//   - -b 파일이 없으면 ns/op 를 기록하고, 있으면 기준과 비교해서 느려진 연산이 있으면 실패
+//     기계 상태에 따라 전체가 함께 흔들리는 것을 걸러 내려고 insert / erase 는 같은 실행의 find 에 대한 비율로
+//     비교하고(-t, 기본 20%), 절대 시간은 크게 느려졌을 때만 잡음(-a, 기본 100%)
+//     rb_delete_fixup 이나 할당자가 느려지면 find 는 그대로이므로 erase / insert 비율이 올라감
+//   - -DRBTREE_STATS 로 빌드하면 insert 한 번에 회전 2번, erase 한 번에 3번을 넘는지도 확인
+// 어긋나면 seed 와 몇 번째 연산인지 출력하고 1, 기준을 넘으면 3, 잘못된 옵션 / 기준 파일이면 2 로 종료
+
+#define SAMPLE_MAX 100000
+
+// 삽입 / 삭제 한 번에 허용하는 최대 회전 수 (CLRS 레드-블랙 트리의 상한)
+#define MAX_INSERT_ROTATIONS 2
+#define MAX_ERASE_ROTATIONS 3
+
+typedef enum
+{
+  OP_INSERT,
+  OP_ERASE,
+  OP_FIND,
+  OP_COUNT
+} op_t;
+
+static const char *op_name[OP_COUNT] = {"insert", "erase", "find"};
+
+typedef struct
+{
+  uint64_t total;    // 트리 호출에 쓴 시간의 합 (ns)
+  size_t count;      // 연산 수
+  uint64_t *samples; // count 개 중 일부의 개별 지연
+  size_t nsamples;
+} op_timer;
+
+static uint64_t rng_state = 88172645463325252ull;
+static unsigned long long seed = 0;
+static size_t op_index = 0;
+
+// xorshift64: 같은 seed 면 같은 연산 순서
+static uint64_t rng_next(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return rng_state;
+}
+
+static inline uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void fail(const char *what)
+{
+  fprintf(stderr, "stress: seed %llu, op %zu: %s\n", seed, op_index, what);
+  exit(1);
+}
+
+static void record(op_timer *tm, const uint64_t ns, const size_t every)
+{
+  tm->total += ns;
+  if (tm->count % every == 0 && tm->nsamples < SAMPLE_MAX)
+  {
+    tm->samples[tm->nsamples++] = ns;
+  }
+  tm->count++;
+}
+
+#ifdef RBTREE_STATS
+static size_t rotations(const rbtree *t)
+{
+  rbtree_stats s;
+  rbtree_get_stats(t, &s);
+  return s.left_rotations + s.right_rotations;
+}
+#define CHECK_ROTATIONS(t, before, limit, what) \
+  do                                            \
+  {                                             \
+    if (rotations(t) - (before) > (limit))      \
+    {                                           \
+      fail(what);                               \
+    }                                           \
+  } while (0)
+#else
+#define rotations(t) ((size_t)0)
+#define CHECK_ROTATIONS(t, before, limit, what) ((void)(before))
+#endif
+
+// 트리 전체를 모델과 비교 (O(n))
+static void check_tree(const rbtree *t, const uint32_t *counts, const size_t range, const size_t size,
+                       key_t *buf)
+{
+  if (rbtree_validate(t) < 0)
+  {
+    fail("rbtree_validate");
+  }
+  if ((size_t)rbtree_to_array(t, buf, size + 1) != size)
+  {
+    fail("to_array size");
+  }
+  size_t i = 0;
+  for (size_t key = 0; key < range; key++)
+  {
+    for (uint32_t c = 0; c < counts[key]; c++)
+    {
+      if (buf[i++] != (key_t)key)
+      {
+        fail("to_array order");
+      }
+    }
+  }
+  node_t *min = rbtree_min(t);
+  node_t *max = rbtree_max(t);
+  if (size == 0)
+  {
+    if (min != t->nil || max != t->nil)
+    {
+      fail("min / max of an empty tree");
+    }
+  }
+  else if (min == t->nil || max == t->nil || min->key != buf[0] || max->key != buf[size - 1])
+  {
+    fail("min / max");
+  }
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+  const uint64_t x = *(const uint64_t *)a;
+  const uint64_t y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+// 기준 파일: 첫 줄은 옵션, 이어서 연산마다 "이름 ns/op"
+// 없으면 기록하고 0, 있으면 비교해서 허용 범위를 넘은 연산 수 반환 (옵션이 다르거나 읽을 수 없으면 -1)
+// ratio_tol: find 에 대한 비율의 허용 증가율(%), abs_tol: 절대 시간의 허용 증가율(%)
+static int check_baseline(const char *path, const char *params, const double *ns, const double ratio_tol,
+                          const double abs_tol)
+{
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL)
+  {
+    fp = fopen(path, "w");
+    if (fp == NULL)
+    {
+      return -1;
+    }
+    fprintf(fp, "%s\n", params);
+    for (int op = 0; op < OP_COUNT; op++)
+    {
+      fprintf(fp, "%s %.1f\n", op_name[op], ns[op]);
+    }
+    fclose(fp);
+    printf("baseline recorded in %s\n", path);
+    return 0;
+  }
+
+  char line[256];
+  int slow = 0, seen = 0;
+  if (fgets(line, sizeof(line), fp) == NULL || strncmp(line, params, strlen(params)) != 0)
+  {
+    fprintf(stderr, "stress: %s was recorded with other options\n", path);
+    fclose(fp);
+    return -1;
+  }
+  char name[32];
+  double base[OP_COUNT];
+  double v;
+  while (fscanf(fp, "%31s %lf", name, &v) == 2)
+  {
+    for (int op = 0; op < OP_COUNT; op++)
+    {
+      if (strcmp(name, op_name[op]) == 0 && v > 0)
+      {
+        base[op] = v;
+        seen |= 1 << op;
+      }
+    }
+  }
+  fclose(fp);
+  if (seen != (1 << OP_COUNT) - 1 || ns[OP_FIND] <= 0)
+  {
+    fprintf(stderr, "stress: %s is not a baseline file\n", path);
+    return -1;
+  }
+
+  printf("%-8s %9s %9s %7s %7s\n", "op", "ns/op", "baseline", "/find", "base");
+  for (int op = 0; op < OP_COUNT; op++)
+  {
+    const double ratio = ns[op] / ns[OP_FIND];
+    const double base_ratio = base[op] / base[OP_FIND];
+    const int abs_slow = ns[op] > base[op] * (1.0 + abs_tol / 100.0);
+    const int ratio_slow = op != OP_FIND && ratio > base_ratio * (1.0 + ratio_tol / 100.0);
+    printf("%-8s %9.1f %9.1f %7.2f %7.2f %s\n", op_name[op], ns[op], base[op], ratio, base_ratio,
+           abs_slow || ratio_slow ? "SLOW" : "ok");
+    slow += abs_slow || ratio_slow;
+  }
+  return slow;
+}
+
+int main(int argc, char *argv[])
+{
+  size_t ops = 2000000, range = 1u << 16, every = 10000;
+  int pooled = 0, opt;
+  const char *baseline = NULL;
+  double ratio_tol = 20.0, abs_tol = 100.0;
+
+  while ((opt = getopt(argc, argv, "n:k:v:ps:b:t:a:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'n':
+      ops = (size_t)strtod(optarg, NULL);
+      break;
+    case 'k':
+      range = (size_t)strtod(optarg, NULL);
+      break;
+    case 'v':
+      every = (size_t)strtod(optarg, NULL);
+      break;
+    case 'p':
+      pooled = 1;
+      break;
+    case 's':
+      seed = strtoull(optarg, NULL, 10);
+      break;
+    case 'b':
+      baseline = optarg;
+      break;
+    case 't':
+      ratio_tol = strtod(optarg, NULL);
+      break;
+    case 'a':
+      abs_tol = strtod(optarg, NULL);
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-n ops] [-k key range] [-v check every] [-p] [-s seed] [-b baseline] [-t ratio%%] [-a abs%%]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  rng_state += seed; // seed 0 은 기본 상태
+  if (range == 0 || range > (size_t)1 << 30 || every == 0)
+  {
+    fprintf(stderr, "stress: key range must be in 1..2^30 and check interval at least 1\n");
+    return 2;
+  }
+
+  // 트리에 들어가는 키는 insert 수를 넘지 않음
+  uint32_t *counts = calloc(range, sizeof(uint32_t));
+  key_t *buf = malloc((ops + 1) * sizeof(key_t));
+  op_timer timers[OP_COUNT];
+  memset(timers, 0, sizeof(timers));
+  for (int op = 0; op < OP_COUNT; op++)
+  {
+    timers[op].samples = malloc(SAMPLE_MAX * sizeof(uint64_t));
+    if (timers[op].samples == NULL)
+    {
+      return 1;
+    }
+  }
+  rbtree *t = pooled ? new_rbtree_with_pool(range) : new_rbtree();
+  if (counts == NULL || buf == NULL || t == NULL)
+  {
+    fprintf(stderr, "stress: out of memory\n");
+    return 1;
+  }
+
+  printf("seed %llu, %zu ops, keys < %zu, check every %zu%s\n", seed, ops, range, every,
+         pooled ? ", pool" : "");
+  const size_t sample_every = ops / SAMPLE_MAX + 1;
+  const size_t phase = ops / 8 + 1;
+  size_t size = 0;
+  for (op_index = 0; op_index < ops; op_index++)
+  {
+    // insert 위주(60/25/15)와 erase 위주(25/60/15) 구간을 번갈아 둠
+    const int growing = (op_index / phase) % 2 == 0;
+    const unsigned r = rng_next() % 100;
+    const op_t op = r < (growing ? 60u : 25u) ? OP_INSERT : r < 85 ? OP_ERASE : OP_FIND;
+    const key_t key = (key_t)(rng_next() % range);
+    const size_t before = rotations(t);
+    uint64_t start = now_ns();
+    if (op == OP_INSERT)
+    {
+      node_t *p = rbtree_insert(t, key);
+      record(&timers[op], now_ns() - start, sample_every);
+      if (p == NULL || p->key != key)
+      {
+        fail("insert");
+      }
+      CHECK_ROTATIONS(t, before, MAX_INSERT_ROTATIONS, "too many rotations in insert");
+      counts[key]++;
+      size++;
+    }
+    else
+    {
+      node_t *p = rbtree_find(t, key);
+      const int erased = op == OP_ERASE && p != NULL ? rbtree_erase(t, p) : 0;
+      record(&timers[op], now_ns() - start, sample_every);
+      if ((counts[key] > 0) != (p != NULL) || erased != 0)
+      {
+        fail(op == OP_ERASE ? "erase" : "find");
+      }
+      if (op == OP_ERASE && p != NULL)
+      {
+        CHECK_ROTATIONS(t, before, MAX_ERASE_ROTATIONS, "too many rotations in erase");
+        counts[key]--;
+        size--;
+      }
+    }
+    if ((op_index + 1) % every == 0)
+    {
+      check_tree(t, counts, range, size, buf);
+    }
+  }
+  check_tree(t, counts, range, size, buf);
+
+  // 다 지우는 동안에도 검사
+  for (size_t key = 0; key < range; key++)
+  {
+    while (counts[key] > 0)
+    {
+      node_t *p = rbtree_find(t, (key_t)key);
+      if (p == NULL || rbtree_erase(t, p) != 0)
+      {
+        fail("erase while draining");
+      }
+      counts[key]--;
+      size--;
+    }
+    if (key % (range / 16 + 1) == 0)
+    {
+      check_tree(t, counts, range, size, buf);
+    }
+  }
+  check_tree(t, counts, range, 0, buf);
+  delete_rbtree(t);
+
+  printf("%-8s %10s %9s %7s\n", "op", "count", "ns/op", "p99");
+  double ns[OP_COUNT];
+  for (int op = 0; op < OP_COUNT; op++)
+  {
+    op_timer *tm = &timers[op];
+    ns[op] = tm->count ? (double)tm->total / tm->count : 0.0;
+    qsort(tm->samples, tm->nsamples, sizeof(uint64_t), cmp_u64);
+    const uint64_t p99 = tm->nsamples ? tm->samples[(size_t)(0.99 * (tm->nsamples - 1))] : 0;
+    printf("%-8s %10zu %9.1f %7llu\n", op_name[op], tm->count, ns[op], (unsigned long long)p99);
+    free(tm->samples);
+  }
+  free(buf);
+  free(counts);
+
+  if (baseline != NULL)
+  {
+    char params[128];
+    snprintf(params, sizeof(params), "stress %llu %zu %zu %zu %d", seed, ops, range, every, pooled);
+    const int slow = check_baseline(baseline, params, ns, ratio_tol, abs_tol);
+    if (slow < 0)
+    {
+      return 2;
+    }
+    if (slow > 0)
+    {
+      fprintf(stderr, "stress: %d op(s) slower than %s\n", slow, baseline);
+      return 3;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,428 @@
+#include "rbtree.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// 노드는 캐시 라인 경계에서 시작 (keys 가 정렬되어 있어야 aligned SIMD load 가능)
+#define BTREE_CACHE_LINE 64
+
+_Static_assert(BTREE_MAX_KEYS == 32, "노드 안 비교 마스크는 32비트");
+
+// --- 노드 안 탐색 ---
+
+// keys[i] < key 인 칸의 비트 마스크 (32칸 전부 비교, 사용하지 않는 칸은 호출한 쪽에서 가림)
+static inline uint32_t lt_mask(const key_t *keys, const key_t key) {
+  uint32_t m = 0;
+#if defined(__AVX2__)
+  const __m256i k = _mm256_set1_epi32(key);
+  for (int i = 0; i < BTREE_MAX_KEYS; i += 8) {
+    __m256i v = _mm256_load_si256((const __m256i *)(keys + i));
+    m |= (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, v))) << i;
+  }
+#elif defined(__SSE2__)
+  const __m128i k = _mm_set1_epi32(key);
+  for (int i = 0; i < BTREE_MAX_KEYS; i += 4) {
+    __m128i v = _mm_load_si128((const __m128i *)(keys + i));
+    m |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(k, v))) << i;
+  }
+#else
+  for (int i = 0; i < BTREE_MAX_KEYS; i++) {
+    m |= (uint32_t)(keys[i] < key) << i;
+  }
+#endif
+  return m;
+}
+
+// keys[i] > key 인 칸의 비트 마스크
+static inline uint32_t gt_mask(const key_t *keys, const key_t key) {
+  uint32_t m = 0;
+#if defined(__AVX2__)
+  const __m256i k = _mm256_set1_epi32(key);
+  for (int i = 0; i < BTREE_MAX_KEYS; i += 8) {
+    __m256i v = _mm256_load_si256((const __m256i *)(keys + i));
+    m |= (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, k))) << i;
+  }
+#elif defined(__SSE2__)
+  const __m128i k = _mm_set1_epi32(key);
+  for (int i = 0; i < BTREE_MAX_KEYS; i += 4) {
+    __m128i v = _mm_load_si128((const __m128i *)(keys + i));
+    m |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, k))) << i;
+  }
+#else
+  for (int i = 0; i < BTREE_MAX_KEYS; i++) {
+    m |= (uint32_t)(keys[i] > key) << i;
+  }
+#endif
+  return m;
+}
+
+static inline uint32_t used_mask(const btree_node *x) {
+  return x->n == BTREE_MAX_KEYS ? UINT32_MAX : (1u << x->n) - 1;
+}
+
+// key 보다 작은 키 수 = key 이상인 첫 칸의 위치 (키가 정렬돼 있으므로 개수가 곧 위치)
+static inline unsigned count_less(const btree_node *x, const key_t key) {
+  return (unsigned)__builtin_popcount(lt_mask(x->keys, key) & used_mask(x));
+}
+
+// key 이하인 키 수 = key 보다 큰 첫 칸의 위치
+static inline unsigned count_less_equal(const btree_node *x, const key_t key) {
+  return x->n - (unsigned)__builtin_popcount(gt_mask(x->keys, key) & used_mask(x));
+}
+
+// --- 노드 할당 ---
+
+static btree_node *alloc_node(const int leaf) {
+  size_t bytes = offsetof(btree_node, children);
+  if (!leaf) {
+    bytes += (BTREE_MAX_KEYS + 1) * sizeof(btree_node *);
+  }
+  bytes = (bytes + BTREE_CACHE_LINE - 1) & ~(size_t)(BTREE_CACHE_LINE - 1);
+  btree_node *x = aligned_alloc(BTREE_CACHE_LINE, bytes);
+  if (x == NULL) {
+    return NULL;
+  }
+  // 쓰지 않는 칸도 SIMD 로 읽으므로 0으로 채워 둠
+  memset(x, 0, bytes);
+  x->leaf = leaf;
+  return x;
+}
+
+static void free_node(btree_node *x) {
+  if (!x->leaf) {
+    for (uint32_t i = 0; i <= x->n; i++) {
+      free_node(x->children[i]);
+    }
+  }
+  free(x);
+}
+
+rbtree *new_rbtree(void) {
+  rbtree *t = calloc(1, sizeof(rbtree));
+  if (t == NULL) {
+    return NULL;
+  }
+  t->nil = calloc(1, sizeof(node_t));
+  t->root = alloc_node(1);
+  if (t->nil == NULL || t->root == NULL) {
+    free(t->nil);
+    free(t->root);
+    free(t);
+    return NULL;
+  }
+  return t;
+}
+
+rbtree *new_rbtree_with_pool(size_t initial_capacity) {
+  (void)initial_capacity;
+  return new_rbtree();
+}
+
+void delete_rbtree(rbtree *t) {
+  if (t == NULL) {
+    return;
+  }
+  free_node(t->root);
+  free(t->nil);
+  free(t);
+}
+
+// --- 삽입 ---
+
+// 꽉 찬 x->children[c] 를 반으로 나누고 구분 키를 x 의 c 번째 칸에 넣음 (x 는 꽉 차 있지 않음)
+static int split_child(btree_node *x, const unsigned c) {
+  btree_node *y = x->children[c];
+  btree_node *z = alloc_node(y->leaf);
+  if (z == NULL) {
+    return -1;
+  }
+
+  key_t sep;
+  if (y->leaf) {
+    // leaf: 뒤쪽 절반을 z 로 옮기고 z 의 첫 키를 구분 키로 복사
+    z->n = BTREE_MAX_KEYS - BTREE_MIN_KEYS;
+    memcpy(z->keys, y->keys + BTREE_MIN_KEYS, z->n * sizeof(key_t));
+    y->n = BTREE_MIN_KEYS;
+    sep = z->keys[0];
+    z->next = y->next;
+    y->next = z;
+  } else {
+    // 내부 노드: 가운데 키는 위로 올라가고 그 뒤의 키와 자식이 z 로 옮겨감
+    sep = y->keys[BTREE_MIN_KEYS];
+    z->n = BTREE_MAX_KEYS - BTREE_MIN_KEYS - 1;
+    memcpy(z->keys, y->keys + BTREE_MIN_KEYS + 1, z->n * sizeof(key_t));
+    memcpy(z->children, y->children + BTREE_MIN_KEYS + 1, (z->n + 1) * sizeof(btree_node *));
+    y->n = BTREE_MIN_KEYS;
+  }
+
+  memmove(x->keys + c + 1, x->keys + c, (x->n - c) * sizeof(key_t));
+  memmove(x->children + c + 2, x->children + c + 1, (x->n - c) * sizeof(btree_node *));
+  x->keys[c] = sep;
+  x->children[c + 1] = z;
+  x->n++;
+  return 0;
+}
+
+node_t *rbtree_insert(rbtree *t, const key_t key) {
+  if (t == NULL) {
+    return NULL;
+  }
+
+  // 내려가는 길의 꽉 찬 노드를 미리 나누므로 한 번의 하향 탐색으로 끝나고,
+  // 할당에 실패해도 그때까지 나눈 노드로 이미 올바른 트리가 유지됨
+  if (t->root->n == BTREE_MAX_KEYS) {
+    btree_node *r = alloc_node(0);
+    if (r == NULL) {
+      return NULL;
+    }
+    r->children[0] = t->root;
+    if (split_child(r, 0) != 0) {
+      free(r);
+      return NULL;
+    }
+    t->root = r;
+  }
+
+  btree_node *x = t->root;
+  while (!x->leaf) {
+    // 같은 키는 오른쪽으로 보내 구분 키 조건(왼쪽 <= 구분 키 <= 오른쪽)을 유지
+    unsigned c = count_less_equal(x, key);
+    if (x->children[c]->n == BTREE_MAX_KEYS) {
+      if (split_child(x, c) != 0) {
+        return NULL;
+      }
+      if (key >= x->keys[c]) {
+        c++;
+      }
+    }
+    x = x->children[c];
+  }
+
+  unsigned pos = count_less_equal(x, key);
+  memmove(x->keys + pos + 1, x->keys + pos, (x->n - pos) * sizeof(key_t));
+  x->keys[pos] = key;
+  x->n++;
+  t->size++;
+  return (node_t *)&x->keys[pos];
+}
+
+// --- 탐색 ---
+
+// key 이상인 첫 키가 있는 leaf 와 위치 (없으면 NULL)
+static btree_node *lower_leaf(const rbtree *t, const key_t key, unsigned *pos) {
+  btree_node *x = t->root;
+  while (!x->leaf) {
+    x = x->children[count_less(x, key)];
+  }
+  unsigned i = count_less(x, key);
+  if (i == x->n) {
+    // 구분 키와 같은 키는 오른쪽 leaf 의 맨 앞에 있을 수 있음
+    x = x->next;
+    i = 0;
+  }
+  *pos = i;
+  return x;
+}
+
+node_t *rbtree_find(const rbtree *t, const key_t key) {
+  unsigned i;
+  btree_node *x = lower_leaf(t, key, &i);
+  if (x == NULL || x->keys[i] != key) {
+    return NULL;
+  }
+  return (node_t *)&x->keys[i];
+}
+
+node_t *rbtree_min(const rbtree *t) {
+  if (t->size == 0) {
+    return t->nil;
+  }
+  btree_node *x = t->root;
+  while (!x->leaf) {
+    x = x->children[0];
+  }
+  return (node_t *)&x->keys[0];
+}
+
+node_t *rbtree_max(const rbtree *t) {
+  if (t->size == 0) {
+    return t->nil;
+  }
+  btree_node *x = t->root;
+  while (!x->leaf) {
+    x = x->children[x->n];
+  }
+  return (node_t *)&x->keys[x->n - 1];
+}
+
+int rbtree_to_array(const rbtree *t, key_t *arr, const size_t n) {
+  btree_node *x = t->root;
+  while (!x->leaf) {
+    x = x->children[0];
+  }
+
+  // leaf 를 next 로 따라가며 키 배열을 통째로 복사
+  size_t copied = 0;
+  for (; x != NULL && copied < n; x = x->next) {
+    size_t take = x->n < n - copied ? x->n : n - copied;
+    memcpy(arr + copied, x->keys, take * sizeof(key_t));
+    copied += take;
+  }
+  return (int)copied;
+}
+
+// --- 삭제 ---
+
+// x->children[i] 와 x->children[i + 1] 을 합치고 그 사이 구분 키를 지움
+static void merge_children(btree_node *x, const unsigned i) {
+  btree_node *l = x->children[i];
+  btree_node *r = x->children[i + 1];
+  if (l->leaf) {
+    memcpy(l->keys + l->n, r->keys, r->n * sizeof(key_t));
+    l->n += r->n;
+    l->next = r->next;
+  } else {
+    l->keys[l->n] = x->keys[i];
+    memcpy(l->keys + l->n + 1, r->keys, r->n * sizeof(key_t));
+    memcpy(l->children + l->n + 1, r->children, (r->n + 1) * sizeof(btree_node *));
+    l->n += r->n + 1;
+  }
+  free(r);
+
+  memmove(x->keys + i, x->keys + i + 1, (x->n - i - 1) * sizeof(key_t));
+  memmove(x->children + i + 1, x->children + i + 2, (x->n - i - 1) * sizeof(btree_node *));
+  x->n--;
+}
+
+// 키가 모자라게 된 x->children[c] 를 형제에게서 하나 빌리거나 형제와 합쳐서 채움
+static void rebalance(btree_node *x, const unsigned c) {
+  btree_node *y = x->children[c];
+
+  if (c > 0 && x->children[c - 1]->n > BTREE_MIN_KEYS) {
+    // 왼쪽 형제의 마지막 키를 y 의 맨 앞으로
+    btree_node *l = x->children[c - 1];
+    memmove(y->keys + 1, y->keys, y->n * sizeof(key_t));
+    if (y->leaf) {
+      y->keys[0] = l->keys[l->n - 1];
+      x->keys[c - 1] = y->keys[0];
+    } else {
+      memmove(y->children + 1, y->children, (y->n + 1) * sizeof(btree_node *));
+      y->keys[0] = x->keys[c - 1];
+      y->children[0] = l->children[l->n];
+      x->keys[c - 1] = l->keys[l->n - 1];
+    }
+    y->n++;
+    l->n--;
+  } else if (c < x->n && x->children[c + 1]->n > BTREE_MIN_KEYS) {
+    // 오른쪽 형제의 첫 키를 y 의 맨 뒤로
+    btree_node *r = x->children[c + 1];
+    if (y->leaf) {
+      y->keys[y->n] = r->keys[0];
+      memmove(r->keys, r->keys + 1, (r->n - 1) * sizeof(key_t));
+      x->keys[c] = r->keys[0];
+    } else {
+      y->keys[y->n] = x->keys[c];
+      y->children[y->n + 1] = r->children[0];
+      x->keys[c] = r->keys[0];
+      memmove(r->keys, r->keys + 1, (r->n - 1) * sizeof(key_t));
+      memmove(r->children, r->children + 1, r->n * sizeof(btree_node *));
+    }
+    y->n++;
+    r->n--;
+  } else {
+    // 형제도 최소 크기이므로 합쳐도 BTREE_MAX_KEYS 를 넘지 않음
+    merge_children(x, c > 0 ? c - 1 : c);
+  }
+}
+
+// x 의 서브트리에서 key 하나를 지우면 1, 없으면 0
+static int erase_rec(btree_node *x, const key_t key) {
+  if (x->leaf) {
+    unsigned i = count_less(x, key);
+    if (i == x->n || x->keys[i] != key) {
+      return 0;
+    }
+    memmove(x->keys + i, x->keys + i + 1, (x->n - i - 1) * sizeof(key_t));
+    x->n--;
+    return 1;
+  }
+
+  // key 와 같은 구분 키가 있으면 그 양쪽 자식 모두에 key 가 있을 수 있으므로 차례로 시도
+  const unsigned lo = count_less(x, key), hi = count_less_equal(x, key);
+  for (unsigned c = lo; c <= hi; c++) {
+    if (erase_rec(x->children[c], key)) {
+      if (x->children[c]->n < BTREE_MIN_KEYS) {
+        rebalance(x, c);
+      }
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int rbtree_erase(rbtree *t, node_t *p) {
+  if (p == NULL || p == t->nil) {
+    return -1;
+  }
+  if (!erase_rec(t->root, p->key)) {
+    return -1;
+  }
+  t->size--;
+
+  // 루트의 마지막 구분 키가 내려가면 높이가 하나 줄어듦
+  if (!t->root->leaf && t->root->n == 0) {
+    btree_node *old = t->root;
+    t->root = old->children[0];
+    free(old);
+  }
+  return 0;
+}
+
+// rbtree_validate 가 넘으면 고리로 보는 깊이 (키 2^64 개도 log_17 으로 16 단계 안쪽)
+#define BTREE_MAX_DEPTH 64
+
+// x 서브트리의 leaf 깊이, 어긋나면 -1 (lo / hi 는 부모가 정한 키 범위, NULL 이면 제한 없음)
+static int validate_node(const btree_node *x, const int is_root, const key_t *lo, const key_t *hi,
+                         const btree_node **prev_leaf, size_t *count, const int depth) {
+  if (depth > BTREE_MAX_DEPTH || x->n > BTREE_MAX_KEYS || (!is_root && x->n < BTREE_MIN_KEYS - 1)) {
+    return -1;
+  }
+  for (uint32_t i = 0; i < x->n; i++) {
+    if ((i > 0 && x->keys[i - 1] > x->keys[i]) || (lo && x->keys[i] < *lo) || (hi && x->keys[i] > *hi)) {
+      return -1;
+    }
+  }
+  if (x->leaf) {
+    // leaf 는 왼쪽부터 차례로 이어져 있어야 함
+    if (*prev_leaf != NULL && (*prev_leaf)->next != x) {
+      return -1;
+    }
+    *prev_leaf = x;
+    *count += x->n;
+    return 0;
+  }
+  int leaf_depth = -1;
+  for (uint32_t i = 0; i <= x->n; i++) {
+    const key_t *clo = i > 0 ? &x->keys[i - 1] : lo;
+    const key_t *chi = i < x->n ? &x->keys[i] : hi;
+    const int d = validate_node(x->children[i], 0, clo, chi, prev_leaf, count, depth + 1);
+    if (d < 0 || (leaf_depth >= 0 && d != leaf_depth)) {
+      return -1;
+    }
+    leaf_depth = d;
+  }
+  return leaf_depth + 1;
+}
+
+int rbtree_validate(const rbtree *t) {
+  if (t == NULL || t->root == NULL) {
+    return -1;
+  }
+  const btree_node *prev = NULL;
+  size_t count = 0;
+  const int d = validate_node(t->root, 1, NULL, NULL, &prev, &count, 0);
+  return d >= 0 && prev->next == NULL && count == t->size ? d : -1;
+}
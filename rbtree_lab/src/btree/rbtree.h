@@ -0,0 +1,78 @@
+#ifndef _RBTREE_BTREE_H_
+#define _RBTREE_BTREE_H_
+
+// src/rbtree.h 와 같은 API를 제공하는 B+ 트리 기반 ordered multiset
+// 노드 하나에 키를 최대 32개(128바이트, 캐시 라인 2개) 담아 탐색 깊이를 log_17 n 수준으로 줄이고,
+// 노드 안에서는 SIMD(SSE2, -mavx2 로 빌드하면 AVX2)로 모든 키를 한 번에 비교함
+// -I src/btree 로 include 경로를 바꾸고 src/btree/rbtree.o 를 링크하면 그대로 교체됨
+//
+// 키는 leaf 에만 있고, leaf 끼리는 next 로 이어져 있어 to_array 는 leaf 배열을 차례로 복사함
+// rbtree_find / min / max / insert 가 돌려주는 node_t * 는 leaf 안의 키 칸을 가리키며,
+// 다음 insert / erase 전까지만 유효함 (노드가 나뉘거나 합쳐지면 키가 옮겨지므로)
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 키 타입 정의 (정수형)
+typedef int key_t;
+
+// 노드 하나에 담는 최대 키 수 (SIMD 비교 결과를 32비트 마스크 하나로 다루므로 32 고정)
+#define BTREE_MAX_KEYS 32
+
+// 루트가 아닌 노드가 삭제 후 유지해야 하는 최소 키 수
+#define BTREE_MIN_KEYS (BTREE_MAX_KEYS / 2)
+
+// 사용자에게 돌려주는 키 칸 (leaf 의 keys[i] 를 그대로 가리킴)
+typedef struct {
+  key_t key;
+} node_t;
+
+// B+ 트리 노드 (캐시 라인 경계에 할당)
+typedef struct btree_node btree_node;
+struct btree_node {
+  key_t keys[BTREE_MAX_KEYS];  // 오름차순 키 (내부 노드에서는 자식 사이의 구분 키)
+  uint32_t n;                  // 사용 중인 키 수
+  uint32_t leaf;               // leaf 면 1
+  btree_node *next;            // leaf: 다음 leaf (마지막이면 NULL)
+  btree_node *children[];      // 내부 노드: n + 1 개의 자식 (leaf 에는 없음)
+};
+
+// 트리 전체를 나타내는 구조체
+// 내부 노드의 keys[i] 는 children[i] 의 모든 키 이상, children[i + 1] 의 모든 키 이하
+typedef struct {
+  btree_node *root; // 항상 존재 (빈 트리는 키가 없는 leaf 하나)
+  node_t *nil;      // rbtree_min / rbtree_max 가 빈 트리에서 돌려주는 센티넬
+  size_t size;      // 저장된 키 개수
+} rbtree;
+
+// 새로운 트리를 생성하고 초기화하여 반환
+rbtree *new_rbtree(void);
+
+// src/rbtree.h 와 맞춘 생성 함수 (노드를 미리 잡아 두지 않으므로 new_rbtree 와 동일)
+rbtree *new_rbtree_with_pool(size_t initial_capacity);
+
+// 모든 노드와 트리 구조체를 해제
+void delete_rbtree(rbtree *);
+
+// 키 값을 트리에 삽입하고 삽입된 키 칸을 반환 (메모리 부족 시 NULL)
+node_t *rbtree_insert(rbtree *, const key_t);
+
+// 특정 키 값을 가진 칸을 검색하여 반환, 찾지 못하면 NULL 반환
+node_t *rbtree_find(const rbtree *, const key_t);
+
+// 가장 작은 / 큰 키의 칸을 반환, 트리가 비어 있으면 nil을 반환
+node_t *rbtree_min(const rbtree *);
+node_t *rbtree_max(const rbtree *);
+
+// p->key 와 같은 키 하나를 삭제 (multiset 이므로 같은 키끼리는 구분하지 않음)
+// 성공 시 0, p가 NULL / nil 이거나 키가 없으면 -1
+int rbtree_erase(rbtree *, node_t *);
+
+// 저장된 키들을 오름차순으로 배열에 복사, 복사된 요소의 개수 반환
+int rbtree_to_array(const rbtree *, key_t *, const size_t);
+
+// 노드 안 키 순서, 구분 키 범위, 노드 채움, 모든 leaf 의 깊이, leaf 연결, 키 개수를 O(n)에 확인
+// 맞으면 leaf 깊이(루트만 있으면 0) / 어긋나면 -1
+int rbtree_validate(const rbtree *);
+
+#endif  // _RBTREE_BTREE_H_
@@ -0,0 +1,471 @@
+#include "rbtree.h"
+#include <stdlib.h>
+
+// 인덱스 0번은 nil 센티넬
+#define NIL 0u
+// 부모 인덱스로 쓸 수 있는 최대 값 (최상위 비트는 색상)
+#define RBTREE_MAX_IDX (RBTREE_COLOR_BIT - 1)
+
+#define NODE(i) rb_node_at(t, (i))
+
+// rbtree_validate 가 고리로 보는 깊이
+#define RBTREE_MAX_HEIGHT 128
+
+static inline void set_parent(node_t *n, node_idx_t p) {
+  n->parent_color = (n->parent_color & RBTREE_COLOR_BIT) | p;
+}
+
+static inline void set_color(node_t *n, color_t c) {
+  if (c == RBTREE_BLACK) {
+    n->parent_color |= RBTREE_COLOR_BIT;
+  } else {
+    n->parent_color &= ~RBTREE_COLOR_BIT;
+  }
+}
+
+// chunk 하나를 추가 (chunk 포인터 배열은 필요할 때 두 배로 늘림)
+static int add_chunk(rbtree *t) {
+  if (t->nchunks == t->chunk_cap) {
+    size_t cap = t->chunk_cap ? t->chunk_cap * 2 : 4;
+    node_t **chunks = (node_t **)realloc(t->chunks, cap * sizeof(node_t *));
+    if (chunks == NULL) {
+      return -1;
+    }
+    t->chunks = chunks;
+    t->chunk_cap = cap;
+  }
+  node_t *chunk = (node_t *)malloc(RBTREE_CHUNK_SIZE * sizeof(node_t));
+  if (chunk == NULL) {
+    return -1;
+  }
+  t->chunks[t->nchunks++] = chunk;
+  return 0;
+}
+
+rbtree *new_rbtree(void) {
+  rbtree *t = (rbtree *)calloc(1, sizeof(rbtree));
+  if (t == NULL) {
+    return NULL;
+  }
+  if (add_chunk(t) != 0) {
+    free(t->chunks);
+    free(t);
+    return NULL;
+  }
+
+  // 0번 노드를 nil 로 초기화: 항상 BLACK, 자식과 부모는 자기 자신
+  t->nil = NODE(NIL);
+  t->nil->key = 0;
+  t->nil->left = NIL;
+  t->nil->right = NIL;
+  t->nil->parent_color = RBTREE_COLOR_BIT | NIL;
+
+  t->root = NIL;
+  t->free_list = NIL;
+  t->next_idx = 1;
+  return t;
+}
+
+rbtree *new_rbtree_with_pool(size_t initial_capacity) {
+  rbtree *t = new_rbtree();
+  if (t == NULL) {
+    return NULL;
+  }
+  // nil 을 포함하여 initial_capacity + 1 개가 들어갈 만큼 chunk를 미리 할당
+  if (initial_capacity > RBTREE_MAX_IDX) {
+    initial_capacity = RBTREE_MAX_IDX;
+  }
+  while (t->nchunks * (size_t)RBTREE_CHUNK_SIZE < initial_capacity + 1) {
+    if (add_chunk(t) != 0) {
+      delete_rbtree(t);
+      return NULL;
+    }
+  }
+  return t;
+}
+
+void delete_rbtree(rbtree *t) {
+  if (t == NULL) {
+    return;
+  }
+  // 노드는 모두 chunk 안에 있으므로 트리를 순회할 필요 없음
+  for (size_t i = 0; i < t->nchunks; i++) {
+    free(t->chunks[i]);
+  }
+  free(t->chunks);
+  free(t);
+}
+
+// 새 노드 인덱스 할당, 실패 시 NIL 반환
+static node_idx_t alloc_idx(rbtree *t) {
+  if (t->free_list != NIL) {
+    node_idx_t i = t->free_list;
+    t->free_list = NODE(i)->left;
+    return i;
+  }
+  if (t->next_idx > RBTREE_MAX_IDX) {
+    return NIL;
+  }
+  if ((t->next_idx >> RBTREE_CHUNK_SHIFT) == t->nchunks && add_chunk(t) != 0) {
+    return NIL;
+  }
+  return t->next_idx++;
+}
+
+static void free_idx(rbtree *t, node_idx_t i) {
+  NODE(i)->left = t->free_list;
+  t->free_list = i;
+}
+
+// 노드 포인터로부터 인덱스를 구함 (부모의 자식 인덱스나 root 를 이용)
+static node_idx_t idx_of(const rbtree *t, const node_t *n) {
+  node_idx_t p = rb_parent_idx(n);
+  if (p == NIL) {
+    return t->root;
+  }
+  const node_t *pn = NODE(p);
+  return NODE(pn->left) == n ? pn->left : pn->right;
+}
+
+static void left_rotation(rbtree *t, node_idx_t x) {
+  node_t *xn = NODE(x);
+  node_idx_t y = xn->right;
+  node_t *yn = NODE(y);
+
+  xn->right = yn->left;
+  if (yn->left != NIL) {
+    set_parent(NODE(yn->left), x);
+  }
+
+  node_idx_t xp = rb_parent_idx(xn);
+  set_parent(yn, xp);
+  if (xp == NIL) {
+    t->root = y;
+  } else if (x == NODE(xp)->left) {
+    NODE(xp)->left = y;
+  } else {
+    NODE(xp)->right = y;
+  }
+
+  yn->left = x;
+  set_parent(xn, y);
+}
+
+static void right_rotation(rbtree *t, node_idx_t x) {
+  node_t *xn = NODE(x);
+  node_idx_t y = xn->left;
+  node_t *yn = NODE(y);
+
+  xn->left = yn->right;
+  if (yn->right != NIL) {
+    set_parent(NODE(yn->right), x);
+  }
+
+  node_idx_t xp = rb_parent_idx(xn);
+  set_parent(yn, xp);
+  if (xp == NIL) {
+    t->root = y;
+  } else if (x == NODE(xp)->right) {
+    NODE(xp)->right = y;
+  } else {
+    NODE(xp)->left = y;
+  }
+
+  yn->right = x;
+  set_parent(xn, y);
+}
+
+static void insert_fixup(rbtree *t, node_idx_t z) {
+  while (rb_color(NODE(rb_parent_idx(NODE(z)))) == RBTREE_RED) {
+    node_idx_t p = rb_parent_idx(NODE(z));
+    node_idx_t g = rb_parent_idx(NODE(p));
+
+    if (p == NODE(g)->left) {
+      node_idx_t u = NODE(g)->right;
+      if (rb_color(NODE(u)) == RBTREE_RED) {
+        // Case 1: 삼촌도 RED -> 색만 바꾸고 조부모에서 다시 검사
+        set_color(NODE(p), RBTREE_BLACK);
+        set_color(NODE(u), RBTREE_BLACK);
+        set_color(NODE(g), RBTREE_RED);
+        z = g;
+      } else {
+        // Case 2: z가 오른쪽 자식이면 좌회전으로 Case 3 형태로 변환
+        if (z == NODE(p)->right) {
+          z = p;
+          left_rotation(t, z);
+          p = rb_parent_idx(NODE(z));
+          g = rb_parent_idx(NODE(p));
+        }
+        // Case 3: 부모 BLACK, 조부모 RED 후 우회전
+        set_color(NODE(p), RBTREE_BLACK);
+        set_color(NODE(g), RBTREE_RED);
+        right_rotation(t, g);
+      }
+    } else {
+      node_idx_t u = NODE(g)->left;
+      if (rb_color(NODE(u)) == RBTREE_RED) {
+        set_color(NODE(p), RBTREE_BLACK);
+        set_color(NODE(u), RBTREE_BLACK);
+        set_color(NODE(g), RBTREE_RED);
+        z = g;
+      } else {
+        if (z == NODE(p)->left) {
+          z = p;
+          right_rotation(t, z);
+          p = rb_parent_idx(NODE(z));
+          g = rb_parent_idx(NODE(p));
+        }
+        set_color(NODE(p), RBTREE_BLACK);
+        set_color(NODE(g), RBTREE_RED);
+        left_rotation(t, g);
+      }
+    }
+  }
+  set_color(NODE(t->root), RBTREE_BLACK);
+}
+
+node_t *rbtree_insert(rbtree *t, const key_t key) {
+  if (t == NULL) {
+    return NULL;
+  }
+  node_idx_t z = alloc_idx(t);
+  if (z == NIL) {
+    return NULL;
+  }
+
+  // 삽입 위치 탐색 (같은 키는 오른쪽으로)
+  node_idx_t parent = NIL;
+  node_idx_t cur = t->root;
+  while (cur != NIL) {
+    parent = cur;
+    cur = key < NODE(cur)->key ? NODE(cur)->left : NODE(cur)->right;
+  }
+
+  node_t *zn = NODE(z);
+  zn->key = key;
+  zn->left = NIL;
+  zn->right = NIL;
+  zn->parent_color = parent; // 새 노드는 RED (색상 비트 0)
+
+  if (parent == NIL) {
+    t->root = z;
+  } else if (key < NODE(parent)->key) {
+    NODE(parent)->left = z;
+  } else {
+    NODE(parent)->right = z;
+  }
+
+  insert_fixup(t, z);
+  return zn;
+}
+
+node_t *rbtree_find(const rbtree *t, const key_t key) {
+  node_idx_t cur = t->root;
+  while (cur != NIL) {
+    node_t *n = NODE(cur);
+    if (key == n->key) {
+      return n;
+    }
+    cur = key < n->key ? n->left : n->right;
+  }
+  return NULL;
+}
+
+static node_idx_t min_idx(const rbtree *t, node_idx_t i) {
+  while (NODE(i)->left != NIL) {
+    i = NODE(i)->left;
+  }
+  return i;
+}
+
+static node_idx_t max_idx(const rbtree *t, node_idx_t i) {
+  while (NODE(i)->right != NIL) {
+    i = NODE(i)->right;
+  }
+  return i;
+}
+
+node_t *rbtree_min(const rbtree *t) {
+  return NODE(min_idx(t, t->root));
+}
+
+node_t *rbtree_max(const rbtree *t) {
+  return NODE(max_idx(t, t->root));
+}
+
+// u 자리에 v 서브트리를 연결 (v 가 nil 이어도 부모를 기록해 둠)
+static void transplant(rbtree *t, node_idx_t u, node_idx_t v) {
+  node_idx_t up = rb_parent_idx(NODE(u));
+  if (up == NIL) {
+    t->root = v;
+  } else if (u == NODE(up)->left) {
+    NODE(up)->left = v;
+  } else {
+    NODE(up)->right = v;
+  }
+  set_parent(NODE(v), up);
+}
+
+static void delete_fixup(rbtree *t, node_idx_t x) {
+  while (x != t->root && rb_color(NODE(x)) == RBTREE_BLACK) {
+    node_idx_t xp = rb_parent_idx(NODE(x));
+    if (x == NODE(xp)->left) {
+      node_idx_t w = NODE(xp)->right;
+      if (rb_color(NODE(w)) == RBTREE_RED) {
+        set_color(NODE(w), RBTREE_BLACK);
+        set_color(NODE(xp), RBTREE_RED);
+        left_rotation(t, xp);
+        w = NODE(xp)->right;
+      }
+      if (rb_color(NODE(NODE(w)->left)) == RBTREE_BLACK &&
+          rb_color(NODE(NODE(w)->right)) == RBTREE_BLACK) {
+        set_color(NODE(w), RBTREE_RED);
+        x = xp;
+      } else {
+        if (rb_color(NODE(NODE(w)->right)) == RBTREE_BLACK) {
+          set_color(NODE(NODE(w)->left), RBTREE_BLACK);
+          set_color(NODE(w), RBTREE_RED);
+          right_rotation(t, w);
+          w = NODE(xp)->right;
+        }
+        set_color(NODE(w), rb_color(NODE(xp)));
+        set_color(NODE(xp), RBTREE_BLACK);
+        set_color(NODE(NODE(w)->right), RBTREE_BLACK);
+        left_rotation(t, xp);
+        x = t->root;
+      }
+    } else {
+      node_idx_t w = NODE(xp)->left;
+      if (rb_color(NODE(w)) == RBTREE_RED) {
+        set_color(NODE(w), RBTREE_BLACK);
+        set_color(NODE(xp), RBTREE_RED);
+        right_rotation(t, xp);
+        w = NODE(xp)->left;
+      }
+      if (rb_color(NODE(NODE(w)->left)) == RBTREE_BLACK &&
+          rb_color(NODE(NODE(w)->right)) == RBTREE_BLACK) {
+        set_color(NODE(w), RBTREE_RED);
+        x = xp;
+      } else {
+        if (rb_color(NODE(NODE(w)->left)) == RBTREE_BLACK) {
+          set_color(NODE(NODE(w)->right), RBTREE_BLACK);
+          set_color(NODE(w), RBTREE_RED);
+          left_rotation(t, w);
+          w = NODE(xp)->left;
+        }
+        set_color(NODE(w), rb_color(NODE(xp)));
+        set_color(NODE(xp), RBTREE_BLACK);
+        set_color(NODE(NODE(w)->left), RBTREE_BLACK);
+        right_rotation(t, xp);
+        x = t->root;
+      }
+    }
+  }
+  set_color(NODE(x), RBTREE_BLACK);
+}
+
+int rbtree_erase(rbtree *t, node_t *p) {
+  if (t == NULL || p == NULL || p == t->nil) {
+    return -1;
+  }
+  node_idx_t z = idx_of(t, p);
+  node_idx_t x;
+  color_t original_color = rb_color(p);
+
+  if (p->left == NIL) {
+    x = p->right;
+    transplant(t, z, x);
+  } else if (p->right == NIL) {
+    x = p->left;
+    transplant(t, z, x);
+  } else {
+    node_idx_t y = min_idx(t, p->right);
+    node_t *yn = NODE(y);
+    original_color = rb_color(yn);
+    x = yn->right;
+    if (rb_parent_idx(yn) == z) {
+      set_parent(NODE(x), y);
+    } else {
+      transplant(t, y, x);
+      yn->right = p->right;
+      set_parent(NODE(yn->right), y);
+    }
+    transplant(t, z, y);
+    yn->left = p->left;
+    set_parent(NODE(yn->left), y);
+    set_color(yn, rb_color(p));
+  }
+
+  if (original_color == RBTREE_BLACK) {
+    delete_fixup(t, x);
+  }
+
+  free_idx(t, z);
+  return 0;
+}
+
+int rbtree_to_array(const rbtree *t, key_t *arr, const size_t n) {
+  size_t i = 0;
+  if (t->root == NIL) {
+    return 0;
+  }
+  // 부모 인덱스를 따라 올라가는 중위 순회 (스택 없음)
+  node_idx_t cur = min_idx(t, t->root);
+  while (cur != NIL && i < n) {
+    node_t *cn = NODE(cur);
+    arr[i++] = cn->key;
+    if (cn->right != NIL) {
+      cur = min_idx(t, cn->right);
+    } else {
+      node_idx_t p = rb_parent_idx(cn);
+      while (p != NIL && cur == NODE(p)->right) {
+        cur = p;
+        p = rb_parent_idx(NODE(p));
+      }
+      cur = p;
+    }
+  }
+  return (int)i;
+}
+
+// i 서브트리의 black height, 어긋나면 -1 (*prev 는 중위 순서로 직전 노드, 없으면 NIL)
+static int validate_subtree(const rbtree *t, node_idx_t i, node_idx_t *prev, const int depth) {
+  if (i == NIL) {
+    return 0;
+  }
+  if (i >= t->next_idx || depth > RBTREE_MAX_HEIGHT) {
+    return -1;
+  }
+  const node_t *n = NODE(i);
+  if ((n->left != NIL && rb_parent_idx(NODE(n->left)) != i) ||
+      (n->right != NIL && rb_parent_idx(NODE(n->right)) != i)) {
+    return -1;
+  }
+  if (rb_color(n) == RBTREE_RED && (rb_color(NODE(n->left)) == RBTREE_RED || rb_color(NODE(n->right)) == RBTREE_RED)) {
+    return -1;
+  }
+  const int lh = validate_subtree(t, n->left, prev, depth + 1);
+  if (lh < 0 || (*prev != NIL && NODE(*prev)->key > n->key)) {
+    return -1;
+  }
+  *prev = i;
+  const int rh = validate_subtree(t, n->right, prev, depth + 1);
+  if (rh != lh) {
+    return -1;
+  }
+  return lh + (rb_color(n) == RBTREE_BLACK);
+}
+
+int rbtree_validate(const rbtree *t) {
+  if (t == NULL || rb_color(t->nil) != RBTREE_BLACK) {
+    return -1;
+  }
+  if (t->root == NIL) {
+    return 0;
+  }
+  if (t->root >= t->next_idx || rb_color(NODE(t->root)) != RBTREE_BLACK || rb_parent_idx(NODE(t->root)) != NIL) {
+    return -1;
+  }
+  node_idx_t prev = NIL;
+  return validate_subtree(t, t->root, &prev, 0);
+}
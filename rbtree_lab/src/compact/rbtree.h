@@ -0,0 +1,95 @@
+#ifndef _RBTREE_COMPACT_H_
+#define _RBTREE_COMPACT_H_
+
+// src/rbtree.h 와 같은 API를 제공하는 compact 레드-블랙 트리
+// 노드를 풀 배열에 두고 포인터 대신 32비트 인덱스로 연결하여 노드 하나를 16바이트로 줄임
+// -I src/compact 로 include 경로를 바꾸고 src/compact/rbtree.o 를 링크하면 그대로 교체됨
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 색상 정보를 나타내는 열거형
+// RBTREE_RED: 레드 노드
+// RBTREE_BLACK: 블랙 노드
+typedef enum { RBTREE_RED, RBTREE_BLACK } color_t;
+
+// 키 타입 정의 (정수형)
+typedef int key_t;
+
+// 노드 인덱스 (0번은 항상 nil 센티넬)
+typedef uint32_t node_idx_t;
+
+// parent_color 의 최상위 비트가 색상, 나머지 31비트가 부모 인덱스
+#define RBTREE_COLOR_BIT 0x80000000u
+
+// 트리의 노드를 정의하는 구조체 (16바이트)
+struct node_t {
+  key_t key;               // 노드에 저장된 키 값
+  node_idx_t left;         // 왼쪽 자식 인덱스
+  node_idx_t right;        // 오른쪽 자식 인덱스
+  node_idx_t parent_color; // 부모 인덱스 | 색상 비트
+};
+typedef struct node_t node_t;
+
+// 노드 풀은 고정 크기 chunk 들로 나누어 할당 (chunk가 옮겨지지 않으므로 node_t * 가 유지됨)
+#define RBTREE_CHUNK_SHIFT 16
+#define RBTREE_CHUNK_SIZE (1u << RBTREE_CHUNK_SHIFT)
+#define RBTREE_CHUNK_MASK (RBTREE_CHUNK_SIZE - 1)
+
+// 레드-블랙 트리 전체를 나타내는 구조체
+typedef struct {
+  node_idx_t root;      // 루트 노드 인덱스 (비어 있으면 0)
+  node_idx_t free_list; // 반환된 노드 인덱스 목록 (left 로 연결)
+  node_idx_t next_idx;  // 아직 한 번도 쓰지 않은 다음 인덱스
+  node_t *nil;          // nil 센티넬 (0번 노드)
+  node_t **chunks;      // chunk 포인터 배열
+  size_t nchunks;       // 할당된 chunk 수
+  size_t chunk_cap;     // chunks 배열의 용량
+} rbtree;
+
+// 인덱스를 노드 포인터로 변환
+static inline node_t *rb_node_at(const rbtree *t, node_idx_t i) {
+  return &t->chunks[i >> RBTREE_CHUNK_SHIFT][i & RBTREE_CHUNK_MASK];
+}
+
+// 노드의 색상
+static inline color_t rb_color(const node_t *n) {
+  return (n->parent_color & RBTREE_COLOR_BIT) ? RBTREE_BLACK : RBTREE_RED;
+}
+
+// 노드의 부모 인덱스
+static inline node_idx_t rb_parent_idx(const node_t *n) {
+  return n->parent_color & ~RBTREE_COLOR_BIT;
+}
+
+// 새로운 레드-블랙 트리를 생성하고 초기화하여 반환
+rbtree *new_rbtree(void);
+
+// initial_capacity 개의 노드가 들어갈 chunk를 미리 잡아 둔 트리를 생성
+rbtree *new_rbtree_with_pool(size_t initial_capacity);
+
+// 레드-블랙 트리의 모든 chunk를 해제하고 트리 구조체도 함께 해제
+void delete_rbtree(rbtree *);
+
+// 키 값을 트리에 삽입하고, 삽입된 노드 포인터를 반환
+node_t *rbtree_insert(rbtree *, const key_t);
+
+// 특정 키 값을 가진 노드를 검색하여 반환, 찾지 못하면 NULL 반환
+node_t *rbtree_find(const rbtree *, const key_t);
+
+// 트리 내에서 가장 작은 키를 가진 노드를 반환, 트리가 비어 있으면 nil을 반환
+node_t *rbtree_min(const rbtree *);
+
+// 트리 내에서 가장 큰 키를 가진 노드를 반환, 트리가 비어 있으면 nil을 반환
+node_t *rbtree_max(const rbtree *);
+
+// 특정 노드를 트리에서 삭제, 성공 시 0, 실패 시 음수 반환
+int rbtree_erase(rbtree *, node_t *);
+
+// 레드-블랙 트리에 저장된 키들을 오름차순으로 배열에 복사, 복사된 요소의 개수 반환
+int rbtree_to_array(const rbtree *, key_t *, const size_t);
+
+// 키 순서, 색 규칙, 모든 경로의 black 수, 부모 인덱스를 O(n)에 확인, 맞으면 black height / 어긋나면 -1
+int rbtree_validate(const rbtree *);
+
+#endif  // _RBTREE_COMPACT_H_
@@ -6,6 +6,92 @@
 */
 #include "rbtree.h"
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// 풀 생성 시 용량을 주지 않았을 때 첫 slab의 노드 수
+#define RBTREE_POOL_DEFAULT_CAPACITY 64
+// 배치 크기 * 이 값이 트리 크기 이상이면 하나씩 넣지 않고 병합 후 재구성
+#define RBTREE_BATCH_MERGE_RATIO 16
+// rbtree_find_batch 가 한 번에 번갈아 진행하는 탐색 수 (동시에 기다리는 캐시 미스 수)
+#define RBTREE_FIND_BATCH_GROUP 16
+// slab 크기는 두 배씩 늘어나되 이 값(노드 수)을 넘지 않음
+#define RBTREE_POOL_MAX_SLAB (1u << 20)
+// RBTREE_POOL_HUGEPAGE / HUGETLB slab 의 정렬과 크기 단위 (x86-64 / arm64 기본 huge page)
+#define RBTREE_HUGE_PAGE (2u << 20)
+// <numaif.h> 의 MPOL_BIND (libnuma 없이 mbind 시스템 콜을 직접 부름)
+#define RBTREE_MPOL_BIND 2
+// 분할 경로를 담는 스택 크기 (레드-블랙 트리의 높이는 2 log2(n + 1) 이하이므로 64비트 크기에 충분)
+#define RBTREE_MAX_HEIGHT 128
+
+// 통계 카운터 갱신 (-DRBTREE_STATS 가 없으면 아무 코드도 만들지 않음)
+// rbtree_find 처럼 const 트리를 받는 함수에서도 세기 위해 const 를 떼고 씀
+// (트리는 항상 new_rbtree 로 힙에 만들어지므로 실제 const 객체가 아님)
+#ifdef RBTREE_STATS
+#define RB_STAT_INC(t, field) (((rbtree *)(t))->stats.field++)
+#define RB_STAT_FIND(t, depth)                                      \
+  do {                                                              \
+    rbtree_stats *s_ = &((rbtree *)(t))->stats;                     \
+    s_->finds++;                                                    \
+    s_->find_comparisons += (depth);                                \
+    if ((depth) > s_->max_find_depth) s_->max_find_depth = (depth); \
+  } while (0)
+#else
+#define RB_STAT_INC(t, field) ((void)0)
+#define RB_STAT_FIND(t, depth) ((void)(depth))
+#endif
+
+// 이미 트리에 걸린 노드의 자식 칸 / 루트를 바꾸는 저장
+// rbtree_concurrent 의 reader 가 락 없이 같은 칸을 원자적으로 읽으므로 일반 저장이면 데이터 경쟁이 됨
+// RELEASE 라서 새 노드를 걸면 그 전에 채운 키 / 자식도 함께 보임 (x86-64 에서는 일반 mov 와 같음)
+#define rb_set_link(slot, node) __atomic_store_n(&(slot), (node), __ATOMIC_RELEASE)
+
+// 모든 트리가 함께 쓰는 nil 센티넬 (항상 BLACK, 자식은 자기 자신)
+// 어떤 연산도 nil 에 쓰지 않으므로 트리끼리 노드를 옮겨도(split / join) nil 을 고칠 필요가 없고,
+// 실수로 쓰면 바로 드러나도록 읽기 전용 영역에 둠 (부모는 읽지도 않으므로 NULL)
+#ifdef RBTREE_PACKED_COLOR
+static const node_t rb_nil_node = {
+  .parent_color = RBTREE_BLACK,
+  .left = (node_t *)&rb_nil_node,
+  .right = (node_t *)&rb_nil_node,
+};
+#else
+static const node_t rb_nil_node = {
+  .color = RBTREE_BLACK,
+  .parent = NULL,
+  .left = (node_t *)&rb_nil_node,
+  .right = (node_t *)&rb_nil_node,
+};
+#endif
+
+// 노드들을 연속으로 담고 있는 메모리 덩어리
+typedef struct rbtree_slab {
+  struct rbtree_slab *next; // 다음 slab (새로 추가된 slab이 리스트 앞에 옴)
+  size_t capacity;          // 이 slab이 담을 수 있는 노드 수
+  size_t map_len;           // mmap 으로 잡았으면 그 길이, malloc 이면 0
+  size_t used;              // 한 번이라도 나누어 준 노드 수
+  node_t nodes[];           // 노드 배열
+} rbtree_slab;
+
+// 풀이 잡은 slab 들의 묶음, 이 묶음의 노드를 가질 수 있는 풀마다 참조를 하나씩 가짐
+// split / join 으로 노드가 다른 트리로 옮겨 가면 받은 쪽 풀도 참조를 잡아 slab 이 먼저 해제되지 않게 함
+// 묶음끼리는 서로 참조하지 않으므로 나누고 합치기를 반복해도 참조 순환이 생기지 않음
+typedef struct rbtree_arena {
+  rbtree_slab *slabs; // 할당된 slab 목록 (새로 추가된 slab이 리스트 앞에 옴)
+  size_t refs;        // 이 묶음을 가진 풀 수 (트리마다 다른 스레드에서 지울 수 있으므로 원자적으로 증감)
+} rbtree_arena;
+
+struct node_pool_t {
+  rbtree_arena *arena;   // 이 풀이 새 slab 을 추가하는 자기 묶음
+  rbtree_arena **shared; // split / join 으로 들어온 노드가 사는 다른 풀의 묶음들
+  size_t nshared;
+  node_t *free_list;    // 반환된 노드들 (right 포인터로 연결, 어느 묶음의 노드든 섞일 수 있음)
+  size_t next_capacity; // 다음에 추가할 slab의 노드 수
+  int flags;            // RBTREE_POOL_HUGEPAGE / RBTREE_POOL_HUGETLB
+  int numa_node;        // slab 을 묶을 NUMA 노드 (-1 이면 묶지 않음)
+};
 
 rbtree *new_rbtree(void) {
   // rbtree 구조체를 위한 메모리를 동적 할당
@@ -15,39 +101,545 @@ rbtree *new_rbtree(void) {
     return NULL;
   }
 
-  // nil 노드(Sentinel node)를 위한 메모리 동적 할당
-  node_t *nil = (node_t *)calloc(1, sizeof(node_t));
-  if (nil == NULL){
-    free(nil);  // calloc 실패지만, 안전하게 nil 해제 시도 (불필요하긴 함)
-    return NULL;
-  }
-
-  // nil 노드는 항상 BLACK이며, 자기 자신을 가리킴
-  nil->color = RBTREE_BLACK;  // nil 노드는 항상 검정색
-  nil->key = 0;               // 임의 값, 의미 없음
-  nil->parent = nil;          // 부모를 자기 자신으로 설정
-  nil->left = nil;            // 왼쪽 자식도 자기 자신
-  nil->right = nil;           // 오른쪽 자식도 자기 자신
+  // nil 노드(Sentinel node)는 모든 트리가 공유 (key, size 는 0)
+  node_t *nil = (node_t *)&rb_nil_node;
 
   // 트리 초기화
   p->nil = nil;   // nil 노드를 트리에 연결
   p->root = nil;  // root도 초기에는 nil을 가리킴
+  p->pool = NULL; // 기본은 노드마다 calloc/free
+  p->size = 0;    // 빈 트리
+  p->size_stale = 0; // 크기를 세어 둠
+  p->leftmost = nil;  // 빈 트리의 최소/최대는 nil
+  p->rightmost = nil;
+#ifdef RBTREE_STATS
+  memset(&p->stats, 0, sizeof(p->stats));
+#endif
 
   return p;       // 초기화된 트리 반환
 }
 
-void free_subtree(rbtree *t, node_t *n) {
-  // nil 노드는 해제하지 않음 (종료 조건)
-  if (n == t->nil){
+// addr 부터 len 바이트의 페이지를 node 에만 할당하게 함 (페이지를 건드리기 전에 불러야 함)
+static int bind_numa_node(void *addr, size_t len, int node) {
+#ifdef SYS_mbind
+  unsigned long mask[(RBTREE_MAX_NUMA_NODES + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long))] = {0};
+  if (node < 0 || node >= RBTREE_MAX_NUMA_NODES) {
+    return -1;
+  }
+  mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+  return syscall(SYS_mbind, addr, len, RBTREE_MPOL_BIND, mask, (unsigned long)RBTREE_MAX_NUMA_NODES + 1, 0) == 0 ? 0 : -1;
+#else
+  (void)addr;
+  (void)len;
+  (void)node;
+  return -1;
+#endif
+}
+
+// huge page / NUMA 옵션이 있는 풀의 slab 메모리를 mmap 으로 잡음, 실패 시 NULL
+// *len 은 요청 바이트 수를 받아 실제로 잡은 길이로 바뀜 (페이지 단위로 올림하므로 남는 만큼 노드를 더 담음)
+static void *pool_map_slab(const node_pool_t *pool, size_t *len) {
+  void *mem = MAP_FAILED;
+  size_t bytes = *len;
+  if (pool->flags & (RBTREE_POOL_HUGEPAGE | RBTREE_POOL_HUGETLB)) {
+    // 올림한 길이에 정렬용 한 페이지를 더해도 size_t 를 넘지 않아야 함
+    if (bytes > SIZE_MAX - 2 * (size_t)RBTREE_HUGE_PAGE) {
+      return NULL;
+    }
+    bytes = (bytes + RBTREE_HUGE_PAGE - 1) & ~(size_t)(RBTREE_HUGE_PAGE - 1);
+#ifdef MAP_HUGETLB
+    if (pool->flags & RBTREE_POOL_HUGETLB) {
+      // 예약된 huge page(vm.nr_hugepages)가 모자라면 실패하므로 아래 투명 huge page 로 넘어감
+      mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (mem == MAP_FAILED) {
+      // 투명 huge page 는 2MB 경계에 정렬된 구간에만 붙으므로 한 페이지 더 잡고 앞뒤를 잘라 냄
+      char *raw = mmap(NULL, bytes + RBTREE_HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (raw == MAP_FAILED) {
+        return NULL;
+      }
+      char *aligned = (char *)(((uintptr_t)raw + RBTREE_HUGE_PAGE - 1) & ~(uintptr_t)(RBTREE_HUGE_PAGE - 1));
+      if (aligned != raw) {
+        munmap(raw, aligned - raw);
+      }
+      if (aligned + bytes != raw + bytes + RBTREE_HUGE_PAGE) {
+        munmap(aligned + bytes, raw + RBTREE_HUGE_PAGE - aligned);
+      }
+      mem = aligned;
+#ifdef MADV_HUGEPAGE
+      // THP 가 madvise 모드인 시스템에서도 이 구간은 huge page 로 채움 (실패해도 보통 페이지로 동작)
+      madvise(mem, bytes, MADV_HUGEPAGE);
+#endif
+    }
+  } else {
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    if (bytes > SIZE_MAX - page) {
+      return NULL;
+    }
+    bytes = (bytes + page - 1) & ~(page - 1);
+    mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+      return NULL;
+    }
+  }
+  if (pool->numa_node >= 0 && bind_numa_node(mem, bytes, pool->numa_node) != 0) {
+    munmap(mem, bytes);
+    return NULL;
+  }
+  *len = bytes;
+  return mem;
+}
+
+// 풀에 capacity 개의 노드를 담는 slab을 하나 추가
+static int pool_add_slab(node_pool_t *pool, size_t capacity) {
+  rbtree_slab *slab;
+  size_t map_len = 0;
+  // slab 바이트 수가 size_t 를 넘으면 작은 slab 이 잡혀 그 뒤를 덮어쓰게 되므로 실패로 처리
+  if (capacity > (SIZE_MAX - sizeof(rbtree_slab)) / sizeof(node_t)) {
+    return -1;
+  }
+  if (pool->flags != 0 || pool->numa_node >= 0) {
+    map_len = sizeof(rbtree_slab) + capacity * sizeof(node_t);
+    slab = (rbtree_slab *)pool_map_slab(pool, &map_len);
+    if (slab == NULL) {
+      return -1;
+    }
+    capacity = (map_len - sizeof(rbtree_slab)) / sizeof(node_t);
+  } else {
+    slab = (rbtree_slab *)malloc(sizeof(rbtree_slab) + capacity * sizeof(node_t));
+    if (slab == NULL) {
+      return -1;
+    }
+  }
+  slab->capacity = capacity;
+  slab->map_len = map_len;
+  slab->used = 0;
+  slab->next = pool->arena->slabs;
+  pool->arena->slabs = slab;
+  return 0;
+}
+
+// slab 하나를 잡은 방식대로 반환
+static void slab_free(rbtree_slab *slab) {
+  if (slab->map_len != 0) {
+    munmap(slab, slab->map_len);
+  } else {
+    free(slab);
+  }
+}
+
+// 참조 하나를 반납하고, 마지막 참조였으면 묶음의 slab 목록을 돌려줌 (해제는 호출한 쪽이 함, 아니면 NULL)
+static rbtree_slab *arena_release(rbtree_arena *arena) {
+  if (__atomic_sub_fetch(&arena->refs, 1, __ATOMIC_ACQ_REL) != 0) {
+    return NULL;
+  }
+  rbtree_slab *slabs = arena->slabs;
+  free(arena);
+  return slabs;
+}
+
+// slab 이 없는 빈 풀 생성 (첫 slab 은 첫 할당 때 잡음), 실패 시 NULL
+static node_pool_t *pool_new(const int flags, const int numa_node, const size_t next_capacity) {
+  node_pool_t *pool = (node_pool_t *)calloc(1, sizeof(node_pool_t));
+  rbtree_arena *arena = (rbtree_arena *)calloc(1, sizeof(rbtree_arena));
+  if (pool == NULL || arena == NULL) {
+    free(pool);
+    free(arena);
+    return NULL;
+  }
+  arena->refs = 1;
+  pool->arena = arena;
+  pool->flags = flags;
+  pool->numa_node = numa_node;
+  pool->next_capacity = next_capacity;
+  return pool;
+}
+
+// pool 이 from 의 노드를 가질 수 있도록 from 이 가진 묶음들의 참조를 잡음 (이미 가진 묶음은 건너뜀)
+// 실패 시 -1 이고 아무것도 바꾸지 않음
+static int pool_share(node_pool_t *pool, const node_pool_t *from) {
+  rbtree_arena **shared = realloc(pool->shared, (pool->nshared + from->nshared + 1) * sizeof(rbtree_arena *));
+  if (shared == NULL) {
+    return -1;
+  }
+  pool->shared = shared;
+  for (size_t i = 0; i <= from->nshared; i++) {
+    rbtree_arena *arena = i == from->nshared ? from->arena : from->shared[i];
+    int held = arena == pool->arena;
+    for (size_t j = 0; j < pool->nshared && !held; j++) {
+      held = pool->shared[j] == arena;
+    }
+    if (!held) {
+      __atomic_add_fetch(&arena->refs, 1, __ATOMIC_RELAXED);
+      pool->shared[pool->nshared++] = arena;
+    }
+  }
+  return 0;
+}
+
+// 풀을 해제하고 묶음 참조를 모두 반납, 더 이상 아무도 쓰지 않는 slab 들을 하나의 목록으로 돌려줌
+static rbtree_slab *pool_release(node_pool_t *pool) {
+  rbtree_slab *slabs = NULL;
+  for (size_t i = 0; i <= pool->nshared; i++) {
+    rbtree_slab *freed = arena_release(i == pool->nshared ? pool->arena : pool->shared[i]);
+    while (freed != NULL) {
+      rbtree_slab *next = freed->next;
+      freed->next = slabs;
+      slabs = freed;
+      freed = next;
+    }
+  }
+  free(pool->shared);
+  free(pool);
+  return slabs;
+}
+
+rbtree *new_rbtree_with_pool(size_t initial_capacity) {
+  const rbtree_options opts = {.initial_capacity = initial_capacity, .flags = 0, .numa_node = -1};
+  return new_rbtree_with_options(&opts);
+}
+
+rbtree *new_rbtree_with_options(const rbtree_options *opts) {
+  rbtree *t = new_rbtree();
+  if (t == NULL) {
+    return NULL;
+  }
+
+  size_t initial_capacity = opts != NULL ? opts->initial_capacity : 0;
+  if (initial_capacity == 0) {
+    initial_capacity = RBTREE_POOL_DEFAULT_CAPACITY;
+  }
+  node_pool_t *pool = pool_new(opts != NULL ? opts->flags : 0, opts != NULL ? opts->numa_node : -1, initial_capacity);
+  if (pool == NULL) {
+    delete_rbtree(t);
+    return NULL;
+  }
+
+  // 첫 slab을 미리 잡아 두어 초기 삽입에서는 malloc이 일어나지 않게 함
+  if (pool_add_slab(pool, initial_capacity) != 0) {
+    pool_release(pool);
+    delete_rbtree(t);
+    return NULL;
+  }
+
+  t->pool = pool;
+  return t;
+}
+
+// 가장 깊은 레벨 번호 = floor(log2(n)), 루트만 있는 경우는 RED 로 칠하지 않도록 -1
+static int deepest_level(size_t n) {
+  int depth = 0;
+  while (((size_t)2 << depth) <= n) {
+    depth++;
+  }
+  return depth == 0 ? -1 : depth;
+}
+
+// build_sorted 가 노드를 얻어 오는 곳
+// keys 가 있으면 키를 하나씩 꺼내 새 노드를 할당하고, nodes 가 있으면 기존 노드를 차례로 사용,
+// 둘 다 없으면 next 로 키를 하나씩 받아 새 노드를 할당
+typedef struct {
+  const key_t *keys;
+  node_t **nodes;
+  int (*next)(void *ctx, key_t *out);
+  void *ctx;
+  size_t taken; // next 로 받은 키 수
+  key_t last;   // next 로 마지막에 받은 키
+  int failed;   // next 나 노드 할당이 실패했거나 키 순서가 어긋나면 1 (더 만들지 않고 호출한 쪽이 트리를 버림)
+} build_source;
+
+// next 에서 키 하나를 받음, 실패했거나 이전 키보다 작으면 failed 를 세우고 last 를 돌려줌
+static key_t build_next_key(build_source *src) {
+  key_t key = src->last;
+  if (!src->failed && (src->next(src->ctx, &key) != 0 || (src->taken > 0 && key < src->last))) {
+    src->failed = 1;
+    key = src->last;
+  }
+  src->last = key;
+  src->taken++;
+  return key;
+}
+
+// src 에서 n개를 순서대로 꺼내 높이 균형 서브트리를 만들고 그 루트를 반환
+// 가장 깊은 레벨(red_depth)의 노드만 RED, 나머지는 BLACK 으로 칠하면
+// 그 위 레벨은 모두 꽉 차 있으므로 모든 경로의 black 개수가 같아짐
+// 새 노드는 중위 순서로 할당하므로 메모리상에서도 키 순서대로 놓임
+static node_t *build_sorted(rbtree *t, build_source *src, size_t n, int depth, int red_depth) {
+  if (n == 0) {
+    return rb_nil(t);
+  }
+
+  node_t *left = build_sorted(t, src, (n - 1) / 2, depth + 1, red_depth);
+  node_t *node;
+  if (src->keys != NULL) {
+    node = rb_alloc_node(t);
+    node->key = *src->keys++;
+  } else if (src->nodes != NULL) {
+    node = *src->nodes++;
+  } else {
+    // 실패한 뒤에는 남은 노드를 만들지 않음 (키 수가 부풀려진 스트림이면 받은 키만큼만 할당하고 끝남)
+    // 만든 노드는 모두 풀에 있으므로 트리를 지우면 연결되지 않은 노드도 함께 해제됨
+    node = src->failed ? NULL : rb_alloc_node(t);
+    if (node == NULL) {
+      src->failed = 1;
+      return rb_nil(t);
+    }
+    node->key = build_next_key(src);
+    if (src->failed) {
+      return rb_nil(t);
+    }
+  }
+  node->left = left;
+  node->right = build_sorted(t, src, n - 1 - (n - 1) / 2, depth + 1, red_depth);
+#ifdef RBTREE_ORDER_STATS
+  node->size = node->left->size + node->right->size + rb_count(node);
+#endif
+  rb_set_color(node, depth == red_depth ? RBTREE_RED : RBTREE_BLACK);
+  rb_set_parent(node, rb_nil(t));
+  if (node->left != t->nil) {
+    rb_set_parent(node->left, node);
+  }
+  if (node->right != t->nil) {
+    rb_set_parent(node->right, node);
+  }
+  return node;
+}
+
+// size 를 세지 않고 넘긴 트리의 키 수를 양 끝 캐시에서부터 세어 반환 (O(n))
+static size_t count_keys(const rbtree *t) {
+  size_t n = 0;
+  for (node_t *cur = t->leftmost; cur != t->nil; cur = rb_tree_successor(t, cur)) {
+    n += rb_count(cur);
+  }
+  return n;
+}
+
+// 트리를 바꾸는 연산이 실제 키 수가 필요할 때 부름, 세지 않고 넘긴 크기면 한 번 세어 채워 둠
+static size_t rb_settle_size(rbtree *t) {
+  if (t->size_stale) {
+    t->size = count_keys(t);
+    t->size_stale = 0;
+  }
+  return t->size;
+}
+
+// 트리를 통째로 다시 연결한 뒤 양 끝 노드 캐시를 새로 구함 (O(log n))
+static void rb_reset_extremes(rbtree *t) {
+  t->leftmost = t->root;
+  t->rightmost = t->root;
+  if (t->root != t->nil) {
+    t->leftmost = rb_tree_min_subtree(t, t->root);
+    t->rightmost = rb_tree_max_subtree(t, t->root);
+  }
+}
+
+// root 에서 nil 까지 경로의 BLACK 노드 수 (왼쪽 경로를 따라 셈, O(log n))
+static int black_height(const rbtree *t, const node_t *root) {
+  int h = 0;
+  for (const node_t *cur = root; cur != t->nil; cur = cur->left) {
+    if (rb_color(cur) == RBTREE_BLACK) {
+      h++;
+    }
+  }
+  return h;
+}
+
+#ifdef RBTREE_COUNTED
+// 키 n 개를 src 에서 차례로 받아 같은 키끼리 노드 하나로 묶고 균형 트리로 연결, 성공 시 0 / 실패 시 -1
+// 묶음 수를 미리 알 수 없으므로 노드를 먼저 만들어 모은 뒤 다시 연결함 (임시 배열은 묶음 수만큼)
+static int build_counted(rbtree *t, build_source *src, const size_t n) {
+  node_t **nodes = NULL;
+  size_t m = 0, cap = 0;
+  for (size_t i = 0; i < n && !src->failed; i++) {
+    const key_t key = src->keys != NULL ? src->keys[i] : build_next_key(src);
+    if (src->failed) {
+      break;
+    }
+    if (m > 0 && nodes[m - 1]->key == key) {
+      if (nodes[m - 1]->count == UINT32_MAX) {
+        src->failed = 1; // count 가 넘침
+        break;
+      }
+      nodes[m - 1]->count++;
+      t->size++;
+      continue;
+    }
+    if (m == cap) {
+      cap = cap ? cap * 2 : RBTREE_POOL_DEFAULT_CAPACITY;
+      node_t **grown = realloc(nodes, cap * sizeof(node_t *));
+      if (grown == NULL) {
+        src->failed = 1;
+        break;
+      }
+      nodes = grown;
+    }
+    node_t *node = rb_alloc_node(t);
+    if (node == NULL) {
+      src->failed = 1;
+      break;
+    }
+    node->key = key;
+    node->count = 1;
+    nodes[m++] = node;
+    t->size++;
+  }
+  if (!src->failed) {
+    build_source runs = {NULL, nodes, NULL, NULL, 0, 0, 0};
+    t->root = build_sorted(t, &runs, m, 0, deepest_level(m));
+    rb_reset_extremes(t);
+  }
+  free(nodes);
+  return src->failed ? -1 : 0;
+}
+#endif
+
+rbtree *rbtree_from_sorted_array(const key_t *arr, const size_t n) {
+  // 정렬되지 않은 입력은 탐색 트리 성질을 깨므로 거부
+#ifdef RBTREE_COUNTED
+  size_t distinct = n > 0;
+#endif
+  for (size_t i = 1; i < n; i++) {
+    if (arr[i - 1] > arr[i]) {
+      return NULL;
+    }
+#ifdef RBTREE_COUNTED
+    distinct += arr[i - 1] != arr[i];
+#endif
+  }
+
+#ifdef RBTREE_COUNTED
+  // 서로 다른 키마다 노드 하나이므로 그만큼만 잡음
+  rbtree *t = new_rbtree_with_pool(distinct);
+  if (t == NULL) {
+    return NULL;
+  }
+  build_source src = {arr, NULL, NULL, NULL, 0, 0, 0};
+  if (build_counted(t, &src, n) != 0) {
+    delete_rbtree(t);
+    return NULL;
+  }
+#else
+  // 첫 slab 하나에 n개가 모두 들어가므로 노드 할당은 실패하지 않음
+  rbtree *t = new_rbtree_with_pool(n);
+  if (t == NULL) {
+    return NULL;
+  }
+
+  build_source src = {arr, NULL, NULL, NULL, 0, 0, 0};
+  t->root = build_sorted(t, &src, n, 0, deepest_level(n));
+  rb_reset_extremes(t);
+  t->size = n;
+#endif
+  return t;
+}
+
+rbtree *rbtree_from_sorted_source(const size_t n, int (*next)(void *ctx, key_t *out), void *ctx) {
+  if (next == NULL) {
+    return NULL;
+  }
+#ifdef RBTREE_COUNTED
+  // 노드 수(서로 다른 키 수)를 미리 모르므로 풀은 기본 크기에서 늘려 감
+  rbtree *t = new_rbtree_with_pool(0);
+  if (t == NULL) {
+    return NULL;
+  }
+  build_source src = {NULL, NULL, next, ctx, 0, 0, 0};
+  if (build_counted(t, &src, n) != 0) {
+    delete_rbtree(t);
+    return NULL;
+  }
+#else
+  // 첫 slab 은 최대 slab 크기까지만 미리 잡고 나머지는 키를 받는 대로 늘려 감
+  // (n 이 실제 키 수보다 크더라도 받은 키 수에 비례하는 메모리만 씀)
+  rbtree *t = new_rbtree_with_pool(n < RBTREE_POOL_MAX_SLAB ? n : RBTREE_POOL_MAX_SLAB);
+  if (t == NULL) {
+    return NULL;
+  }
+
+  // 키를 받는 대로 중위 순서 자리에 바로 넣으므로 n 개를 담는 임시 배열이 없음
+  build_source src = {NULL, NULL, next, ctx, 0, 0, 0};
+  t->root = build_sorted(t, &src, n, 0, deepest_level(n));
+  if (src.failed) {
+    delete_rbtree(t);
+    return NULL;
+  }
+  rb_reset_extremes(t);
+  t->size = n;
+#endif
+  return t;
+}
+
+node_t *rb_alloc_node(rbtree *t) {
+  node_pool_t *pool = t->pool;
+  if (pool == NULL) {
+    return (node_t *)calloc(1, sizeof(node_t));
+  }
+
+  // 1) 반환된 노드가 있으면 재사용
+  if (pool->free_list != NULL) {
+    node_t *n = pool->free_list;
+    pool->free_list = n->right;
+    return n;
+  }
+
+  // 2) 현재 slab이 가득 찼으면 (split 으로 만든 풀처럼 아직 없으면) 더 큰 slab 추가
+  rbtree_arena *arena = pool->arena;
+  if (arena->slabs == NULL || arena->slabs->used == arena->slabs->capacity) {
+    size_t capacity = pool->next_capacity * 2;
+    if (capacity > RBTREE_POOL_MAX_SLAB) {
+      capacity = RBTREE_POOL_MAX_SLAB;
+    }
+    if (capacity < pool->next_capacity) {
+      capacity = pool->next_capacity;
+    }
+    if (pool_add_slab(pool, capacity) != 0) {
+      return NULL;
+    }
+    pool->next_capacity = capacity;
+  }
+
+  // 3) slab에서 아직 쓰지 않은 다음 노드를 나누어 줌
+  return &arena->slabs->nodes[arena->slabs->used++];
+}
+
+void rb_free_node(rbtree *t, node_t *n) {
+  node_pool_t *pool = t->pool;
+  if (pool == NULL) {
+    free(n);
     return;
   }
+  // freelist 앞에 연결 (LIFO라 최근에 쓴 캐시 라인을 다시 씀)
+  n->right = pool->free_list;
+  pool->free_list = n;
+}
+
+// 풀을 해제하고 다른 풀이 더 쓰지 않는 slab 을 모두 해제 (트리 순회 없음)
+static void pool_destroy(node_pool_t *pool) {
+  rbtree_slab *slab = pool_release(pool);
+  while (slab != NULL) {
+    rbtree_slab *next = slab->next;
+    slab_free(slab);
+    slab = next;
+  }
+}
 
-  // 왼쪽 서브트리 먼저 해제
-  free_subtree(t, n->left);
-  // 오른쪽 서브트리 해제
-  free_subtree(t, n->right);
-  // 현재 노드 해제
-  free(n);
+void free_subtree(rbtree *t, node_t *n) {
+  // 재귀 없이 해제: 왼쪽 자식이 있으면 우회전으로 끌어올리고,
+  // 없으면 현재 노드를 해제한 뒤 오른쪽으로 이동 (각 노드는 최대 한 번만 회전됨)
+  // 어차피 지울 트리이므로 부모 포인터와 색상은 갱신하지 않음
+  while (n != t->nil) {
+    if (n->left != t->nil) {
+      node_t *left = n->left;
+      n->left = left->right;
+      left->right = n;
+      n = left;
+    } else {
+      node_t *next = n->right;
+      rb_free_node(t, n);
+      n = next;
+    }
+  }
 }
 
 void delete_rbtree(rbtree *t) {
@@ -56,251 +648,903 @@ void delete_rbtree(rbtree *t) {
     return;
   }
 
-  // 루트 노드부터 시작하여 모든 노드 재귀적으로 해제
-  free_subtree(t, t->root);
-  // nil 노드도 따로 해제
-  free(t->nil);
-  // 트리 구조체 자체 해제
+  if (t->pool != NULL) {
+    // 풀을 쓰는 트리는 slab만 통째로 해제하면 모든 노드가 반환됨
+    pool_destroy(t->pool);
+  } else {
+    // 루트 노드부터 시작하여 모든 노드를 펼치며 해제 (free_subtree, 재귀 없음)
+    free_subtree(t, t->root);
+  }
+  // 트리 구조체 자체 해제 (nil 은 공유하므로 해제하지 않음)
   free(t);
 }
 
-node_t *rbtree_insert(rbtree *t, const key_t key) {
-  // 1) 트리가 NULL이면 삽입 불가능하므로 NULL 반환
+// 떼어 낸 트리에서 아직 해제하지 않은 부분
+// 트리 구조체 자리를 그대로 다시 쓰므로 떼어 낼 때 할당이 없고 실패하지 않음
+struct rbtree_reaper {
+  node_t *cur;         // 풀이 없으면 free_subtree 와 같은 순서로 펼치며 해제 중인 서브트리
+  rbtree_slab *slabs;  // 풀 트리면 아직 반환하지 않은 slab 목록 (다른 풀이 아직 쓰는 slab 은 들어 있지 않음)
+};
+_Static_assert(sizeof(struct rbtree_reaper) <= sizeof(rbtree), "트리 구조체 자리에 들어가야 함");
+
+rbtree_reaper *rbtree_delete_begin(rbtree *t) {
   if (t == NULL) {
     return NULL;
   }
+  node_t *root = t->root;
+  node_pool_t *pool = t->pool;
+  rbtree_reaper *r = (rbtree_reaper *)t;
+  r->cur = pool != NULL ? (node_t *)&rb_nil_node : root;
+  // 풀 구조체와 묶음 참조는 바로 반납하고 (slab 수에 비례하는 짧은 작업), slab 해제만 나누어 함
+  r->slabs = pool != NULL ? pool_release(pool) : NULL;
+  return r;
+}
+
+int rbtree_delete_step(rbtree_reaper *r, size_t budget) {
+  if (r == NULL) {
+    return 0;
+  }
+  if (budget == 0) {
+    budget = 1;
+  }
+
+  if (r->slabs != NULL) {
+    // slab 단위로만 반환할 수 있으므로 노드 budget 개 분량을 넘기 전까지 (적어도 하나는) 반환
+    size_t freed = 0;
+    while (r->slabs != NULL && freed < budget) {
+      rbtree_slab *slab = r->slabs;
+      r->slabs = slab->next;
+      freed += slab->capacity;
+      slab_free(slab);
+    }
+    if (r->slabs != NULL) {
+      return 1;
+    }
+  } else {
+    // free_subtree 와 같은 펼치기를 budget 번만 진행하고 위치를 남겨 둠
+    node_t *nil = (node_t *)&rb_nil_node;
+    node_t *n = r->cur;
+    for (; n != nil && budget > 0; budget--) {
+      if (n->left != nil) {
+        node_t *left = n->left;
+        n->left = left->right;
+        left->right = n;
+        n = left;
+      } else {
+        node_t *next = n->right;
+        free(n);
+        n = next;
+      }
+    }
+    r->cur = n;
+    if (n != nil) {
+      return 1;
+    }
+  }
+  free(r);
+  return 0;
+}
+
+// node 를 parent 의 빈 자식 칸 *link 에 RED 잎으로 연결 (탐색, 재조정 없음, 재조정은 rb_insert_color)
+// 양 끝에 붙으면 leftmost / rightmost 캐시를 바꾸고, ORDER_STATS 면 parent 부터 루트까지 크기를 1씩 늘림
+void rb_link_node(rbtree *t, node_t *node, node_t *parent, node_t **link) {
+  // 새 노드는 RED 잎으로 시작
+  rb_set_color(node, RBTREE_RED);
+  node->left  = rb_nil(t);
+  node->right = rb_nil(t);
+  rb_set_parent(node, parent);
+  // 최소 노드의 왼쪽 / 최대 노드의 오른쪽에 붙으면 새 양 끝 노드
+  if (parent == t->nil) {
+    t->leftmost = t->rightmost = node;
+  } else if (parent == t->leftmost && link == &parent->left) {
+    t->leftmost = node;
+  } else if (parent == t->rightmost && link == &parent->right) {
+    t->rightmost = node;
+  }
+  rb_set_link(*link, node);
+#ifdef RBTREE_COUNTED
+  node->count = 1;
+#endif
+#ifdef RBTREE_ORDER_STATS
+  // 조상 경로의 서브트리 크기를 1씩 늘림
+  node->size = 1;
+  for (node_t *q = parent; q != t->nil; q = rb_parent(q)) {
+    q->size++;
+  }
+#endif
+}
+
+void rb_insert_color(rbtree *t, node_t *node) {
+  rb_insert_fixup(t, node);
+  t->size++;
+}
+
+#ifdef RBTREE_COUNTED
+// 이미 있는 노드 p 에 같은 키 add 개를 더하고 p 반환 (조상 경로의 크기도 늘림), count 가 넘치면 NULL
+static node_t *rb_add_count(rbtree *t, node_t *p, const size_t add) {
+  if (add > UINT32_MAX - (size_t)p->count) {
+    return NULL;
+  }
+  p->count += (uint32_t)add;
+#ifdef RBTREE_ORDER_STATS
+  for (node_t *q = p; q != t->nil; q = rb_parent(q)) {
+    q->size += add;
+  }
+#endif
+  t->size += add;
+  return p;
+}
+#endif
+
+// start 서브트리 안에서 key 가 들어갈 자리를 찾아 새 노드를 연결하고 재조정
+// start 는 루트이거나, key 가 그 서브트리의 키 범위 안에 있는 노드여야 함
+static node_t *insert_below(rbtree *t, node_t *start, const key_t key) {
+  // 1) 트리에서 삽입 위치(연결할 부모와 그 자식 칸) 탐색
+  //    start 가 nil 이면 빈 트리이므로 루트 칸에 연결
+  node_t *parent = rb_nil(t);
+  node_t **link = &t->root;
+  for (node_t *cur = start; cur != t->nil; cur = *link) {
+#ifdef RBTREE_COUNTED
+    // 같은 키가 이미 있으면 새 노드 없이 count 만 늘림
+    if (key == cur->key) {
+      return rb_add_count(t, cur, 1);
+    }
+#endif
+    parent = cur;
+    // 삽입할 키가 작으면 왼쪽, 크거나 같으면 오른쪽 서브트리로
+    link = key < cur->key ? &cur->left : &cur->right;
+  }
 
   // 2) 새 노드를 위한 메모리 할당
-  node_t *new_node = (node_t *)calloc(1, sizeof(node_t));
+  node_t *new_node = rb_alloc_node(t);
   if (new_node == NULL) {
     // 메모리 할당 실패 시 NULL 반환
     return NULL;
   }
+  new_node->key = key;
 
-  // 3) 새 노드 초기화
-  new_node->key    = key;         // 키값 설정
-  new_node->color  = RBTREE_RED;  // 새 노드는 RED로 시작
-  new_node->left   = t->nil;      // 좌우 자식을 nil로 연결
-  new_node->right  = t->nil;
-  new_node->parent = t->nil;      // 부모도 일단 nil로 초기화
+  // 3) 연결한 뒤 R-B 트리 성질 위반 시 복구
+  rb_link_node(t, new_node, parent, link);
+  rb_insert_color(t, new_node);
 
-  // 4) 트리에서 삽입 위치 탐색
-  node_t *cur = t->root;          // 루트부터 시작
-  while (cur != t->nil) {
-    if (key < cur->key) {
-      // 삽입할 키가 현재 노드 키보다 작으면 왼쪽 서브트리 탐색
-      if (cur->left == t->nil) {
-        cur->left = new_node;     // 빈 자리에 새 노드 연결 후 반복문 탈출
-        break;
-      }
-      cur = cur->left;
+  return new_node;
+}
+
+// 정렬된 키 배치를 삽입할 때, 직전에 삽입한 노드(finger)에서 올라가며
+// key 가 들어갈 수 있는 가장 낮은 서브트리의 루트를 찾음 (key >= finger->key)
+static node_t *finger_start(const rbtree *t, node_t *finger, const key_t key) {
+  node_t *cur = finger;
+  while (cur != t->root) {
+    node_t *p = rb_parent(cur);
+    // 왼쪽 자식의 서브트리는 부모 키보다 작은 키까지만 받을 수 있음
+    if (cur == p->left && key < p->key) {
+      break;
+    }
+    cur = p;
+  }
+  return cur;
+}
+
+// finger_start 의 반대쪽: finger 보다 작은 키(key < finger->key)가 들어갈 수 있는 가장 낮은 서브트리의 루트
+// 역순으로 들어오는 키를 직전 노드를 hint 로 넣을 때 hint 가 빗나가도 루트까지 가지 않음
+static node_t *finger_start_before(const rbtree *t, node_t *finger, const key_t key) {
+  node_t *cur = finger;
+  while (cur != t->root) {
+    node_t *p = rb_parent(cur);
+    // 오른쪽 자식의 서브트리는 부모 키보다 큰 키만 확실히 받을 수 있음
+    // 부모 키와 같으면 더 올라가 부모도 탐색 범위에 넣음 (COUNTED 면 그 노드의 count 를 늘려야 함)
+    if (cur == p->right && key > p->key) {
+      break;
+    }
+    cur = p;
+  }
+  return cur;
+}
+
+node_t *rbtree_insert(rbtree *t, const key_t key) {
+  // 1) 트리가 NULL이면 삽입 불가능하므로 NULL 반환
+  if (t == NULL) {
+    return NULL;
+  }
+
+  // 2) 루트부터 삽입 위치를 찾아 연결하고 새 노드 반환 (메모리 부족 시 NULL)
+  return insert_below(t, t->root, key);
+}
+
+node_t *rbtree_insert_hint(rbtree *t, node_t *hint, const key_t key) {
+  if (t == NULL) {
+    return NULL;
+  }
+  if (hint == NULL || hint == t->nil) {
+    return insert_below(t, t->root, key);
+  }
+
+  // 1) key 가 hint 와 그 이웃 사이에 들어가는지 이웃 하나만 보고 확인
+  //    이웃과 hint 사이에는 빈 자식 칸이 반드시 하나 있으므로 내려가지 않고 바로 연결 가능
+  node_t *parent;
+  node_t **link;
+  if (key >= hint->key) {
+#ifdef RBTREE_COUNTED
+    if (key == hint->key) {
+      return rb_add_count(t, hint, 1);
+    }
+#endif
+    // 최대 노드 뒤에 붙이는 경우(추가 위주 입력)는 올라가 보지 않고 바로 확인됨
+    node_t *next = hint == t->rightmost ? rb_nil(t) : rb_tree_successor(t, hint);
+    if (next != t->nil && next->key < key) {
+      // hint 가 맞지 않으면 hint 에서 key 의 범위를 덮는 조상까지 올라가서 삽입
+      return insert_below(t, finger_start(t, hint, key), key);
+    }
+#ifdef RBTREE_COUNTED
+    if (next != t->nil && next->key == key) {
+      return rb_add_count(t, next, 1);
+    }
+#endif
+    if (hint->right == t->nil) {
+      parent = hint;
+      link = &hint->right;
     } else {
-      // 삽입할 키가 현재 노드 키보다 크거나 같으면 오른쪽 서브트리 탐색
-      if (cur->right == t->nil) {
-        cur->right = new_node;    // 빈 자리에 새 노드 연결 후 반복문 탈출
-        break;
+      // next 는 hint 오른쪽 서브트리의 최솟값이므로 왼쪽 칸이 비어 있음
+      parent = next;
+      link = &next->left;
+    }
+  } else {
+    node_t *prev = hint == t->leftmost ? rb_nil(t) : rb_tree_predecessor(t, hint);
+    if (prev != t->nil && prev->key > key) {
+      return insert_below(t, finger_start_before(t, hint, key), key);
+    }
+#ifdef RBTREE_COUNTED
+    if (prev != t->nil && prev->key == key) {
+      return rb_add_count(t, prev, 1);
+    }
+#endif
+    if (hint->left == t->nil) {
+      parent = hint;
+      link = &hint->left;
+    } else {
+      parent = prev;
+      link = &prev->right;
+    }
+  }
+
+  // 2) 할당 후 연결하고 복구 (복구는 분할 상환 O(1))
+  node_t *new_node = rb_alloc_node(t);
+  if (new_node == NULL) {
+    return NULL;
+  }
+  new_node->key = key;
+  rb_link_node(t, new_node, parent, link);
+  rb_insert_color(t, new_node);
+  return new_node;
+}
+
+static int key_cmp(const void *a, const void *b) {
+  const key_t x = *(const key_t *)a;
+  const key_t y = *(const key_t *)b;
+  return (x > y) - (x < y);
+}
+
+#ifdef RBTREE_COUNTED
+// 병합이 실패했을 때 기존 노드에 더한 count 를 되돌림
+// 같은 키는 기존 노드가 먼저 오므로 기존 노드마다 sorted[0..used) 중 그 키의 개수만큼 더해져 있음
+static void uncount_merged(node_t **nodes, const size_t out, const key_t *sorted, const size_t used) {
+  size_t k = 0;
+  for (size_t j = 0; j < out; j++) {
+    if (nodes[j]->left == NULL) {
+      continue; // 새 노드
+    }
+    while (k < used && sorted[k] < nodes[j]->key) {
+      k++;
+    }
+    while (k < used && sorted[k] == nodes[j]->key) {
+      nodes[j]->count--;
+      k++;
+    }
+  }
+}
+#endif
+
+// 기존 노드 n개를 (키 순서대로) 받아 균형 트리로 다시 연결
+static void relink_sorted(rbtree *t, node_t **nodes, size_t n) {
+  build_source src = {NULL, nodes, NULL, NULL, 0, 0, 0};
+  t->root = build_sorted(t, &src, n, 0, deepest_level(n));
+  rb_reset_extremes(t);
+}
+
+int rbtree_insert_batch(rbtree *t, const key_t *keys, const size_t n) {
+  if (t == NULL || (keys == NULL && n > 0)) {
+    return -1;
+  }
+  if (n == 0) {
+    return 0;
+  }
+
+  // 1) 배치를 정렬 (호출자의 배열은 건드리지 않음)
+  key_t *sorted = (key_t *)malloc(n * sizeof(key_t));
+  if (sorted == NULL) {
+    return -1;
+  }
+  memcpy(sorted, keys, n * sizeof(key_t));
+  qsort(sorted, n, sizeof(key_t), key_cmp);
+
+  if (n * RBTREE_BATCH_MERGE_RATIO >= rb_settle_size(t)) {
+    // 2-a) 트리에 비해 배치가 크면: 기존 노드와 새 노드를 키 순서로 병합한 뒤 O(n)에 재구성
+    //      기존 노드는 그대로 재사용하므로 호출자가 가진 node_t * 는 유효함
+    size_t total = t->size + n;
+    node_t **nodes = (node_t **)malloc(total * sizeof(node_t *));
+    if (nodes == NULL) {
+      free(sorted);
+      return -1;
+    }
+    size_t out = 0, i = 0;
+    node_t *cur = t->root == t->nil ? rb_nil(t) : rb_tree_min_subtree(t, t->root);
+    while (cur != t->nil || i < n) {
+      // 같은 키는 기존 노드를 먼저 두어 rbtree_insert 와 같은 순서를 유지
+      if (cur != t->nil && (i == n || cur->key <= sorted[i])) {
+        nodes[out++] = cur;
+        cur = rb_tree_successor(t, cur);
+        continue;
       }
-      cur = cur->right;
+#ifdef RBTREE_COUNTED
+      // 바로 앞 노드(기존이든 새 노드든)와 같은 키면 count 만 늘림, count 가 넘치면 실패로 처리
+      const int same = out > 0 && nodes[out - 1]->key == sorted[i];
+      if (same && nodes[out - 1]->count < UINT32_MAX) {
+        nodes[out - 1]->count++;
+        i++;
+        continue;
+      }
+      node_t *node = same ? NULL : rb_alloc_node(t);
+#else
+      node_t *node = rb_alloc_node(t);
+#endif
+      if (node == NULL) {
+        // 할당 실패: 지금까지 만든 새 노드를 반환하고 트리는 그대로 둠
+#ifdef RBTREE_COUNTED
+        uncount_merged(nodes, out, sorted, i);
+#endif
+        for (size_t j = 0; j < out; j++) {
+          if (nodes[j]->left == NULL) {
+            rb_free_node(t, nodes[j]);
+          }
+        }
+        free(nodes);
+        free(sorted);
+        return -1;
+      }
+      node->key = sorted[i++];
+#ifdef RBTREE_COUNTED
+      node->count = 1;
+#endif
+      node->left = NULL; // 새 노드 표시 (재연결 전까지만 사용)
+      nodes[out++] = node;
+    }
+    relink_sorted(t, nodes, out);
+    t->size = total;
+    free(nodes);
+  } else {
+    // 2-b) 작은 배치: 정렬된 순서로 삽입하되 직전 노드에서 올라가 필요한 만큼만 다시 내려감
+    node_t *finger = insert_below(t, t->root, sorted[0]);
+    for (size_t i = 1; i < n && finger != NULL; i++) {
+      finger = insert_below(t, finger_start(t, finger, sorted[i]), sorted[i]);
+    }
+    if (finger == NULL) {
+      free(sorted);
+      return -1;
     }
   }
 
-  // 5) 새 노드의 부모 설정
-  new_node->parent = cur;
+  free(sorted);
+  return 0;
+}
+
+int rbtree_erase_batch(rbtree *t, const key_t *keys, const size_t n) {
+  if (t == NULL || (keys == NULL && n > 0)) {
+    return -1;
+  }
+  if (n == 0 || t->root == t->nil) {
+    return 0;
+  }
 
-  // 6) 트리가 비어 있었던 경우(루트가 nil이었을 때)
-  if (cur == t->nil) {
-    t->root = new_node;         // 새 노드를 루트로 설정
+  key_t *sorted = (key_t *)malloc(n * sizeof(key_t));
+  if (sorted == NULL) {
+    return -1;
   }
+  memcpy(sorted, keys, n * sizeof(key_t));
+  qsort(sorted, n, sizeof(key_t), key_cmp);
 
-  // 7) R-B 트리 성질 위반 시 복구 함수 호출
-  rb_insert_fixup(t, new_node);
+  int erased = 0;
+  node_t **nodes = NULL;
+  if (n * RBTREE_BATCH_MERGE_RATIO >= rb_settle_size(t)) {
+    nodes = (node_t **)malloc(t->size * sizeof(node_t *));
+  }
+
+  if (nodes != NULL) {
+    // 큰 배치: 노드를 중위 순서로 모은 뒤 정렬된 키와 나란히 훑어 일치하는 노드를 빼고 재구성
+    // (successor 는 이미 지나온 조상을 거쳐 올라가므로 순회가 끝난 뒤에 해제)
+    size_t total = 0, kept = 0, i = 0;
+    for (node_t *cur = rb_tree_min_subtree(t, t->root); cur != t->nil; cur = rb_tree_successor(t, cur)) {
+      nodes[total++] = cur;
+    }
+    for (size_t j = 0; j < total; j++) {
+      while (i < n && sorted[i] < nodes[j]->key) {
+        i++; // 트리에 없는 키
+      }
+      // 노드에 든 키 수(RBTREE_COUNTED 면 count)까지 같은 키를 소비, 다 빠지면 노드를 해제
+      size_t take = 0;
+      while (take < rb_count(nodes[j]) && i < n && sorted[i] == nodes[j]->key) {
+        i++;
+        take++;
+      }
+      erased += (int)take;
+      if (take == rb_count(nodes[j])) {
+        rb_free_node(t, nodes[j]);
+      } else {
+#ifdef RBTREE_COUNTED
+        nodes[j]->count -= (uint32_t)take;
+#endif
+        nodes[kept++] = nodes[j];
+      }
+    }
+    relink_sorted(t, nodes, kept);
+    t->size -= (size_t)erased;
+    free(nodes);
+  } else {
+    // 작은 배치 (또는 재구성용 배열 할당 실패): 키마다 하나씩 찾아 삭제
+    for (size_t i = 0; i < n; i++) {
+      node_t *p = rbtree_lower_bound(t, sorted[i]);
+      if (p != t->nil && p->key == sorted[i]) {
+        rbtree_erase(t, p);
+        erased++;
+      }
+    }
+  }
 
-  // 8) 최종적으로 루트 노드를 반환
-  return t->root;
+  free(sorted);
+  return erased;
 }
 
-void rb_insert_fixup(rbtree *t, node_t *z) {
+// rb_insert_fixup 에서 마지막 루트 칠하기를 뺀 부분 (join 은 루트가 RED 가 되었는지로 높이 증가를 앎)
+static void insert_rebalance(rbtree *t, node_t *z) {
   // 1) 삽입된 노드 z 의 부모가 RED인 동안 반복 => 붉은-붉은 위반 상태 처리
-  while (z->parent->color == RBTREE_RED) {
+  while (rb_color(rb_parent(z)) == RBTREE_RED) {
     // 2) 부모, 조부모, 삼촌 포인터 가져오기
-    node_t *p = z->parent;        // 부모 노드
-    node_t *g = p->parent;        // 조부모 노드
+    node_t *p = rb_parent(z);        // 부모 노드
+    node_t *g = rb_parent(p);        // 조부모 노드
 
     // 3) Case 구분: 부모가 조부모의 왼쪽 자식인지 확인
     if (p == g->left) {
       node_t *u = g->right;       // 삼촌(uncle) 노드
 
-      if (u->color == RBTREE_RED) {
+      if (rb_color(u) == RBTREE_RED) {
         // === Case 1: 삼촌도 RED인 경우 ===
+        RB_STAT_INC(t, insert_case1);
         // 부모와 삼촌을 BLACK으로, 조부모를 RED로 바꾼 뒤 조부모를 새로운 z로 삼아 위반 재검사
-        p->color = RBTREE_BLACK;
-        u->color = RBTREE_BLACK;
-        g->color = RBTREE_RED;
+        rb_set_color(p, RBTREE_BLACK);
+        rb_set_color(u, RBTREE_BLACK);
+        rb_set_color(g, RBTREE_RED);
         z = g;                     // 위반 검사용 노드를 조부모로 이동
       } else {
         // === Case 2: 삼촌이 BLACK이고 z가 부모의 오른쪽 자식일 때 ===
         if (z == p->right) {
+          RB_STAT_INC(t, insert_case2);
           // z를 부모 위치로 올리고 좌회전으로 좌-우 불균형 변환
           z = p;
           rb_left_rotation(t, z);
           // 갱신: 새 부모, 새 조부모
-          p = z->parent;
-          g = p->parent;
+          p = rb_parent(z);
+          g = rb_parent(p);
         }
         // === Case 3: 삼촌이 BLACK이고 z가 부모의 왼쪽 자식일 때 ===
         // 부모를 BLACK, 조부모를 RED로 색상 변경 후 우회전 수행
-        p->color = RBTREE_BLACK;
-        g->color = RBTREE_RED;
+        RB_STAT_INC(t, insert_case3);
+        rb_set_color(p, RBTREE_BLACK);
+        rb_set_color(g, RBTREE_RED);
         rb_right_rotation(t, g);
       }
     } else {
       // === Mirror Case: 부모가 조부모의 오른쪽 자식인 경우 ===
       node_t *u = g->left;        // 삼촌(uncle) = 조부모의 왼쪽
 
-      if (u->color == RBTREE_RED) {
+      if (rb_color(u) == RBTREE_RED) {
         // Mirror Case 1: 삼촌도 RED
-        p->color = RBTREE_BLACK;
-        u->color = RBTREE_BLACK;
-        g->color = RBTREE_RED;
+        RB_STAT_INC(t, insert_case1);
+        rb_set_color(p, RBTREE_BLACK);
+        rb_set_color(u, RBTREE_BLACK);
+        rb_set_color(g, RBTREE_RED);
         z = g;
       } else {
         // Mirror Case 2: 삼촌 BLACK & z가 부모의 왼쪽 자식
         if (z == p->left) {
+          RB_STAT_INC(t, insert_case2);
           z = p;
           rb_right_rotation(t, z);
-          p = z->parent;
-          g = p->parent;
+          p = rb_parent(z);
+          g = rb_parent(p);
         }
         // Mirror Case 3: 삼촌 BLACK & z가 부모의 오른쪽 자식
-        p->color = RBTREE_BLACK;
-        g->color = RBTREE_RED;
+        RB_STAT_INC(t, insert_case3);
+        rb_set_color(p, RBTREE_BLACK);
+        rb_set_color(g, RBTREE_RED);
         rb_left_rotation(t, g);
       }
     }
   }
 
+}
+
+void rb_insert_fixup(rbtree *t, node_t *z) {
+  insert_rebalance(t, z);
   // 4) 모든 위반을 해결한 후, 트리의 루트는 반드시 BLACK으로 유지
-  t->root->color = RBTREE_BLACK;
+  rb_set_color(t->root, RBTREE_BLACK);
 }
 
 // --- 좌회전(Rotate Left) ---
 void rb_left_rotation(rbtree *t, node_t *current) {
+  RB_STAT_INC(t, left_rotations);
+
   // 1) 회전 대상의 오른쪽 자식을 저장
   node_t *right_child = current->right;
 
   // 2) current 의 오른쪽을 right_child 의 왼쪽 서브트리로 연결
-  current->right = right_child->left;
+  rb_set_link(current->right, right_child->left);
 
   // 3) 옮겨진 서브트리가 nil이 아니면, 해당 노드의 부모를 current로 갱신
   if (right_child->left != t->nil) {
-    right_child->left->parent = current;
+    rb_set_parent(right_child->left, current);
   }
 
   // 4) right_child 를 current 의 부모와 연결
-  right_child->parent = current->parent;
+  rb_set_parent(right_child, rb_parent(current));
 
   // 5) current 가 루트였다면, new root를 right_child로 업데이트
-  if (current->parent == t->nil) {
-    t->root = right_child;
+  if (rb_parent(current) == t->nil) {
+    rb_set_link(t->root, right_child);
   }
   // 6) current 가 부모의 왼쪽 자식이면, 부모의 왼쪽 포인터 갱신
-  else if (current == current->parent->left) {
-    current->parent->left = right_child;
+  else if (current == rb_parent(current)->left) {
+    rb_set_link(rb_parent(current)->left, right_child);
   }
   // 7) 그렇지 않으면 우측 자식이었으므로, 부모의 오른쪽 포인터 갱신
   else {
-    current->parent->right = right_child;
+    rb_set_link(rb_parent(current)->right, right_child);
   }
 
   // 8) current 를 right_child 의 왼쪽 자식으로 연결
-  right_child->left = current;
+  rb_set_link(right_child->left, current);
   // 9) current 의 부모를 right_child로 설정
-  current->parent = right_child;
+  rb_set_parent(current, right_child);
+#ifdef RBTREE_ORDER_STATS
+  // 10) right_child 는 current 서브트리 전체를 물려받고, current 는 자식들로 다시 계산
+  right_child->size = current->size;
+  current->size = current->left->size + current->right->size + rb_count(current);
+#endif
 }
 
 
 // --- 우회전(Rotate Right) ---
 void rb_right_rotation(rbtree *t, node_t *current) {
+  RB_STAT_INC(t, right_rotations);
+
   // 1) 회전 대상의 왼쪽 자식을 저장
   node_t *left_child = current->left;
 
   // 2) current 의 왼쪽을 left_child 의 오른쪽 서브트리로 연결
-  current->left = left_child->right;
+  rb_set_link(current->left, left_child->right);
 
   // 3) 옮겨진 서브트리가 nil이 아니면, 해당 노드의 부모를 current로 갱신
   if (left_child->right != t->nil) {
-    left_child->right->parent = current;
+    rb_set_parent(left_child->right, current);
   }
 
   // 4) left_child 를 current 의 부모와 연결
-  left_child->parent = current->parent;
+  rb_set_parent(left_child, rb_parent(current));
 
   // 5) current 가 루트였다면, new root를 left_child로 업데이트
-  if (current->parent == t->nil) {
-    t->root = left_child;
+  if (rb_parent(current) == t->nil) {
+    rb_set_link(t->root, left_child);
   }
   // 6) current 가 부모의 오른쪽 자식이면, 부모의 오른쪽 포인터 갱신
-  else if (current == current->parent->right) {
-    current->parent->right = left_child;
+  else if (current == rb_parent(current)->right) {
+    rb_set_link(rb_parent(current)->right, left_child);
   }
   // 7) 그 외에는 부모의 왼쪽 포인터 갱신
   else {
-    current->parent->left = left_child;
+    rb_set_link(rb_parent(current)->left, left_child);
   }
 
   // 8) current 를 left_child 의 오른쪽 자식으로 연결
-  left_child->right = current;
+  rb_set_link(left_child->right, current);
   // 9) current 의 부모를 left_child로 설정
-  current->parent = left_child;
+  rb_set_parent(current, left_child);
+#ifdef RBTREE_ORDER_STATS
+  // 10) left_child 는 current 서브트리 전체를 물려받고, current 는 자식들로 다시 계산
+  left_child->size = current->size;
+  current->size = current->left->size + current->right->size + rb_count(current);
+#endif
 }
 
 node_t *rbtree_find(const rbtree *t, const key_t key) {
   // 탐색을 시작할 현재 노드를 root로 설정
   node_t *cur = t->root;
+  size_t depth = 0; // 비교한 노드 수 (통계 빌드에서만 기록)
 
   // nil 노드에 도달할 때까지 반복
   while (t->nil != cur) {
+    depth++;
     if (key == cur->key) {
-      return cur; // 값을 찾으면 해당 노드 반환
+      break;      // 값을 찾으면 반복 종료
     } else if (key < cur->key) {
       cur = cur->left;  // key가 작으면 왼쪽으로 이동
     } else {
       cur = cur->right; // key가 크면 오른쪽으로 이동
     }
   }
+  RB_STAT_FIND(t, depth);
 
   // key를 찾지 못한 경우 NULL 반환
-  return NULL;
+  return cur == t->nil ? NULL : cur;
 }
 
-node_t *rbtree_min(const rbtree *t) {
+size_t rbtree_find_batch(const rbtree *t, const key_t *keys, const size_t n, node_t **out) {
+  size_t found = 0;
+  for (size_t base = 0; base < n; base += RBTREE_FIND_BATCH_GROUP) {
+    const size_t m = n - base < RBTREE_FIND_BATCH_GROUP ? n - base : RBTREE_FIND_BATCH_GROUP;
+    node_t *cur[RBTREE_FIND_BATCH_GROUP];  // 탐색 중인 노드 (끝난 탐색은 NULL)
+    size_t depth[RBTREE_FIND_BATCH_GROUP]; // 비교한 노드 수 (통계 빌드에서만 기록)
+    for (size_t i = 0; i < m; i++) {
+      cur[i] = t->root;
+      depth[i] = 0;
+    }
+
+    // 그룹의 탐색들을 한 단계씩 번갈아 진행: 한 탐색의 다음 노드를 prefetch 해 두고
+    // 나머지 탐색을 진행하는 동안 메모리 지연이 겹쳐서 지나감
+    size_t active = m;
+    while (active > 0) {
+      active = 0;
+      for (size_t i = 0; i < m; i++) {
+        node_t *c = cur[i];
+        if (c == NULL) {
+          continue;
+        }
+        const key_t key = keys[base + i];
+        node_t *next = rb_nil(t);
+        if (c != t->nil) {
+          depth[i]++;
+          if (key == c->key) {
+            out[base + i] = c;
+            found++;
+            RB_STAT_FIND(t, depth[i]);
+            cur[i] = NULL;
+            continue;
+          }
+          next = key < c->key ? c->left : c->right;
+        }
+        if (next == t->nil) {
+          out[base + i] = NULL;
+          RB_STAT_FIND(t, depth[i]);
+          cur[i] = NULL;
+          continue;
+        }
+        __builtin_prefetch(next);
+        cur[i] = next;
+        active++;
+      }
+    }
+  }
+  return found;
+}
+
+#ifdef RBTREE_STATS
+void rbtree_get_stats(const rbtree *t, rbtree_stats *out) {
+  *out = t->stats;
+
+  // black height 는 갱신 비용을 없애기 위해 읽을 때 왼쪽 경로를 따라 한 번 셈, O(log n)
+  out->black_height = (size_t)black_height(t, t->root);
+}
+
+void rbtree_reset_stats(rbtree *t) {
+  memset(&t->stats, 0, sizeof(t->stats));
+}
+#endif
+
+node_t *rbtree_lower_bound(const rbtree *t, const key_t key) {
+  node_t *res = rb_nil(t);
   node_t *cur = t->root;
 
-  // 왼쪽 자식이 nil이 아닐 때까지 반복
-  while (cur->left != t->nil) {
-    cur = cur->left; // 더 왼쪽 자식으로 이동
+  // key 이상인 노드를 만나면 후보로 기억하고 더 앞쪽(왼쪽)을 탐색
+  while (cur != t->nil) {
+    if (key <= cur->key) {
+      res = cur;
+      cur = cur->left;
+    } else {
+      cur = cur->right;
+    }
   }
+  return res;
+}
 
-  // 가장 왼쪽(작은 값) 노드 반환
-  return cur;
+node_t *rbtree_upper_bound(const rbtree *t, const key_t key) {
+  node_t *res = rb_nil(t);
+  node_t *cur = t->root;
+
+  // key 보다 큰 노드를 만나면 후보로 기억하고 더 앞쪽(왼쪽)을 탐색
+  while (cur != t->nil) {
+    if (key < cur->key) {
+      res = cur;
+      cur = cur->left;
+    } else {
+      cur = cur->right;
+    }
+  }
+  return res;
 }
 
-node_t *rbtree_max(const rbtree *t) {
+int rbtree_range(const rbtree *t, const key_t lo, const key_t hi, key_t *arr, const size_t n) {
+  key_t *out = arr;
+  key_t *const end = arr + n;
+
+  // lower_bound 로 한 번만 내려간 뒤 hi 를 넘을 때까지 다음 노드로 이동
+  for (node_t *cur = rbtree_lower_bound(t, lo); cur != t->nil && cur->key <= hi && out < end;
+       cur = rb_tree_successor(t, cur)) {
+    for (size_t c = rb_count(cur); c > 0 && out < end; c--) {
+      *out++ = cur->key;
+    }
+  }
+  return (int)(out - arr);
+}
+
+size_t rbtree_size(const rbtree *t) {
+  return t->size_stale ? count_keys(t) : t->size;
+}
+
+typedef struct {
+  const rbtree *tree;
+  const node_t *prev; // 중위 순서로 직전에 본 노드
+  size_t keys;        // 지금까지 센 키 수
+} validate_ctx;
+
+// p 서브트리의 black height, 어긋나면 -1 (depth 가 높이 한도를 넘으면 고리로 보고 -1)
+static int validate_subtree(validate_ctx *v, const node_t *p, const int depth) {
+  const rbtree *t = v->tree;
+  if (p == t->nil) {
+    return 0;
+  }
+  if (depth > RBTREE_MAX_HEIGHT) {
+    return -1;
+  }
+  if ((p->left != t->nil && rb_parent(p->left) != p) || (p->right != t->nil && rb_parent(p->right) != p)) {
+    return -1;
+  }
+  if (rb_color(p) == RBTREE_RED && (rb_color(p->left) == RBTREE_RED || rb_color(p->right) == RBTREE_RED)) {
+    return -1;
+  }
+  const int lh = validate_subtree(v, p->left, depth + 1);
+  if (lh < 0) {
+    return -1;
+  }
+  // 중위 순서로 키가 줄지 않아야 함 (RBTREE_COUNTED 는 같은 키가 한 노드에 있으므로 늘기만 함)
+#ifdef RBTREE_COUNTED
+  if (p->count == 0 || (v->prev != NULL && v->prev->key >= p->key)) {
+    return -1;
+  }
+#else
+  if (v->prev != NULL && v->prev->key > p->key) {
+    return -1;
+  }
+#endif
+  v->prev = p;
+  v->keys += rb_count(p);
+  const int rh = validate_subtree(v, p->right, depth + 1);
+  if (rh != lh) {
+    return -1;
+  }
+#ifdef RBTREE_ORDER_STATS
+  if (p->size != p->left->size + p->right->size + rb_count(p)) {
+    return -1;
+  }
+#endif
+  return lh + (rb_color(p) == RBTREE_BLACK);
+}
+
+int rbtree_validate(const rbtree *t) {
+  if (t == NULL || rb_color(t->nil) != RBTREE_BLACK) {
+    return -1;
+  }
+  if (t->root == t->nil) {
+    return t->size == 0 && t->leftmost == t->nil && t->rightmost == t->nil ? 0 : -1;
+  }
+  if (rb_color(t->root) != RBTREE_BLACK || rb_parent(t->root) != t->nil) {
+    return -1;
+  }
+  validate_ctx v = {t, NULL, 0};
+  const int h = validate_subtree(&v, t->root, 0);
+  if (h < 0 || (!t->size_stale && v.keys != t->size)) {
+    return -1;
+  }
+  if (t->leftmost != rb_tree_min_subtree(t, t->root) || t->rightmost != rb_tree_max_subtree(t, t->root)) {
+    return -1;
+  }
+  return h;
+}
+
+#ifdef RBTREE_ORDER_STATS
+size_t rbtree_rank(const rbtree *t, const key_t key) {
+  size_t rank = 0;
   node_t *cur = t->root;
 
-  // 오른쪽 자식이 nil이 아닐 때까지 반복
-  while (cur->right != t->nil) {
-    cur = cur->right; // 더 오른쪽 자식으로 이동
+  // 오른쪽으로 내려갈 때마다 왼쪽 서브트리와 현재 노드만큼 더함
+  while (cur != t->nil) {
+    if (cur->key < key) {
+      rank += cur->left->size + rb_count(cur);
+      cur = cur->right;
+    } else {
+      cur = cur->left;
+    }
   }
+  return rank;
+}
 
-  // 가장 오른쪽(큰 값) 노드 반환
-  return cur;
+node_t *rbtree_select(const rbtree *t, size_t k) {
+  node_t *cur = t->root;
+
+  // 왼쪽 서브트리 크기와 비교하여 k 번째가 있는 쪽으로 내려감
+  while (cur != t->nil) {
+    size_t left_size = cur->left->size;
+    if (k < left_size) {
+      cur = cur->left;
+    } else if (k < left_size + rb_count(cur)) {
+      return cur;
+    } else {
+      k -= left_size + rb_count(cur);
+      cur = cur->right;
+    }
+  }
+  return rb_nil(t);
 }
+#endif
 
-int rbtree_erase(rbtree *t, node_t *p) {
+node_t *rbtree_min(const rbtree *t) {
+  // 삽입/삭제 때 갱신해 둔 가장 왼쪽 노드 (빈 트리면 nil)
+  return t->leftmost;
+}
+
+node_t *rbtree_max(const rbtree *t) {
+  // 가장 오른쪽 노드 (빈 트리면 nil)
+  return t->rightmost;
+}
+
+static void rb_delete_fixup_parent(rbtree *t, node_t *target, node_t *node_parent);
+
+void rb_unlink_node(rbtree *t, node_t *p) {
   node_t *successor = p;
   node_t *replacement;
-  color_t original_color = p->color;
+  node_t *replacement_parent = rb_parent(p); // replacement 가 nil 이어도 복구가 올라갈 수 있도록 따로 기억
+  color_t original_color = rb_color(p);
+
+  // 양 끝 노드를 지우면 바로 옆 노드가 새 끝 (끝 노드는 바깥쪽 자식이 없으므로 한두 단계면 찾음)
+  if (p == t->leftmost) {
+    t->leftmost = rb_tree_successor(t, p);
+  }
+  if (p == t->rightmost) {
+    t->rightmost = rb_tree_predecessor(t, p);
+  }
+
+#ifdef RBTREE_ORDER_STATS
+  // 실제로 자리가 빠지는 노드(p, 자식이 둘이면 successor)의 조상들 크기를 줄임
+  // successor 가 빠지면 p 아래 경로는 successor 의 키 수만큼, p 위로는 p 의 키 수만큼 줄어듦
+  const size_t removed = rb_count(p);
+  node_t *gone = (p->left != t->nil && p->right != t->nil) ? rb_tree_min_subtree(t, p->right) : p;
+  node_t *q = rb_parent(gone);
+  if (gone != p) {
+    for (; q != p; q = rb_parent(q)) {
+      q->size -= rb_count(gone);
+    }
+    q = rb_parent(p);
+  }
+  for (; q != t->nil; q = rb_parent(q)) {
+    q->size -= removed;
+  }
+#endif
 
   if (p->left == t->nil) {
     replacement = p->right;
@@ -310,60 +1554,332 @@ int rbtree_erase(rbtree *t, node_t *p) {
     rb_node_change(t, p, replacement);
   } else {
       successor = rb_tree_min_subtree(t, p->right);
-      original_color = successor->color;
+      original_color = rb_color(successor);
       replacement = successor->right;
-      if (successor->parent == p) {
-        replacement->parent = successor;
-        successor->right = p->right;
-        successor->right->parent = successor;
-
+      if (rb_parent(successor) == p) {
+        // successor가 p의 오른쪽 자식이면 successor->right는 그대로 둠
+        replacement_parent = successor;
       }else {
+        replacement_parent = rb_parent(successor);
         rb_node_change(t, successor, replacement);
-        successor->right = p->right;
-        successor->right->parent = successor;
+        rb_set_link(successor->right, p->right);
+        rb_set_parent(successor->right, successor);
       }
       rb_node_change(t, p, successor);
-      successor->left = p->left;
-      successor->left->parent = successor;
-      successor->color = p->color;
+      rb_set_link(successor->left, p->left);
+      rb_set_parent(successor->left, successor);
+      rb_set_color(successor, rb_color(p));
+#ifdef RBTREE_ORDER_STATS
+      successor->size = p->size - removed;
+#endif
     }
   
   if (original_color == RBTREE_BLACK) {
-    rb_delete_fixup(t, replacement);
+    rb_delete_fixup_parent(t, replacement, replacement_parent);
   }
 
-  free(p);
+  t->size -= rb_count(p);
+}
 
+int rbtree_erase(rbtree *t, node_t *p) {
+#ifdef RBTREE_COUNTED
+  // 같은 키가 더 남아 있으면 count 만 줄이고 노드는 그대로 둠
+  if (p->count > 1) {
+    p->count--;
+#ifdef RBTREE_ORDER_STATS
+    for (node_t *q = p; q != t->nil; q = rb_parent(q)) {
+      q->size--;
+    }
+#endif
+    t->size--;
+    return 0;
+  }
+#endif
+  rb_unlink_node(t, p);
+  rb_free_node(t, p);
   return 0;
 }
 
-void rb_delete_fixup(rbtree *t, node_t *target) {
-  while (target != t->root && target->color == RBTREE_BLACK) {
-      node_t *node_parent = target->parent;
+int rbtree_erase_key(rbtree *t, const key_t key) {
+  node_t *p = rbtree_find(t, key);
+  if (p == NULL) {
+    return -1;
+  }
+  return rbtree_erase(t, p);
+}
+
+int rbtree_pop_min(rbtree *t, key_t *out) {
+  if (t == NULL || t->leftmost == t->nil) {
+    return -1;
+  }
+  *out = t->leftmost->key;
+  return rbtree_erase(t, t->leftmost);
+}
+
+int rbtree_pop_max(rbtree *t, key_t *out) {
+  if (t == NULL || t->rightmost == t->nil) {
+    return -1;
+  }
+  *out = t->rightmost->key;
+  return rbtree_erase(t, t->rightmost);
+}
+
+// --- 분할 / 결합 ---
+
+// 독립된 서브트리 a <= x <= b 를 x 로 이어 붙여 t->root 에 두고, 결과의 black height 반환
+// a, b 는 부모가 nil 이고 루트가 BLACK 인 서브트리, ha / hb 는 각각의 black height
+// 높은 쪽의 경계를 따라 black height 가 같아지는 곳까지만 내려가므로 O(|ha - hb| + 1)
+static int join3(rbtree *t, node_t *a, const int ha, node_t *x, node_t *b, const int hb) {
+  const int tall = ha >= hb;
+  node_t *parent = rb_nil(t);
+  node_t *cur = tall ? a : b;
+  int h = tall ? ha : hb;
+  const int target = tall ? hb : ha;
+  t->root = cur;
+
+  // 1) 높은 쪽 서브트리에서 낮은 쪽과 black height 가 같은 BLACK 노드(또는 nil) 찾기
+  //    a 가 높으면 오른쪽 경계, b 가 높으면 왼쪽 경계를 따라 내려감
+  while (rb_color(cur) == RBTREE_RED || h > target) {
+    if (rb_color(cur) == RBTREE_BLACK) {
+      h--;
+    }
+    parent = cur;
+    cur = tall ? cur->right : cur->left;
+  }
+
+  // 2) 그 자리에 x 를 RED 로 넣고 cur 와 낮은 쪽 서브트리를 자식으로 붙임
+  node_t *low = tall ? b : a;
+  x->left = tall ? cur : low;
+  x->right = tall ? low : cur;
+  rb_set_color(x, RBTREE_RED);
+  rb_set_parent(x, parent);
+  if (parent == t->nil) {
+    t->root = x;
+  } else if (tall) {
+    parent->right = x;
+  } else {
+    parent->left = x;
+  }
+  if (cur != t->nil) {
+    rb_set_parent(cur, x);
+  }
+  if (low != t->nil) {
+    rb_set_parent(low, x);
+  }
+#ifdef RBTREE_ORDER_STATS
+  // x 위의 경계 노드들은 낮은 쪽 서브트리와 x 만큼 커짐
+  x->size = x->left->size + x->right->size + rb_count(x);
+  for (node_t *q = parent; q != t->nil; q = rb_parent(q)) {
+    q->size += low->size + rb_count(x);
+  }
+#endif
+
+  // 3) 삽입과 같은 방식으로 RED-RED 위반 복구, 루트가 RED 가 되었으면 칠하면서 높이가 1 늘어남
+  insert_rebalance(t, x);
+  const int grow = rb_color(t->root) == RBTREE_RED;
+  rb_set_color(t->root, RBTREE_BLACK);
+  return (tall ? ha : hb) + grow;
+}
+
+// 분할 경로에서 떼어 낸 자식 서브트리를 독립된 서브트리로 만듦 (루트를 BLACK 으로 칠하면 높이 1 증가)
+static node_t *detach_subtree(rbtree *t, node_t *c, int *h) {
+  if (c != t->nil) {
+    rb_set_parent(c, rb_nil(t));
+    if (rb_color(c) == RBTREE_RED) {
+      rb_set_color(c, RBTREE_BLACK);
+      (*h)++;
+    }
+  }
+  return c;
+}
+
+int rbtree_split(rbtree *t, const key_t key, rbtree **lo, rbtree **hi) {
+  if (t == NULL || lo == NULL || hi == NULL) {
+    return -1;
+  }
+  rbtree *l = new_rbtree();
+  rbtree *r = new_rbtree();
+  if (l == NULL || r == NULL) {
+    delete_rbtree(l);
+    delete_rbtree(r);
+    return -1;
+  }
+  // 풀 트리면 l 이 t 의 풀을 넘겨받고, r 은 같은 slab 을 함께 쓰는 새 풀, t 는 빈 새 풀을 가짐
+  // 나눈 뒤에는 실패할 수 없으므로 필요한 풀은 트리를 건드리기 전에 모두 만들어 둠
+  node_pool_t *rpool = NULL;
+  node_pool_t *tpool = NULL;
+  if (t->pool != NULL) {
+    const size_t cap = RBTREE_POOL_DEFAULT_CAPACITY / 2;
+    rpool = pool_new(t->pool->flags, t->pool->numa_node, cap);
+    tpool = pool_new(t->pool->flags, t->pool->numa_node, cap);
+    if (rpool == NULL || tpool == NULL || pool_share(rpool, t->pool) != 0) {
+      if (rpool != NULL) {
+        pool_destroy(rpool);
+      }
+      if (tpool != NULL) {
+        pool_destroy(tpool);
+      }
+      delete_rbtree(l);
+      delete_rbtree(r);
+      return -1;
+    }
+  }
+
+  // 1) key 를 찾아 내려가는 경로와 각 노드의 black height 를 기록
+  //    key 이상인 노드는 오른쪽 서브트리와 함께 hi 로, 작은 노드는 왼쪽 서브트리와 함께 lo 로 감
+  node_t *path[RBTREE_MAX_HEIGHT];
+  int heights[RBTREE_MAX_HEIGHT];
+  int depth = 0;
+  int h = black_height(t, t->root);
+  for (node_t *cur = t->root; cur != t->nil; cur = key <= cur->key ? cur->left : cur->right) {
+    path[depth] = cur;
+    heights[depth] = h;
+    depth++;
+    h -= rb_color(cur) == RBTREE_BLACK;
+  }
+
+  // 2) 아래에서부터 떼어 낸 조각을 양쪽에 이어 붙임
+  //    이어 붙일 때마다 높이 차이만큼만 내려가고 그 합이 경로 길이로 묶이므로 전체 O(log n)
+  node_t *lroot = rb_nil(t);
+  node_t *rroot = rb_nil(t);
+  int lh = 0;
+  int rh = 0;
+  for (int i = depth - 1; i >= 0; i--) {
+    node_t *x = path[i];
+    int ch = heights[i] - (rb_color(x) == RBTREE_BLACK);
+    if (key <= x->key) {
+      node_t *b = detach_subtree(t, x->right, &ch);
+      rh = join3(r, rroot, rh, x, b, ch);
+      rroot = r->root;
+    } else {
+      node_t *a = detach_subtree(t, x->left, &ch);
+      lh = join3(l, a, ch, x, lroot, lh);
+      lroot = l->root;
+    }
+  }
+  l->root = lroot;
+  r->root = rroot;
+  rb_reset_extremes(l);
+  rb_reset_extremes(r);
+
+  // 3) 크기: 순서 통계 모드면 루트에서 바로 읽고, 아니면 세는 데 O(n) 이 들므로 세지 않고 넘김
+  //    (한쪽이 빈 트리면 다른 쪽이 t 의 크기를 그대로 가짐)
+#ifdef RBTREE_ORDER_STATS
+  l->size = lroot->size;
+  r->size = t->size - l->size;
+#else
+  if (lroot == t->nil || rroot == t->nil) {
+    l->size = lroot == t->nil ? 0 : t->size;
+    r->size = t->size - l->size;
+    l->size_stale = r->size_stale = t->size_stale;
+  } else {
+    l->size_stale = r->size_stale = 1;
+  }
+#endif
+
+  if (tpool != NULL) {
+    l->pool = t->pool;
+    r->pool = rpool;
+    t->pool = tpool;
+  }
+  t->root = t->leftmost = t->rightmost = rb_nil(t);
+  t->size = 0;
+  t->size_stale = 0;
+  *lo = l;
+  *hi = r;
+  return 0;
+}
+
+int rbtree_join(rbtree *lo, rbtree *hi) {
+  if (lo == NULL || hi == NULL || lo == hi) {
+    return -1;
+  }
+  if (hi->root == hi->nil) {
+    return 0;
+  }
+  // 풀 노드와 calloc 노드는 해제하는 방법이 달라 한 트리에 섞을 수 없음
+  if ((lo->pool == NULL) != (hi->pool == NULL)) {
+    return -1;
+  }
+  if (lo->root != lo->nil && lo->rightmost->key > hi->leftmost->key) {
+    return -1;
+  }
+  // 옮겨 올 노드가 사는 slab 을 lo 의 풀도 잡아 두어 hi 가 먼저 지워져도 해제되지 않게 함
+  if (lo->pool != NULL && pool_share(lo->pool, hi->pool) != 0) {
+    return -1;
+  }
+#ifdef RBTREE_COUNTED
+  // 경계의 같은 키는 lo 쪽 노드 하나로 합침
+  if (lo->root != lo->nil && lo->rightmost->key == hi->leftmost->key) {
+    node_t *dup = hi->leftmost;
+    if (rb_add_count(lo, lo->rightmost, dup->count) == NULL) {
+      return -1;
+    }
+    rb_unlink_node(hi, dup);
+    rb_free_node(hi, dup);
+    if (hi->root == hi->nil) {
+      return 0;
+    }
+  }
+#endif
+
+  if (lo->root == lo->nil) {
+    lo->root = hi->root;
+    lo->leftmost = hi->leftmost;
+    lo->rightmost = hi->rightmost;
+    lo->size = hi->size;
+    lo->size_stale = hi->size_stale;
+  } else {
+    // hi 의 최솟값을 떼어 내 가운데 노드로 쓰고 양쪽을 black height 로 이어 붙임
+    node_t *x = hi->leftmost;
+    rb_unlink_node(hi, x);
+    node_t *rightmost = hi->root == hi->nil ? x : hi->rightmost;
+    join3(lo, lo->root, black_height(lo, lo->root), x, hi->root, black_height(hi, hi->root));
+    lo->rightmost = rightmost;
+    // 어느 쪽이든 세지 않고 넘긴 크기면 합도 맞지 않으므로 그대로 넘김
+    lo->size += hi->size + rb_count(x);
+    lo->size_stale |= hi->size_stale;
+  }
+
+  hi->root = hi->leftmost = hi->rightmost = rb_nil(hi);
+  hi->size = 0;
+  hi->size_stale = 0;
+  return 0;
+}
+
+// 삭제로 black 하나가 빠진 target 자리부터 균형 복구, target 이 nil 일 수 있으므로 부모를 따로 받음
+static void rb_delete_fixup_parent(rbtree *t, node_t *target, node_t *node_parent) {
+  // target 이 nil 일 수 있으므로 부모는 target 에서 읽지 않고 따로 들고 다님
+  while (target != t->root && rb_color(target) == RBTREE_BLACK) {
       node_t *uncle;
       if (target == node_parent->left) {
           uncle = node_parent->right;
-          if (uncle->color == RBTREE_RED) { 
-              uncle->color = RBTREE_BLACK;
-              target->parent->color = RBTREE_RED;
-              rb_left_rotation(t, target->parent);
-              uncle = target->parent->right;
+          if (rb_color(uncle) == RBTREE_RED) { 
+              RB_STAT_INC(t, delete_case1);
+              rb_set_color(uncle, RBTREE_BLACK);
+              rb_set_color(node_parent, RBTREE_RED);
+              rb_left_rotation(t, node_parent);
+              uncle = node_parent->right;
           }else {
-              if (uncle->left->color == RBTREE_BLACK && uncle->right->color == RBTREE_BLACK) {
-                  uncle->color = RBTREE_RED;
-                  target = target->parent;
+              if (rb_color(uncle->left) == RBTREE_BLACK && rb_color(uncle->right) == RBTREE_BLACK) {
+                  RB_STAT_INC(t, delete_case2);
+                  rb_set_color(uncle, RBTREE_RED);
+                  target = node_parent;
+                  node_parent = rb_parent(target);
               } else {
        
-                  if (uncle->right->color == RBTREE_BLACK) {
-                      uncle->left->color = RBTREE_BLACK;
-                      uncle->color = RBTREE_RED;
+                  if (rb_color(uncle->right) == RBTREE_BLACK) {
+                      RB_STAT_INC(t, delete_case3);
+                      rb_set_color(uncle->left, RBTREE_BLACK);
+                      rb_set_color(uncle, RBTREE_RED);
                       rb_right_rotation(t,uncle);
                       uncle = node_parent->right;
                   }
             
-                  uncle->color = node_parent->color;
-                  node_parent->color = RBTREE_BLACK;
-                  uncle->right->color = RBTREE_BLACK;
+                  RB_STAT_INC(t, delete_case4);
+                  rb_set_color(uncle, rb_color(node_parent));
+                  rb_set_color(node_parent, RBTREE_BLACK);
+                  rb_set_color(uncle->right, RBTREE_BLACK);
                   rb_left_rotation(t, node_parent);
                   target = t->root;
 
@@ -373,47 +1889,55 @@ void rb_delete_fixup(rbtree *t, node_t *target) {
       }
       else {
           uncle = node_parent->left;
-          if (uncle->color == RBTREE_RED) { 
-              uncle->color = RBTREE_BLACK;
-              target->parent->color = RBTREE_RED;
-              rb_right_rotation(t, target->parent);
-              uncle = target->parent->left;
+          if (rb_color(uncle) == RBTREE_RED) { 
+              RB_STAT_INC(t, delete_case1);
+              rb_set_color(uncle, RBTREE_BLACK);
+              rb_set_color(node_parent, RBTREE_RED);
+              rb_right_rotation(t, node_parent);
+              uncle = node_parent->left;
           }else {
-              if (uncle->left->color == RBTREE_BLACK && uncle->right->color == RBTREE_BLACK) {
-                  uncle->color = RBTREE_RED;
-                  target = target->parent;
+              if (rb_color(uncle->left) == RBTREE_BLACK && rb_color(uncle->right) == RBTREE_BLACK) {
+                  RB_STAT_INC(t, delete_case2);
+                  rb_set_color(uncle, RBTREE_RED);
+                  target = node_parent;
+                  node_parent = rb_parent(target);
               } else {
-                  if (uncle->left->color == RBTREE_BLACK) {
-                      uncle->right->color = RBTREE_BLACK;
-                      uncle->color = RBTREE_RED;
+                  if (rb_color(uncle->left) == RBTREE_BLACK) {
+                      RB_STAT_INC(t, delete_case3);
+                      rb_set_color(uncle->right, RBTREE_BLACK);
+                      rb_set_color(uncle, RBTREE_RED);
                       rb_left_rotation(t,uncle);
                       uncle = node_parent->left;
                   }
-                  uncle->color = node_parent->color;
-                  node_parent->color = RBTREE_BLACK;
-                  uncle->left->color = RBTREE_BLACK;
+                  RB_STAT_INC(t, delete_case4);
+                  rb_set_color(uncle, rb_color(node_parent));
+                  rb_set_color(node_parent, RBTREE_BLACK);
+                  rb_set_color(uncle->left, RBTREE_BLACK);
                   rb_right_rotation(t, node_parent);
                   target = t->root;
               }
           }
       }
   }
-  target->color = RBTREE_BLACK;
-
+  if (target != t->nil) {
+    rb_set_color(target, RBTREE_BLACK);
+  }
 }
 
 void rb_node_change(rbtree *t, node_t *p, node_t *replacement) {
-  if(p->parent == t->nil) {
-    t->root = replacement;
-  } else if (p == p->parent->left) {
-    p->parent->left = replacement;
+  if(rb_parent(p) == t->nil) {
+    rb_set_link(t->root, replacement);
+  } else if (p == rb_parent(p)->left) {
+    rb_set_link(rb_parent(p)->left, replacement);
   } else {
-    p->parent->right = replacement;
+    rb_set_link(rb_parent(p)->right, replacement);
+  }
+  if (replacement != t->nil) {
+    rb_set_parent(replacement, rb_parent(p));
   }
-  replacement->parent = p->parent;
 }
 
-node_t *rb_tree_min_subtree(rbtree *t, node_t *start) {
+node_t *rb_tree_min_subtree(const rbtree *t, node_t *start) {
   node_t *cur = start;
   while (cur->left != t->nil) {
     cur = cur->left;
@@ -421,31 +1945,119 @@ node_t *rb_tree_min_subtree(rbtree *t, node_t *start) {
   return cur;
 }
 
-void inorder_search(const rbtree *t, key_t *arr, size_t n, int *cur_i, node_t *node){
-  // nil 노드이거나 배열이 다 찼으면 종료
-  if (node == t->nil || *cur_i >= n) {
-    return;
+node_t *rb_tree_successor(const rbtree *t, node_t *n) {
+  // 오른쪽 서브트리가 있으면 그 안의 최소 노드
+  if (n->right != t->nil) {
+    return rb_tree_min_subtree(t, n->right);
   }
+  // 없으면 왼쪽 자식 관계가 나올 때까지 부모를 따라 올라감
+  node_t *p = rb_parent(n);
+  while (p != t->nil && n == p->right) {
+    n = p;
+    p = rb_parent(p);
+  }
+  return p;
+}
 
-  // 왼쪽 서브트리 순회
-  inorder_search(t, arr, n, cur_i, node->left);
+node_t *rb_tree_max_subtree(const rbtree *t, node_t *start) {
+  node_t *cur = start;
+  while (cur->right != t->nil) {
+    cur = cur->right;
+  }
+  return cur;
+}
 
-  // 현재 노드의 key 저장
-  if (*cur_i < n) {
-    arr[*cur_i] = node->key;
-    *cur_i += 1; // 인덱스 증가
+node_t *rb_tree_predecessor(const rbtree *t, node_t *n) {
+  // 왼쪽 서브트리가 있으면 그 안의 최대 노드
+  if (n->left != t->nil) {
+    return rb_tree_max_subtree(t, n->left);
   }
+  // 없으면 오른쪽 자식 관계가 나올 때까지 부모를 따라 올라감
+  node_t *p = rb_parent(n);
+  while (p != t->nil && n == p->left) {
+    n = p;
+    p = rb_parent(p);
+  }
+  return p;
+}
+
+node_t *rbtree_next(const rbtree *t, node_t *n) {
+  if (n == t->nil) {
+    return rb_nil(t);
+  }
+  return rb_tree_successor(t, n);
+}
+
+node_t *rbtree_prev(const rbtree *t, node_t *n) {
+  if (n == t->nil) {
+    return rb_nil(t);
+  }
+  return rb_tree_predecessor(t, n);
+}
+
+void rbtree_cursor_first(rbtree_cursor *c, const rbtree *t) {
+  c->tree = t;
+  c->node = rbtree_min(t);
+}
+
+void rbtree_cursor_last(rbtree_cursor *c, const rbtree *t) {
+  c->tree = t;
+  c->node = rbtree_max(t);
+}
+
+void rbtree_cursor_seek(rbtree_cursor *c, const rbtree *t, const key_t key) {
+  c->tree = t;
+  c->node = rbtree_lower_bound(t, key);
+}
+
+int rbtree_cursor_valid(const rbtree_cursor *c) {
+  return c->node != c->tree->nil;
+}
+
+void rbtree_cursor_next(rbtree_cursor *c) {
+  c->node = rbtree_next(c->tree, c->node);
+}
 
-  // 오른쪽 서브트리 순회
-  inorder_search(t, arr, n, cur_i, node->right);
+void rbtree_cursor_prev(rbtree_cursor *c) {
+  c->node = rbtree_prev(c->tree, c->node);
+}
+
+void inorder_search(const rbtree *t, key_t *arr, size_t n, int *cur_i, node_t *node) {
+  // nil 노드이거나 배열이 다 찼으면 종료
+  if (node == t->nil || (size_t)*cur_i >= n) {
+    return;
+  }
+
+  // node 서브트리만 부모 포인터로 순회하므로 그 서브트리의 최댓값에서 멈춤
+  const node_t *last = rb_tree_max_subtree(t, node);
+  for (node_t *cur = rb_tree_min_subtree(t, node); (size_t)*cur_i < n; cur = rb_tree_successor(t, cur)) {
+    for (size_t c = rb_count(cur); c > 0 && (size_t)*cur_i < n; c--) {
+      arr[*cur_i] = cur->key;
+      *cur_i += 1; // 인덱스 증가
+    }
+    if (cur == last) {
+      break;
+    }
+  }
 }
 
 int rbtree_to_array(const rbtree *t, key_t *arr, const size_t n) {
-  int index = 0;
+  if (t->root == t->nil) {
+    return 0;
+  }
 
-  // 중위 순회를 통해 key들을 오름차순으로 배열에 저장
-  inorder_search(t, arr, n, &index, t->root);
+  // 부모 포인터로 중위 순회 (스택·재귀 없음, 노드당 분할 상환 O(1))
+  // 남은 칸 수는 출력 포인터와 끝 포인터 비교 한 번으로 확인
+  key_t *out = arr;
+  key_t *const end = arr + n;
+  for (node_t *cur = rb_tree_min_subtree(t, t->root); cur != t->nil && out < end;
+       cur = rb_tree_successor(t, cur)) {
+    // 묶인 같은 키는 count 만큼 펼침 (RBTREE_COUNTED 가 아니면 항상 1)
+    for (size_t c = rb_count(cur); c > 0 && out < end; c--) {
+      *out++ = cur->key;
+    }
+  }
 
   // 저장한 키 개수 반환
-  return index;
+  return (int)(out - arr);
 }
@@ -2,6 +2,7 @@
 #define _RBTREE_H_
 
 #include <stddef.h>
+#include <stdint.h>
 
 // 색상 정보를 나타내는 열거형
 // RBTREE_RED: 레드 노드
@@ -11,6 +12,25 @@ typedef enum { RBTREE_RED, RBTREE_BLACK } color_t;
 // 키 타입 정의 (정수형)
 typedef int key_t;
 
+#ifdef RBTREE_PACKED_COLOR
+// 트리의 노드를 정의하는 구조체 (-DRBTREE_PACKED_COLOR)
+// 노드는 최소 8바이트 정렬이므로 부모 포인터의 최하위 비트에 색상을 저장
+// (Linux rb_node 의 __rb_parent_color 와 같은 방식)
+// int key 뒤에 패딩이 남으므로 노드 크기는 줄지 않음 (x86-64 에서 기본 레이아웃과 같은 32바이트)
+// 얻는 것은 -DRBTREE_COUNTED 의 count 가 그 패딩에 들어가 노드가 커지지 않는 것뿐
+struct node_t {
+  uintptr_t parent_color; // 부모 노드 포인터 | 색상 비트
+  struct node_t *left;    // 왼쪽 자식 포인터
+  struct node_t *right;   // 오른쪽 자식 포인터
+  key_t key;              // 노드에 저장된 키 값
+#ifdef RBTREE_COUNTED
+  uint32_t count;         // 이 키가 들어간 횟수 (key 뒤의 패딩에 들어가므로 노드 크기는 그대로)
+#endif
+#ifdef RBTREE_ORDER_STATS
+  size_t size;            // 이 노드를 루트로 하는 서브트리의 키 수 (COUNTED 면 count 의 합)
+#endif
+};
+#else
 // 트리의 노드를 정의하는 구조체
 struct node_t {
   color_t color;        // 노드 색상
@@ -18,31 +38,229 @@ struct node_t {
   struct node_t *parent; // 부모 노드 포인터
   struct node_t *left;   // 왼쪽 자식 포인터
   struct node_t *right;  // 오른쪽 자식 포인터
+#ifdef RBTREE_COUNTED
+  uint32_t count;        // 이 키가 들어간 횟수 (-DRBTREE_COUNTED)
+#endif
+#ifdef RBTREE_ORDER_STATS
+  size_t size;           // 이 노드를 루트로 하는 서브트리의 키 수 (-DRBTREE_ORDER_STATS, COUNTED 면 count 의 합)
+#endif
 };
+#endif
 typedef struct node_t node_t;
 
+// 노드의 부모/색상은 레이아웃에 상관없이 아래 매크로로만 읽고 씀
+#ifdef RBTREE_PACKED_COLOR
+#define rb_parent(n) ((node_t *)((n)->parent_color & ~(uintptr_t)1))
+#define rb_color(n) ((color_t)((n)->parent_color & 1))
+#define rb_set_parent(n, p) \
+  ((n)->parent_color = (uintptr_t)(p) | ((n)->parent_color & 1))
+#define rb_set_color(n, c) \
+  ((n)->parent_color = ((n)->parent_color & ~(uintptr_t)1) | (uintptr_t)(c))
+#else
+#define rb_parent(n) ((n)->parent)
+#define rb_color(n) ((n)->color)
+#define rb_set_parent(n, p) ((n)->parent = (p))
+#define rb_set_color(n, c) ((n)->color = (c))
+#endif
+
+// 빈 자식 / 부모 칸에 연결할 nil 포인터 (t->nil 은 모든 트리가 공유하는 읽기 전용 노드이므로 가리키기만 하고 그 칸에 쓰지 않음)
+#define rb_nil(t) ((node_t *)(t)->nil)
+
+// 중복 키 묶음 모드 (-DRBTREE_COUNTED): 같은 키는 노드 하나에 count 로 모음
+// 같은 키가 수없이 반복되는 multiset 에서 노드 수와 높이가 서로 다른 키의 수로 줄어듦
+// 이 모드에서도 키 단위 의미는 그대로 (size, to_array, range, rank 는 중복을 펼쳐서 셈)
+#ifdef RBTREE_COUNTED
+#define rb_count(n) ((size_t)(n)->count)
+#else
+#define rb_count(n) ((size_t)1)
+#endif
+
+// 노드 풀(slab allocator): 연속된 slab에서 노드를 freelist로 나누어 줌
+// 구조체 내부는 rbtree.c 에서만 다룸
+typedef struct node_pool_t node_pool_t;
+
+#ifdef RBTREE_STATS
+// 성능 분석용 카운터 (-DRBTREE_STATS 빌드에서만 존재, 끄면 관련 코드가 모두 사라짐)
+typedef struct {
+  size_t left_rotations;   // rb_left_rotation 호출 수
+  size_t right_rotations;  // rb_right_rotation 호출 수
+  size_t insert_case1;     // rb_insert_fixup: 삼촌 RED, 색만 바꾸고 조부모로 올라감
+  size_t insert_case2;     // rb_insert_fixup: 꺾인 모양을 부모 회전으로 폄
+  size_t insert_case3;     // rb_insert_fixup: 조부모 회전으로 종료
+  size_t delete_case1;     // rb_delete_fixup_parent: 형제 RED, 부모 회전
+  size_t delete_case2;     // rb_delete_fixup_parent: 형제와 조카 모두 BLACK, 부모로 올라감
+  size_t delete_case3;     // rb_delete_fixup_parent: 먼 조카 BLACK, 형제 회전
+  size_t delete_case4;     // rb_delete_fixup_parent: 먼 조카 RED, 부모 회전으로 종료
+  size_t finds;            // rbtree_find 호출 수
+  size_t find_comparisons; // rbtree_find 에서 비교한 노드 수의 합
+  size_t max_find_depth;   // 가장 깊었던 rbtree_find 탐색 깊이
+  size_t black_height;     // 루트에서 nil 까지의 BLACK 노드 수 (rbtree_get_stats 가 채움)
+} rbtree_stats;
+#endif
+
 // 레드-블랙 트리 전체를 나타내는 구조체
 typedef struct {
   node_t *root; // 트리의 루트 노드
-  node_t *nil;  // NIL 노드를 가리키는 센티넬 포인터 (모든 빈 자식은 이 노드를 가리킴)
+  const node_t *nil;  // NIL 노드를 가리키는 센티넬 포인터 (모든 빈 자식은 이 노드를 가리킴, 모든 트리가 공유하며 읽기 전용이므로 const, 연결할 때는 rb_nil)
+  node_pool_t *pool; // 노드 풀 (NULL이면 노드마다 calloc/free 사용)
+  size_t size;       // 저장된 키 수 (RBTREE_COUNTED 면 노드 수가 아니라 count 의 합)
+  int size_stale;    // split / join 이 크기를 세지 않고 넘겨서 size 가 맞지 않으면 1 (-DRBTREE_ORDER_STATS 가 아닐 때만)
+  node_t *leftmost;  // 가장 작은 키의 노드 (비어 있으면 nil), 삽입/삭제 때 갱신
+  node_t *rightmost; // 가장 큰 키의 노드 (비어 있으면 nil)
+#ifdef RBTREE_STATS
+  rbtree_stats stats; // 연산 카운터
+#endif
 } rbtree;
 
 // 새로운 레드-블랙 트리를 생성하고 초기화하여 반환
 // 메모리 할당 후 루트와 nil 센티넬을 설정
 rbtree *new_rbtree(void);
 
+// 노드 풀을 사용하는 레드-블랙 트리를 생성하여 반환
+// 첫 slab은 initial_capacity 개의 노드를 담고, 부족하면 더 큰 slab을 추가
+// 삭제 시 트리를 순회하지 않고 slab 단위로 메모리를 반환
+rbtree *new_rbtree_with_pool(size_t initial_capacity);
+
+// new_rbtree_with_options 의 flags
+// RBTREE_POOL_HUGEPAGE: slab 을 2MB 경계에 맞춘 mmap 으로 잡고 madvise(MADV_HUGEPAGE) 로 투명 huge page 요청
+// RBTREE_POOL_HUGETLB : MAP_HUGETLB 로 예약된 huge page 에서 잡고, 예약분이 없으면 HUGEPAGE 방식으로 대체
+// 노드 수천만 개 규모에서 TLB 한 항목이 2MB 를 덮으므로 탐색 중 dTLB 미스가 줄어듦
+#define RBTREE_POOL_HUGEPAGE 0x1
+#define RBTREE_POOL_HUGETLB 0x2
+
+// numa_node 로 줄 수 있는 최대 노드 번호 + 1
+#define RBTREE_MAX_NUMA_NODES 64
+
+// 노드 풀을 쓰는 트리의 생성 옵션
+typedef struct {
+  size_t initial_capacity; // 첫 slab 의 노드 수 (0 이면 기본값, 페이지 단위로 올림한 만큼 더 담음)
+  int flags;               // RBTREE_POOL_* 조합 (0 이면 malloc 한 slab)
+  int numa_node;           // slab 메모리를 이 NUMA 노드에만 두도록 mbind (-1 이면 두지 않음)
+} rbtree_options;
+
+// 옵션에 따라 slab 을 huge page / NUMA 노드에 두는 풀 트리를 생성 (opts 가 NULL 이면 new_rbtree_with_pool(0) 과 같음)
+// 이후 늘어나는 slab 도 같은 옵션으로 잡음
+// mbind 가 실패하면 (없는 노드, NUMA 를 지원하지 않는 커널 등) NULL 반환
+rbtree *new_rbtree_with_options(const rbtree_options *opts);
+
+// 오름차순으로 정렬된 배열로부터 균형 잡힌 트리를 O(n)에 생성 (rbtree_to_array의 역연산)
+// 회전 없이 아래에서부터 트리를 만들고 깊이에 따라 색칠하며, 노드는 한 블록에 할당
+// arr 가 정렬되어 있지 않거나 메모리 할당에 실패하면 NULL 반환
+rbtree *rbtree_from_sorted_array(const key_t *arr, const size_t n);
+
+// rbtree_from_sorted_array 와 같되 키 n 개를 배열 대신 next(ctx, &key) 로 오름차순으로 하나씩 받음
+// next 는 성공 시 0, 실패 시 -1 을 반환 (키를 모두 모아 둘 배열 없이 스트림에서 바로 생성할 때 사용)
+// next 가 실패하거나 키가 오름차순이 아니면 키를 더 받지 않고 만들던 트리를 버린 뒤 NULL 반환
+rbtree *rbtree_from_sorted_source(const size_t n, int (*next)(void *ctx, key_t *out), void *ctx);
+
 // 레드-블랙 트리의 모든 노드를 해제하고
 // 트리 구조체도 함께 해제
 void delete_rbtree(rbtree *);
 
+// 조금씩 나누어 진행하는 트리 해제 (rbtree_delete_begin 이 돌려주고 rbtree_delete_step 이 끝나면 사라짐)
+typedef struct rbtree_reaper rbtree_reaper;
+
+// 트리를 O(1)에 떼어 내 해제 대기 상태로 바꿈 (메모리 할당 없음, t 는 이 호출 뒤 쓸 수 없음)
+// 실제 해제는 rbtree_delete_step 으로 원할 때 조금씩 하므로, 큰 트리를 지울 때 호출한 쪽이 오래 멈추지 않음
+rbtree_reaper *rbtree_delete_begin(rbtree *t);
+
+// 최대 budget 번의 작업(노드 하나 해제 또는 펼치기 회전 한 번, 풀 트리는 노드 budget 개 분량의 slab)만큼 해제
+// 남은 노드가 있으면 1, 다 해제했으면 0 을 반환하고 r 도 해제됨 (budget 이 0 이면 1로 취급)
+int rbtree_delete_step(rbtree_reaper *r, size_t budget);
+
 // 키 값을 트리에 삽입하고, 삽입된 노드 포인터를 반환
 // 삽입 후 레드-블랙 트리 속성을 유지하도록 재조정
+// RBTREE_COUNTED 에서 이미 있는 키면 그 노드의 count 를 늘리고 그 노드를 반환 (count 가 넘치면 NULL)
 node_t *rbtree_insert(rbtree *, const key_t);
 
+// hint 노드 바로 앞이나 뒤에 key 를 삽입하고 새 노드 반환 (메모리 부족 시 NULL)
+// key 가 hint 와 그 이웃(predecessor / successor) 사이에 들어가면 루트부터 내려가지 않고 바로 연결하므로
+// 거의 정렬된 순서로 들어오는 키를 직전 삽입 노드를 hint 로 넣으면 탐색 비용이 거의 없음
+// hint 가 맞지 않으면 hint 에서 key 의 범위를 덮는 조상까지만 올라가서 삽입 (결과는 rbtree_insert 와 같음)
+// NULL / nil 이면 rbtree_insert 와 같음
+node_t *rbtree_insert_hint(rbtree *, node_t *hint, const key_t);
+
+// key 를 가진 노드 하나를 삭제 (같은 키가 여러 개면 그중 하나), 성공 시 0 / 없으면 -1
+int rbtree_erase_key(rbtree *, const key_t);
+
+// 가장 작은 / 큰 키를 *out 에 쓰고 그 노드를 삭제, 성공 시 0 / 트리가 비어 있으면 -1
+// 캐시된 leftmost / rightmost 에서 바로 지우므로 탐색 없이 재조정 비용만 듦 (우선순위 큐 용도)
+int rbtree_pop_min(rbtree *, key_t *out);
+int rbtree_pop_max(rbtree *, key_t *out);
+
+// t 를 key 보다 작은 키의 트리 *lo 와 key 이상인 키의 트리 *hi 로 나누고 0 반환 (실패 시 -1)
+// 노드를 옮기지 않고 다시 연결만 하므로 O(log n), t 는 빈 트리로 남음
+// -DRBTREE_ORDER_STATS 가 아니면 두 트리의 크기는 세지 않고 넘기므로 rbtree_size 가 필요할 때 셈
+// 노드 풀을 쓰는 트리면 *lo 가 t 의 풀을 넘겨받고 *hi 는 같은 slab 을 함께 쓰는 새 풀을 가짐
+// (slab 은 마지막으로 쓰는 트리가 지워질 때 해제됨), t 는 같은 설정의 빈 풀로 다시 시작함
+int rbtree_split(rbtree *t, const key_t key, rbtree **lo, rbtree **hi);
+
+// hi 의 모든 노드를 lo 뒤에 이어 붙이고 0 반환, hi 는 빈 트리로 남음 (O(log n))
+// lo 의 최댓값이 hi 의 최솟값보다 크거나, 한쪽만 노드 풀을 쓰면 아무것도 바꾸지 않고 -1
+// 둘 다 풀을 쓰면 lo 의 풀이 hi 의 slab 을 함께 쓰게 되어 옮겨 온 노드를 lo 에서 지울 수 있음
+// RBTREE_COUNTED 에서 두 값이 같으면 hi 의 최솟값 노드는 lo 의 최댓값 노드에 합쳐지고 해제됨
+// 노드 포인터는 그대로 유효하며 이제 lo 에 속함
+int rbtree_join(rbtree *lo, rbtree *hi);
+
+// keys 의 n개 키를 한 번에 삽입 (성공 시 0, 실패 시 음수 반환)
+// 배치를 정렬한 뒤, 트리에 비해 작으면 직전 삽입 노드에서 출발하여(finger) 삽입하고
+// 크면 기존 노드와 병합하여 O(size + n)에 재구성. 어느 쪽이든 기존 노드 포인터는 유지됨
+// 메모리 부족으로 실패하면 일부 키만 삽입되었을 수 있음
+int rbtree_insert_batch(rbtree *, const key_t *, const size_t);
+
+// keys 의 각 키마다 같은 키를 가진 노드를 하나씩 삭제하고 삭제한 개수 반환 (실패 시 음수)
+// 트리에 비해 배치가 크면 한 번의 중위 순회로 지운 뒤 재구성
+int rbtree_erase_batch(rbtree *, const key_t *, const size_t);
+
 // 특정 키 값을 가진 노드를 검색하여 반환
 // 찾지 못하면 nil 포인터를 반환
 node_t *rbtree_find(const rbtree *, const key_t);
 
+// keys 의 n개 키를 각각 찾아 out[i] 에 노드(없으면 NULL)를 쓰고 찾은 개수 반환
+// 결과는 키마다 rbtree_find 와 같으며, 여러 탐색을 한 단계씩 번갈아 진행하면서
+// 다음 노드를 prefetch 하므로 큰 트리에서 캐시 미스 대기가 겹침
+size_t rbtree_find_batch(const rbtree *, const key_t *keys, const size_t n, node_t **out);
+
+// key 이상인 키를 가진 첫 노드(중복 키 중 가장 앞)를 반환
+// 그런 노드가 없으면 nil 반환
+node_t *rbtree_lower_bound(const rbtree *, const key_t);
+
+// key 보다 큰 키를 가진 첫 노드를 반환
+// 그런 노드가 없으면 nil 반환
+node_t *rbtree_upper_bound(const rbtree *, const key_t);
+
+// lo <= key <= hi 인 키들을 오름차순으로 배열에 최대 n개 복사
+// 반환 값은 복사된 요소의 개수
+int rbtree_range(const rbtree *, const key_t, const key_t, key_t *, const size_t);
+
+// 트리에 저장된 키의 개수를 O(1)에 반환
+// 단, -DRBTREE_ORDER_STATS 가 아니면 split / join 은 크기를 세지 않고 넘기므로 그 결과 트리에서는 O(n)에 셈
+// (읽기만 하는 호출이라 세어 둔 값을 남기지 않음, 일괄 삽입 / 삭제가 실제 크기가 필요할 때 한 번 세어 채워 둠)
+size_t rbtree_size(const rbtree *);
+
+// 트리가 탐색 트리 / 레드-블랙 트리 성질을 모두 지키는지 O(n)에 확인 (테스트, 스트레스 드라이버용)
+// 키 순서, 루트와 RED 노드 자식의 색, 모든 경로의 black 수, 부모 포인터, 크기(ORDER_STATS 면 노드마다),
+// 양 끝 노드 캐시를 보며, 맞으면 black height / 어긋나면 -1 반환 (고리가 생긴 트리도 -1로 끝남)
+int rbtree_validate(const rbtree *);
+
+#ifdef RBTREE_ORDER_STATS
+// 순서 통계 모드 (-DRBTREE_ORDER_STATS): 노드마다 서브트리 크기를 유지
+
+// key 보다 작은 키의 개수 반환 (= lower_bound 노드의 0부터 시작하는 순위), O(log n)
+size_t rbtree_rank(const rbtree *, const key_t);
+
+// 0부터 센 k 번째로 작은 키를 가진 노드 반환, k >= 크기이면 nil 반환, O(log n)
+node_t *rbtree_select(const rbtree *, size_t);
+#endif
+
+#ifdef RBTREE_STATS
+// 트리의 카운터를 out 에 복사 (black_height 는 이때 계산)
+void rbtree_get_stats(const rbtree *, rbtree_stats *);
+
+// 트리의 카운터를 0으로 초기화
+void rbtree_reset_stats(rbtree *);
+#endif
+
 // 트리 내에서 가장 작은 키를 가진 노드를 반환
 // 트리가 비어 있으면 nil을 반환
 node_t *rbtree_min(const rbtree *);
@@ -53,19 +271,56 @@ node_t *rbtree_max(const rbtree *);
 
 // 특정 노드를 트리에서 삭제
 // 삭제 후 레드-블랙 트리 속성을 유지하도록 재조정
+// RBTREE_COUNTED 에서 count 가 2 이상이면 count 만 줄이고 노드는 남김
 // 성공 시 0, 실패 시 음수 반환
 int rbtree_erase(rbtree *, node_t *);
 
-// 레드-블랙 트리에 저장된 키들을 오름차순으로 배열에 복사
+// 레드-블랙 트리에 저장된 키들을 오름차순으로 배열에 복사 (RBTREE_COUNTED 면 count 만큼 펼침)
 // 반환 값은 복사된 요소의 개수
 int rbtree_to_array(const rbtree *, key_t *, const size_t);
 
-// 서브트리의 모든 노드를 재귀적으로 해제
+// 중위 순회 기준으로 node 다음(더 크거나 같은 키) 노드를 반환
+// 마지막 노드이거나 node 가 nil 이면 nil 반환, 분할 상환 O(1)
+node_t *rbtree_next(const rbtree *, node_t *);
+
+// 중위 순회 기준으로 node 이전(더 작거나 같은 키) 노드를 반환
+// 첫 노드이거나 node 가 nil 이면 nil 반환, 분할 상환 O(1)
+node_t *rbtree_prev(const rbtree *, node_t *);
+
+// 트리를 키 순서대로 훑는 커서 (복사 없이 스트리밍)
+// 커서가 가리키는 노드를 지우면 그 커서는 더 이상 쓸 수 없음
+typedef struct {
+  const rbtree *tree; // 순회 중인 트리
+  node_t *node;       // 현재 노드 (범위를 벗어나면 nil)
+} rbtree_cursor;
+
+// 커서를 가장 작은 키 / 가장 큰 키를 가진 노드에 위치시킴
+void rbtree_cursor_first(rbtree_cursor *, const rbtree *);
+void rbtree_cursor_last(rbtree_cursor *, const rbtree *);
+
+// 커서를 key 이상인 첫 노드에 위치시킴 (rbtree_lower_bound)
+void rbtree_cursor_seek(rbtree_cursor *, const rbtree *, const key_t);
+
+// 커서가 노드를 가리키고 있으면 1, 끝을 벗어났으면 0 반환
+int rbtree_cursor_valid(const rbtree_cursor *);
+
+// 커서를 다음 / 이전 노드로 이동
+void rbtree_cursor_next(rbtree_cursor *);
+void rbtree_cursor_prev(rbtree_cursor *);
+
+// 서브트리의 모든 노드를 해제 (재귀·스택 없이 회전으로 펼치며 해제)
 void free_subtree(rbtree *t, node_t *n);
 
-// 중위 순회로 키 값을 배열에 복사
+// 서브트리 n 의 키를 중위 순서로 arr[*idx] 부터 size 칸까지 복사하고 *idx 를 그만큼 늘림
+// (부모 포인터로 순회하므로 재귀·스택 없음, rbtree_to_array 는 루트에서 같은 순회를 함)
 void inorder_search(const rbtree *t, key_t *arr, size_t size, int *idx, node_t *n);
 
+// 트리에 새 노드 하나를 할당 (풀이 있으면 풀에서, 없으면 calloc)
+node_t *rb_alloc_node(rbtree *t);
+
+// rb_alloc_node로 받은 노드를 반환 (풀이 있으면 freelist로, 없으면 free)
+void rb_free_node(rbtree *t, node_t *n);
+
 // 삽입 후 레드–블랙 트리 속성(색상·균형) 복원
 void rb_insert_fixup(rbtree *t, node_t *z);
 
@@ -75,12 +330,45 @@ void rb_left_rotation(rbtree *t, node_t *x);
 // x를 기준으로 서브트리를 우회전
 void rb_right_rotation(rbtree *t, node_t *x);
 
+// --- intrusive 사용 (Linux rb_node 방식) ---
+// 호출한 쪽이 자기 구조체 안에 node_t 를 넣고, 직접 내려가서 찾은 자리에 연결하면
+// 라이브러리는 색상/회전 복구만 함 (노드 할당 없음, delete_rbtree 전에 모두 rb_unlink_node 해야 함)
+//
+//   node_t **link = &t->root, *parent = rb_nil(t);
+//   while (*link != t->nil) {
+//     parent = *link;
+//     link = my_less(obj, rb_entry(parent, struct my_obj, node)) ? &parent->left : &parent->right;
+//   }
+//   rb_link_node(t, &obj->node, parent, link);
+//   rb_insert_color(t, &obj->node);
+
+// node_t 멤버 포인터에서 그것을 담고 있는 구조체 포인터를 구함
+#define rb_entry(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+
+// node 를 parent 의 자식 칸 *link 에 RED 잎으로 연결 (빈 트리면 parent = nil, link = &t->root)
+void rb_link_node(rbtree *t, node_t *node, node_t *parent, node_t **link);
+
+// rb_link_node 로 연결한 node 의 레드-블랙 속성 복구 후 크기 반영
+void rb_insert_color(rbtree *t, node_t *node);
+
+// p를 트리에서 떼어 내고 균형을 복구하되 p의 메모리는 해제하지 않음 (RBTREE_COUNTED 면 count 전부가 빠짐)
+// (p의 필드도 건드리지 않으므로 동시 읽기 중인 reader가 p를 지나가도 안전, rbtree_concurrent 참고)
+// intrusive 노드의 삭제에도 사용
+void rb_unlink_node(rbtree *t, node_t *p);
+
 // 트리에서 old 노드를 new 노드로 교체 (부모 포인터만 수정)
 void rb_node_change(rbtree *, node_t *, node_t *);
 
 // 주어진 서브트리에서 가장 작은 키를 가진 노드 반환
-node_t *rb_tree_min_subtree(rbtree *, node_t *);
+node_t *rb_tree_min_subtree(const rbtree *, node_t *);
+
+// 주어진 서브트리에서 가장 큰 키를 가진 노드 반환
+node_t *rb_tree_max_subtree(const rbtree *, node_t *);
+
+// 중위 순회 기준 다음 노드 반환 (부모 포인터 사용), 마지막 노드면 nil 반환
+node_t *rb_tree_successor(const rbtree *, node_t *);
 
-void rb_delete_fixup(rbtree *, node_t *);
+// 중위 순회 기준 이전 노드 반환 (부모 포인터 사용), 첫 노드면 nil 반환
+node_t *rb_tree_predecessor(const rbtree *, node_t *);
 
 #endif  // _RBTREE_H_;
@@ -0,0 +1,289 @@
+#include "rbtree_concurrent.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// reader 슬롯 하나가 차지하는 크기 (슬롯끼리 캐시 라인을 공유하지 않도록)
+#define RBTREE_CACHE_LINE 64
+
+// 락 없는 탐색이 이만큼 연속으로 실패한 뒤부터는 다시 내려가기 전에 CPU를 양보함
+// (쓰기 도중 선점된 writer가 먼저 끝낼 수 있도록, reader는 mutex를 잡지 않음)
+#define RBTREE_CONCURRENT_RETRIES 8
+
+// 탐색 중 만날 수 있는 최대 깊이, 넘으면 회전 중인 구조를 본 것이므로 다시 시도
+// (RB 트리 높이는 2 * log2(n + 1) 이하이므로 64비트 주소 공간에서 128을 넘지 않음)
+#define RBTREE_CONCURRENT_MAX_DEPTH 128
+
+// 회수 대기 노드가 이만큼 쌓이면 해제 가능한 것을 한꺼번에 정리
+#define RBTREE_RETIRE_BATCH 64
+
+struct rbtree_reader {
+  _Alignas(RBTREE_CACHE_LINE) rbtree_concurrent *owner;
+  uint64_t epoch; // 탐색 중이면 들어올 때의 전역 epoch, 쉬고 있으면 0
+  int in_use;
+};
+
+// erase로 떼어 냈지만 아직 해제하지 않은 노드
+typedef struct {
+  node_t *node;
+  uint64_t epoch; // 떼어 낼 때의 전역 epoch
+} retired_node;
+
+struct rbtree_concurrent {
+  rbtree_reader readers[RBTREE_CONCURRENT_MAX_READERS];
+  rbtree *tree;
+  pthread_mutex_t lock; // writer끼리의 배타 구간 (reader는 잡지 않음)
+  unsigned seq;         // 홀수면 쓰기 중
+  size_t size;          // writer가 고쳐 두는 키 수 (tree->size는 일반 저장으로 바뀌므로 reader는 이 값을 읽음)
+  uint64_t epoch;       // erase마다 1씩 증가, 1부터 시작
+  retired_node *retired;
+  size_t nretired, retired_cap;
+};
+
+rbtree_concurrent *new_rbtree_concurrent(rbtree *t) {
+  if (t == NULL) {
+    return NULL;
+  }
+  // reader 슬롯이 캐시 라인 단위로 정렬되도록 aligned_alloc 사용
+  size_t bytes = (sizeof(rbtree_concurrent) + RBTREE_CACHE_LINE - 1) & ~(size_t)(RBTREE_CACHE_LINE - 1);
+  rbtree_concurrent *c = aligned_alloc(RBTREE_CACHE_LINE, bytes);
+  if (c == NULL) {
+    return NULL;
+  }
+  for (int i = 0; i < RBTREE_CONCURRENT_MAX_READERS; i++) {
+    c->readers[i].owner = c;
+    c->readers[i].epoch = 0;
+    c->readers[i].in_use = 0;
+  }
+  c->tree = t;
+  pthread_mutex_init(&c->lock, NULL);
+  c->seq = 0;
+  c->size = rbtree_size(t);
+  c->epoch = 1;
+  c->retired = NULL;
+  c->nretired = 0;
+  c->retired_cap = 0;
+  return c;
+}
+
+void delete_rbtree_concurrent(rbtree_concurrent *c) {
+  if (c == NULL) {
+    return;
+  }
+  // reader가 모두 끝났으므로 대기 중인 노드를 바로 해제
+  for (size_t i = 0; i < c->nretired; i++) {
+    rb_free_node(c->tree, c->retired[i].node);
+  }
+  free(c->retired);
+  delete_rbtree(c->tree);
+  pthread_mutex_destroy(&c->lock);
+  free(c);
+}
+
+rbtree_reader *rbtree_reader_register(rbtree_concurrent *c) {
+  for (int i = 0; i < RBTREE_CONCURRENT_MAX_READERS; i++) {
+    int expected = 0;
+    if (__atomic_compare_exchange_n(&c->readers[i].in_use, &expected, 1, 0, __ATOMIC_ACQ_REL,
+                                    __ATOMIC_RELAXED)) {
+      return &c->readers[i];
+    }
+  }
+  return NULL;
+}
+
+void rbtree_reader_unregister(rbtree_reader *r) {
+  __atomic_store_n(&r->epoch, 0, __ATOMIC_RELEASE);
+  __atomic_store_n(&r->in_use, 0, __ATOMIC_RELEASE);
+}
+
+// --- reader 쪽 ---
+
+// 탐색 시작: 현재 전역 epoch를 슬롯에 기록
+// seq_cst 저장이라 writer가 이 값을 보지 못했다면 reader는 writer가 떼어 낸 뒤의 트리만 봄
+static void reader_enter(rbtree_reader *r) {
+  uint64_t e = __atomic_load_n(&r->owner->epoch, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&r->epoch, e, __ATOMIC_SEQ_CST);
+}
+
+static void reader_exit(rbtree_reader *r) {
+  __atomic_store_n(&r->epoch, 0, __ATOMIC_RELEASE);
+}
+
+// 락 없이 한 번 내려가 보기, seqcount가 바뀌지 않았을 때만 1을 반환하고 *found/*res를 채움
+// writer가 동시에 바꾸는 중이면 어긋난 포인터를 볼 수 있지만, epoch 덕분에 가리키는 메모리는
+// 모두 살아 있고(풀 노드, 아직 회수 안 된 노드, 새로 calloc한 노드) 값은 검증 뒤에만 씀
+// writer는 자식 / 루트 칸을 RELEASE로 저장하므로(rbtree.c 의 rb_set_link) 링크를 ACQUIRE로 읽으면
+// 새로 걸린 노드의 키와 자식도 초기화된 값으로 보임 (회전 중의 어긋난 모양은 seqcount 검증이 걸러 냄)
+static int walk_once(rbtree_concurrent *c, const key_t key, const int lower, int *found, key_t *res) {
+  const unsigned seq = __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE);
+  if (seq & 1) {
+    return 0;
+  }
+
+  node_t *nil = rb_nil(c->tree);
+  node_t *cur = __atomic_load_n(&c->tree->root, __ATOMIC_ACQUIRE);
+  int hit = 0, depth = 0;
+  key_t best = 0;
+  // 쓰기 도중의 모양은 검증에서 버리지만, 그 전에 멈추도록 NULL과 깊이를 확인
+  while (cur != nil && cur != NULL && depth++ < RBTREE_CONCURRENT_MAX_DEPTH) {
+    const key_t k = __atomic_load_n(&cur->key, __ATOMIC_RELAXED);
+    if (!lower && k == key) {
+      hit = 1;
+      best = k;
+      break;
+    }
+    if (lower && k >= key) {
+      hit = 1;
+      best = k;
+      cur = __atomic_load_n(&cur->left, __ATOMIC_ACQUIRE);
+    } else if (key < k) {
+      cur = __atomic_load_n(&cur->left, __ATOMIC_ACQUIRE);
+    } else {
+      cur = __atomic_load_n(&cur->right, __ATOMIC_ACQUIRE);
+    }
+  }
+
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if (cur == NULL || depth > RBTREE_CONCURRENT_MAX_DEPTH ||
+      __atomic_load_n(&c->seq, __ATOMIC_RELAXED) != seq) {
+    return 0;
+  }
+  *found = hit;
+  *res = best;
+  return 1;
+}
+
+static int reader_search(rbtree_reader *r, const key_t key, const int lower, key_t *out) {
+  rbtree_concurrent *c = r->owner;
+  int found = 0;
+  key_t res = 0;
+
+  reader_enter(r);
+  // 검증에 실패하면 쓰기가 끝나기를 기다려 다시 내려감 (몇 번 연속 실패하면 양보하며 기다림)
+  for (int attempt = 1; !walk_once(c, key, lower, &found, &res); attempt++) {
+    if (attempt >= RBTREE_CONCURRENT_RETRIES) {
+      sched_yield();
+    }
+  }
+  reader_exit(r);
+
+  if (found && out != NULL) {
+    *out = res;
+  }
+  return found;
+}
+
+int rbtree_concurrent_find(rbtree_reader *r, const key_t key) {
+  return reader_search(r, key, 0, NULL);
+}
+
+int rbtree_concurrent_lower_bound(rbtree_reader *r, const key_t key, key_t *out) {
+  return reader_search(r, key, 1, out) ? 0 : -1;
+}
+
+size_t rbtree_concurrent_size(const rbtree_concurrent *c) {
+  return __atomic_load_n(&c->size, __ATOMIC_RELAXED);
+}
+
+// --- writer 쪽 (항상 c->lock을 잡은 상태) ---
+
+static void write_begin(rbtree_concurrent *c) {
+  __atomic_store_n(&c->seq, c->seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void write_end(rbtree_concurrent *c) {
+  __atomic_store_n(&c->seq, c->seq + 1, __ATOMIC_RELEASE);
+}
+
+// 탐색 중인 reader 가운데 가장 오래된 epoch (없으면 UINT64_MAX)
+static uint64_t oldest_reader(rbtree_concurrent *c) {
+  uint64_t oldest = UINT64_MAX;
+  for (int i = 0; i < RBTREE_CONCURRENT_MAX_READERS; i++) {
+    uint64_t e = __atomic_load_n(&c->readers[i].epoch, __ATOMIC_SEQ_CST);
+    if (e != 0 && e < oldest) {
+      oldest = e;
+    }
+  }
+  return oldest;
+}
+
+// epoch e 이하에 떼어 낸 노드는 e보다 뒤에 들어온 reader에게 보이지 않으므로 해제 가능
+static void reclaim(rbtree_concurrent *c) {
+  const uint64_t oldest = oldest_reader(c);
+  size_t kept = 0;
+  for (size_t i = 0; i < c->nretired; i++) {
+    if (c->retired[i].epoch < oldest) {
+      rb_free_node(c->tree, c->retired[i].node);
+    } else {
+      c->retired[kept++] = c->retired[i];
+    }
+  }
+  c->nretired = kept;
+}
+
+static void retire(rbtree_concurrent *c, node_t *p) {
+  const uint64_t e = c->epoch;
+  __atomic_store_n(&c->epoch, e + 1, __ATOMIC_SEQ_CST);
+
+  if (c->nretired == c->retired_cap) {
+    size_t cap = c->retired_cap ? c->retired_cap * 2 : RBTREE_RETIRE_BATCH;
+    retired_node *grown = realloc(c->retired, cap * sizeof(retired_node));
+    if (grown == NULL) {
+      // 대기 목록을 늘릴 수 없으면 p를 볼 수 있는 reader가 모두 나갈 때까지 기다렸다가 해제
+      while (oldest_reader(c) <= e) {
+        sched_yield();
+      }
+      rb_free_node(c->tree, p);
+      return;
+    }
+    c->retired = grown;
+    c->retired_cap = cap;
+  }
+  c->retired[c->nretired].node = p;
+  c->retired[c->nretired].epoch = e;
+  c->nretired++;
+
+  if (c->nretired >= RBTREE_RETIRE_BATCH) {
+    reclaim(c);
+  }
+}
+
+int rbtree_concurrent_insert(rbtree_concurrent *c, const key_t key) {
+  pthread_mutex_lock(&c->lock);
+  write_begin(c);
+  node_t *node = rbtree_insert(c->tree, key);
+  write_end(c);
+  if (node != NULL) {
+    __atomic_store_n(&c->size, c->size + 1, __ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock(&c->lock);
+  return node == NULL ? -1 : 0;
+}
+
+int rbtree_concurrent_erase(rbtree_concurrent *c, const key_t key) {
+  pthread_mutex_lock(&c->lock);
+  node_t *p = rbtree_find(c->tree, key);
+  if (p == NULL) {
+    pthread_mutex_unlock(&c->lock);
+    return -1;
+  }
+  write_begin(c);
+#ifdef RBTREE_COUNTED
+  // 같은 키가 더 남아 있으면 노드는 트리에 그대로 두고 count 만 줄임 (회수할 노드 없음)
+  if (p->count > 1) {
+    rbtree_erase(c->tree, p);
+    write_end(c);
+    __atomic_store_n(&c->size, c->size - 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&c->lock);
+    return 0;
+  }
+#endif
+  rb_unlink_node(c->tree, p);
+  write_end(c);
+  __atomic_store_n(&c->size, c->size - 1, __ATOMIC_RELAXED);
+  retire(c, p);
+  pthread_mutex_unlock(&c->lock);
+  return 0;
+}
@@ -0,0 +1,54 @@
+#ifndef _RBTREE_CONCURRENT_H_
+#define _RBTREE_CONCURRENT_H_
+
+#include "rbtree.h"
+
+// 쓰기는 하나씩, 읽기는 락을 잡지 않고 여러 스레드가 동시에 하는 rbtree 래퍼
+//
+// - writer(insert/erase)는 내부 mutex로 한 번에 하나만 실행되고, 변경 구간을 seqcount로 감쌈
+// - reader(find/lower_bound)는 mutex를 잡지 않고 트리를 내려간 뒤 seqcount가 그대로인지 확인하고,
+//   그 사이 쓰기가 있었으면 다시 탐색 (몇 번 연속 실패하면 CPU를 양보하며 다시 시도)
+// - 진행 보장: reader끼리, 그리고 reader가 writer를 막는 일은 없음 (writer는 reader를 기다리지 않음)
+//   reader는 쓰기가 없는 틈에 한 번 내려가면 끝나므로, 쓰기가 쉬지 않고 이어지거나 writer가 쓰기 도중
+//   멈춰 있으면 그동안 계속 다시 시도함 (lock-free가 아니라 쓰기가 멈추면 끝나는 seqlock reader)
+// - erase로 떼어 낸 노드는 바로 해제하지 않고, 그 노드를 보고 있을 수 있는 reader가
+//   모두 빠져나간 뒤(epoch 기반 회수) 해제하므로 reader는 해제된 메모리를 읽지 않음
+//
+// reader 스레드는 시작할 때 rbtree_reader_register로 자기 슬롯을 받아 두고 그 핸들로 탐색함
+// 읽기 API는 노드 포인터 대신 키 값을 돌려줌 (반환 직후 다른 스레드가 지울 수 있으므로)
+
+// 동시에 등록할 수 있는 reader 수
+#define RBTREE_CONCURRENT_MAX_READERS 64
+
+typedef struct rbtree_concurrent rbtree_concurrent;
+typedef struct rbtree_reader rbtree_reader;
+
+// t를 감싼 동시성 트리 생성 (t의 소유권을 가져가며, 이후 t를 직접 수정하면 안 됨)
+// 실패 시 NULL 반환
+rbtree_concurrent *new_rbtree_concurrent(rbtree *t);
+
+// 감싼 트리와 회수 대기 중인 노드를 모두 해제 (모든 reader가 끝난 뒤 호출)
+void delete_rbtree_concurrent(rbtree_concurrent *c);
+
+// 호출한 스레드용 reader 슬롯을 받음 (슬롯이 모자라면 NULL)
+rbtree_reader *rbtree_reader_register(rbtree_concurrent *c);
+
+// reader 슬롯을 돌려줌
+void rbtree_reader_unregister(rbtree_reader *r);
+
+// key가 있으면 1, 없으면 0 반환 (mutex 없음, 쓰기와 겹치면 다시 탐색)
+int rbtree_concurrent_find(rbtree_reader *r, const key_t key);
+
+// key 이상인 첫 키를 *out에 쓰고 0 반환, 없으면 -1 반환 (mutex 없음, 쓰기와 겹치면 다시 탐색)
+int rbtree_concurrent_lower_bound(rbtree_reader *r, const key_t key, key_t *out);
+
+// key 삽입, 성공 시 0 / 메모리 부족 시 -1
+int rbtree_concurrent_insert(rbtree_concurrent *c, const key_t key);
+
+// key 하나를 삭제, 성공 시 0 / 없으면 -1
+int rbtree_concurrent_erase(rbtree_concurrent *c, const key_t key);
+
+// 저장된 key 개수 (쓰기와 동시에 호출하면 직전 또는 직후 값)
+size_t rbtree_concurrent_size(const rbtree_concurrent *c);
+
+#endif  // _RBTREE_CONCURRENT_H_
@@ -0,0 +1,341 @@
+#include "rbtree_frozen.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// keys 배열을 캐시 라인 경계에 두어 keys[16k .. 16k + 15] 가 한 줄에 모이게 함
+#define RBTREE_CACHE_LINE 64
+
+// 한 캐시 라인에 들어가는 키 수 (k 의 4단계 아래 자손 16개가 keys[16k ..] 한 줄에 모여 있음)
+#define FROZEN_KEYS_PER_LINE (RBTREE_CACHE_LINE / sizeof(key_t))
+
+// 바이트 순서 확인용 값 (다른 순서의 기계에서 만든 파일은 거부)
+#define FROZEN_BYTE_ORDER 0x01020304u
+
+_Static_assert(sizeof(rbtree_frozen_header) == RBTREE_FROZEN_HEADER_SIZE, "헤더는 64바이트");
+
+struct rbtree_frozen {
+  key_t *keys;    // keys[1 .. n] 이 Eytzinger 순서, keys[0] 은 쓰지 않음
+  size_t n;
+  size_t refs;    // 참조 수 (원자적으로 증감)
+  void *map;      // rbtree_frozen_map 으로 만든 경우 mmap 한 주소 (아니면 NULL)
+  size_t map_len;
+};
+
+// reader 는 락 없이 current 를 읽고 참조를 늘림
+// current 를 읽은 뒤 참조를 늘리기 전까지는 active[phase] 에 자신을 세어 두고 (세는 사이 phase 가 바뀌었으면 다시 셈),
+// publish 는 current 를 바꾼 뒤 phase 를 뒤집고 이전 phase 의 reader 가 빠질 때까지 기다린 다음 이전 스냅샷을 반납
+// (새로 들어오는 reader 는 다른 칸을 세므로 기다림은 reader 가 계속 들어와도 끝남)
+struct rbtree_frozen_holder {
+  pthread_mutex_t publish_lock; // publish 끼리만 순서를 정함 (reader 는 잡지 않음)
+  rbtree_frozen *current;
+  unsigned phase;   // reader 가 셀 active 칸 번호 (0 / 1)
+  size_t active[2]; // 각 phase 에서 current 를 읽고 참조를 늘리는 중인 reader 수
+};
+
+// --- Eytzinger 인덱스 ---
+
+// 중위 순서로 첫 칸 (가장 왼쪽), 비어 있으면 0
+static size_t eytz_first(const size_t n) {
+  if (n == 0) {
+    return 0;
+  }
+  size_t k = 1;
+  while (2 * k <= n) {
+    k = 2 * k;
+  }
+  return k;
+}
+
+// 중위 순서로 k 다음 칸, 마지막이면 0
+static size_t eytz_next(size_t k, const size_t n) {
+  if (2 * k + 1 <= n) {
+    // 오른쪽 서브트리의 가장 왼쪽
+    k = 2 * k + 1;
+    while (2 * k <= n) {
+      k = 2 * k;
+    }
+    return k;
+  }
+  // 오른쪽 자식인 동안 올라간 뒤 한 번 더 올라간 곳 (루트에서 끝나면 0)
+  while (k & 1) {
+    k >>= 1;
+  }
+  return k >> 1;
+}
+
+// key 이상인 첫 칸, 없으면 0
+// 비교 결과(0/1)를 그대로 더해 내려가므로 분기 예측 실패가 없고, 끝나면 마지막으로 왼쪽으로
+// 내려갔던 지점(= 뒤쪽의 1 비트들과 그 위 0 비트 한 개를 지운 값)이 답
+static inline size_t eytz_lower_bound(const rbtree_frozen *f, const key_t key) {
+  const key_t *keys = f->keys;
+  size_t k = 1;
+  while (k <= f->n) {
+    __builtin_prefetch(keys + k * FROZEN_KEYS_PER_LINE);
+    k = 2 * k + (keys[k] < key);
+  }
+  return k >> __builtin_ffsll((long long)~k);
+}
+
+// --- 스냅샷 ---
+
+rbtree_frozen *rbtree_freeze(const rbtree *t) {
+  rbtree_frozen *f = malloc(sizeof(rbtree_frozen));
+  if (f == NULL) {
+    return NULL;
+  }
+  f->n = rbtree_size(t);
+  f->refs = 1;
+  f->map = NULL;
+  f->map_len = 0;
+  size_t bytes = (f->n + 1) * sizeof(key_t);
+  bytes = (bytes + RBTREE_CACHE_LINE - 1) & ~(size_t)(RBTREE_CACHE_LINE - 1);
+  f->keys = aligned_alloc(RBTREE_CACHE_LINE, bytes);
+  if (f->keys == NULL) {
+    free(f);
+    return NULL;
+  }
+  f->keys[0] = 0;
+
+  // 트리의 중위 순회와 Eytzinger 칸의 중위 순회를 나란히 진행 (임시 정렬 배열 없음)
+  size_t k = eytz_first(f->n);
+  if (f->n > 0) {
+    for (node_t *cur = rb_tree_min_subtree(t, t->root); cur != t->nil; cur = rb_tree_successor(t, cur)) {
+      // RBTREE_COUNTED 면 묶인 같은 키를 칸마다 하나씩 펼침
+      for (size_t c = rb_count(cur); c > 0; c--) {
+        f->keys[k] = cur->key;
+        k = eytz_next(k, f->n);
+      }
+    }
+  }
+  return f;
+}
+
+void rbtree_frozen_release(rbtree_frozen *f) {
+  if (f == NULL) {
+    return;
+  }
+  if (__atomic_sub_fetch(&f->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+    if (f->map != NULL) {
+      munmap(f->map, f->map_len);
+    } else {
+      free(f->keys);
+    }
+    free(f);
+  }
+}
+
+size_t rbtree_frozen_size(const rbtree_frozen *f) {
+  return f->n;
+}
+
+int rbtree_frozen_find(const rbtree_frozen *f, const key_t key) {
+  size_t k = eytz_lower_bound(f, key);
+  return k != 0 && f->keys[k] == key;
+}
+
+int rbtree_frozen_lower_bound(const rbtree_frozen *f, const key_t key, key_t *out) {
+  size_t k = eytz_lower_bound(f, key);
+  if (k == 0) {
+    return -1;
+  }
+  *out = f->keys[k];
+  return 0;
+}
+
+int rbtree_frozen_range(const rbtree_frozen *f, const key_t lo, const key_t hi, key_t *arr, const size_t n) {
+  key_t *out = arr;
+  key_t *const end = arr + n;
+
+  // lower_bound 로 한 번만 내려간 뒤 hi 를 넘을 때까지 중위 순서로 이동
+  for (size_t k = eytz_lower_bound(f, lo); k != 0 && f->keys[k] <= hi && out < end; k = eytz_next(k, f->n)) {
+    *out++ = f->keys[k];
+  }
+  return (int)(out - arr);
+}
+
+// --- 파일 ---
+
+// path 가 들어 있는 디렉터리를 fsync, 성공 시 0 / 실패 시 -1
+static int sync_parent_dir(const char *path) {
+  const char *slash = strrchr(path, '/');
+  char *dir;
+  if (slash == NULL) {
+    dir = strdup(".");
+  } else {
+    // "/file" 이면 루트 디렉터리
+    const size_t len = slash == path ? 1 : (size_t)(slash - path);
+    dir = strndup(path, len);
+  }
+  if (dir == NULL) {
+    return -1;
+  }
+  const int fd = open(dir, O_RDONLY | O_DIRECTORY);
+  free(dir);
+  if (fd < 0) {
+    return -1;
+  }
+  const int rc = fsync(fd);
+  close(fd);
+  return rc == 0 ? 0 : -1;
+}
+
+int rbtree_frozen_save(const rbtree_frozen *f, const char *path) {
+  rbtree_frozen_header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, RBTREE_FROZEN_MAGIC, sizeof(h.magic));
+  h.version = RBTREE_FROZEN_VERSION;
+  h.key_size = sizeof(key_t);
+  h.n = f->n;
+  h.byte_order = FROZEN_BYTE_ORDER;
+
+  // 같은 디렉터리의 임시 파일에 다 쓴 뒤 rename 으로 한 번에 바꿔 끼움
+  const size_t len = strlen(path) + sizeof(".tmp");
+  char *tmp = malloc(len);
+  if (tmp == NULL) {
+    return -1;
+  }
+  snprintf(tmp, len, "%s.tmp", path);
+
+  FILE *fp = fopen(tmp, "wb");
+  if (fp == NULL) {
+    free(tmp);
+    return -1;
+  }
+  int ok = fwrite(&h, sizeof(h), 1, fp) == 1 && fwrite(f->keys, sizeof(key_t), f->n + 1, fp) == f->n + 1;
+  // rename 보다 내용이 먼저 디스크에 닿아야 비정상 종료 뒤에 잘린 파일이 path 로 보이지 않음
+  ok = ok && fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+  ok = (fclose(fp) == 0) && ok;
+  ok = ok && rename(tmp, path) == 0;
+  if (!ok) {
+    remove(tmp);
+  }
+  free(tmp);
+  // rename 자체(디렉터리 항목)도 디스크에 남도록 디렉터리를 fsync
+  return ok && sync_parent_dir(path) == 0 ? 0 : -1;
+}
+
+rbtree_frozen *rbtree_frozen_map(const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(rbtree_frozen_header)) {
+    close(fd);
+    return NULL;
+  }
+  const size_t len = (size_t)st.st_size;
+  void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  // 매핑은 fd 를 닫아도 유지됨
+  close(fd);
+  if (map == MAP_FAILED) {
+    return NULL;
+  }
+
+  // 헤더만 확인하고 키 배열은 건드리지 않음 (페이지는 탐색하면서 필요할 때 읽힘)
+  const rbtree_frozen_header *h = map;
+  const size_t avail = (len - sizeof(*h)) / sizeof(key_t); // keys[0] 을 포함한 칸 수
+  if (memcmp(h->magic, RBTREE_FROZEN_MAGIC, sizeof(h->magic)) != 0 || h->version != RBTREE_FROZEN_VERSION ||
+      h->key_size != sizeof(key_t) || h->byte_order != FROZEN_BYTE_ORDER ||
+      avail == 0 || h->n > avail - 1) {
+    munmap(map, len);
+    return NULL;
+  }
+
+  rbtree_frozen *f = malloc(sizeof(rbtree_frozen));
+  if (f == NULL) {
+    munmap(map, len);
+    return NULL;
+  }
+  f->keys = (key_t *)((char *)map + RBTREE_FROZEN_HEADER_SIZE);
+  f->n = h->n;
+  f->refs = 1;
+  f->map = map;
+  f->map_len = len;
+  return f;
+}
+
+rbtree *rbtree_frozen_thaw(const rbtree_frozen *f) {
+  // Eytzinger 칸을 중위 순서로 읽으면 정렬된 배열이므로 O(n) 일괄 생성에 바로 넘김
+  key_t *sorted = malloc((f->n ? f->n : 1) * sizeof(key_t));
+  if (sorted == NULL) {
+    return NULL;
+  }
+  size_t i = 0;
+  for (size_t k = eytz_first(f->n); k != 0; k = eytz_next(k, f->n)) {
+    sorted[i++] = f->keys[k];
+  }
+  rbtree *t = rbtree_from_sorted_array(sorted, f->n);
+  free(sorted);
+  return t;
+}
+
+// --- 교체용 보관함 ---
+
+rbtree_frozen_holder *new_rbtree_frozen_holder(rbtree_frozen *initial) {
+  rbtree_frozen_holder *h = malloc(sizeof(rbtree_frozen_holder));
+  if (h == NULL) {
+    return NULL;
+  }
+  pthread_mutex_init(&h->publish_lock, NULL);
+  h->current = initial;
+  h->phase = 0;
+  h->active[0] = h->active[1] = 0;
+  return h;
+}
+
+void delete_rbtree_frozen_holder(rbtree_frozen_holder *h) {
+  if (h == NULL) {
+    return;
+  }
+  rbtree_frozen_release(h->current);
+  pthread_mutex_destroy(&h->publish_lock);
+  free(h);
+}
+
+rbtree_frozen *rbtree_frozen_acquire(rbtree_frozen_holder *h) {
+  // active 증가와 current 읽기는 publish 의 교체 / 기다림과 전체 순서가 정해져야 하므로 SEQ_CST
+  // publish 가 이 증가를 못 보고 지나갔다면 이 reader 는 이미 바뀐 current 를 읽음
+  unsigned phase = __atomic_load_n(&h->phase, __ATOMIC_SEQ_CST) & 1;
+  __atomic_add_fetch(&h->active[phase], 1, __ATOMIC_SEQ_CST);
+  // phase 를 읽은 뒤 세기 전에 publish 가 phase 를 뒤집었으면 이 reader 는 다음 publish 가 기다리지 않는
+  // 칸에 세어져 있으므로, 그 사이 읽은 current 가 반납될 수 있음: 세기를 되돌리고 지금 phase 로 다시 셈
+  // (다시 읽은 phase 가 같으면 다음에 이 칸을 뒤집는 publish 가 반드시 이 reader 를 기다림)
+  for (;;) {
+    const unsigned now = __atomic_load_n(&h->phase, __ATOMIC_SEQ_CST) & 1;
+    if (now == phase) {
+      break;
+    }
+    __atomic_sub_fetch(&h->active[phase], 1, __ATOMIC_RELEASE);
+    phase = now;
+    __atomic_add_fetch(&h->active[phase], 1, __ATOMIC_SEQ_CST);
+  }
+  rbtree_frozen *f = __atomic_load_n(&h->current, __ATOMIC_SEQ_CST);
+  if (f != NULL) {
+    __atomic_add_fetch(&f->refs, 1, __ATOMIC_RELAXED);
+  }
+  // 참조 증가가 publish 의 반납보다 먼저 보이도록 RELEASE
+  __atomic_sub_fetch(&h->active[phase], 1, __ATOMIC_RELEASE);
+  return f;
+}
+
+void rbtree_frozen_publish(rbtree_frozen_holder *h, rbtree_frozen *next) {
+  pthread_mutex_lock(&h->publish_lock);
+  rbtree_frozen *old = __atomic_exchange_n(&h->current, next, __ATOMIC_SEQ_CST);
+  const unsigned phase = h->phase & 1;
+  __atomic_store_n(&h->phase, phase ^ 1, __ATOMIC_SEQ_CST);
+  // old 를 읽었을 수 있는 reader 가 참조를 늘리고 나갈 때까지 기다림 (current 읽기와 증가 사이의 짧은 구간)
+  while (__atomic_load_n(&h->active[phase], __ATOMIC_SEQ_CST) != 0) {
+    sched_yield();
+  }
+  pthread_mutex_unlock(&h->publish_lock);
+  // old 를 이미 acquire 한 reader 가 있으면 마지막 release 에서 해제됨
+  rbtree_frozen_release(old);
+}
@@ -0,0 +1,83 @@
+#ifndef _RBTREE_FROZEN_H_
+#define _RBTREE_FROZEN_H_
+
+#include "rbtree.h"
+
+// 읽기 전용 스냅샷: 트리의 키를 포인터 없이 Eytzinger(BFS) 순서 배열 하나에 담음
+//
+// - keys[1] 이 루트, keys[k] 의 자식은 keys[2k], keys[2k + 1] 이므로 탐색은 인덱스 계산만으로 내려감
+// - 비교 결과를 분기 대신 인덱스에 더하고, 4단계 아래(캐시 라인 하나 = 키 16개)를 미리 prefetch
+// - 위쪽 단계가 배열 앞부분에 모이므로 자주 지나는 노드가 같은 캐시 라인에 있음
+// 스냅샷은 만든 뒤 바뀌지 않으므로 여러 스레드가 락 없이 동시에 읽을 수 있음
+
+typedef struct rbtree_frozen rbtree_frozen;
+
+// t 의 현재 키로 스냅샷 생성 (rbtree_to_array 와 같은 중위 순회 한 번, O(n))
+// 참조 하나를 가진 채로 반환하며 다 쓰면 rbtree_frozen_release 로 반납, 실패 시 NULL
+rbtree_frozen *rbtree_freeze(const rbtree *t);
+
+// 참조 하나를 반납하고 마지막 참조였으면 해제
+void rbtree_frozen_release(rbtree_frozen *f);
+
+// 저장된 key 개수
+size_t rbtree_frozen_size(const rbtree_frozen *f);
+
+// key가 있으면 1, 없으면 0 반환
+int rbtree_frozen_find(const rbtree_frozen *f, const key_t key);
+
+// key 이상인 첫 키를 *out에 쓰고 0 반환, 없으면 -1 반환
+int rbtree_frozen_lower_bound(const rbtree_frozen *f, const key_t key, key_t *out);
+
+// lo <= key <= hi 인 키들을 오름차순으로 최대 n개 복사하고 복사한 개수 반환 (rbtree_range 와 같음)
+int rbtree_frozen_range(const rbtree_frozen *f, const key_t lo, const key_t hi, key_t *arr, const size_t n);
+
+// --- 파일 형식 ---
+// 스냅샷은 포인터가 없으므로 메모리 배열을 그대로 파일에 쓰고 mmap 해서 바로 씀 (파싱 없음)
+//   0 .. 63   : rbtree_frozen_header (little/big endian 은 만든 기계와 같아야 함)
+//   64 ..     : keys[0 .. n] (Eytzinger 순서, keys[0] 은 비워 둠), 파일 시작 기준 64바이트 정렬
+// 링크가 배열 인덱스(keys[k] 의 자식은 2k, 2k + 1)뿐이라 어느 주소에 mmap 해도 그대로 동작
+
+#define RBTREE_FROZEN_MAGIC "RBTFRZ\0\0"
+#define RBTREE_FROZEN_VERSION 1
+#define RBTREE_FROZEN_HEADER_SIZE 64
+
+typedef struct {
+  char magic[8];      // RBTREE_FROZEN_MAGIC
+  uint32_t version;   // RBTREE_FROZEN_VERSION
+  uint32_t key_size;  // sizeof(key_t)
+  uint64_t n;         // 키 개수
+  uint32_t byte_order; // 0x01020304 을 기록한 기계의 바이트 순서 그대로
+  uint8_t reserved[RBTREE_FROZEN_HEADER_SIZE - 28];
+} rbtree_frozen_header;
+
+// 스냅샷을 path 에 저장, 성공 시 0 / 실패 시 -1
+// 임시 파일에 쓴 뒤 rename 하므로 같은 path 를 mmap 중인 프로세스는 이전 파일을 계속 봄
+// 임시 파일을 fsync 한 뒤 rename 하고 디렉터리도 fsync 하므로, 비정상 종료 뒤에는 이전 파일이나 새 파일 전체 중 하나가 남음
+int rbtree_frozen_save(const rbtree_frozen *f, const char *path);
+
+// path 를 읽기 전용으로 mmap 한 스냅샷 (페이지는 탐색하면서 필요할 때 읽힘)
+// 형식이 맞지 않거나 실패하면 NULL, 다 쓰면 rbtree_frozen_release 로 반납 (munmap)
+rbtree_frozen *rbtree_frozen_map(const char *path);
+
+// 스냅샷의 키로 수정 가능한 트리를 만듦 (rbtree_from_sorted_array, O(n)), 실패 시 NULL
+rbtree *rbtree_frozen_thaw(const rbtree_frozen *f);
+
+// 주기적으로 새로 만든 스냅샷으로 교체하기 위한 보관함
+// reader 는 acquire 로 현재 스냅샷의 참조를 얻어 탐색하고 release 하며,
+// writer 가 publish 로 바꿔 끼워도 이미 얻은 스냅샷은 release 할 때까지 유지됨
+typedef struct rbtree_frozen_holder rbtree_frozen_holder;
+
+// initial(NULL 가능)의 참조를 넘겨받는 보관함 생성, 실패 시 NULL
+rbtree_frozen_holder *new_rbtree_frozen_holder(rbtree_frozen *initial);
+
+// 보관 중인 스냅샷의 참조를 반납하고 보관함 해제
+void delete_rbtree_frozen_holder(rbtree_frozen_holder *h);
+
+// 현재 스냅샷의 참조를 하나 얻음 (비어 있으면 NULL), 락 없이 원자적 연산 몇 번으로 끝남
+rbtree_frozen *rbtree_frozen_acquire(rbtree_frozen_holder *h);
+
+// next 의 참조를 넘겨받아 현재 스냅샷을 원자적으로 교체하고, 이전 스냅샷의 참조는 반납
+// publish 끼리는 mutex 로 순서를 정하고, 교체 직전에 들어온 acquire 가 참조를 늘릴 때까지 잠깐 기다림
+void rbtree_frozen_publish(rbtree_frozen_holder *h, rbtree_frozen *next);
+
+#endif  // _RBTREE_FROZEN_H_
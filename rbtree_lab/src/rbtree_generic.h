@@ -0,0 +1,359 @@
+#ifndef _RBTREE_GENERIC_H_
+#define _RBTREE_GENERIC_H_
+
+#include <stddef.h>
+#include <stdlib.h>
+
+// 키/값 타입과 비교를 컴파일 시점에 정해 찍어 내는 레드-블랙 트리
+//
+//   RBTREE_DEFINE(name, key_type, value_type, cmp)
+//
+// 를 한 번 쓰면 name 트리(struct name), name_node 노드와 name_init / name_insert / name_find /
+// name_erase ... 가 static inline 으로 만들어짐
+// - 값은 노드 안에 같이 저장되므로 키로 찾은 노드에서 바로 값을 읽음 (별도 해시 맵, 두 번째 캐시 미스 없음)
+// - cmp(a, b) 는 a < b, a == b, a > b 에 대해 음수 / 0 / 양수를 돌려주는 매크로나 함수 이름이며,
+//   호출 자리에 그대로 펼쳐지므로 함수 포인터 호출 없이 인라인됨
+// - 같은 키를 여러 번 넣을 수 있음 (rbtree.h 와 같은 multiset), 맵처럼 쓰려면 find 후 value 를 고침
+// - nil 센티넬은 트리 구조체 안에 있으므로 트리마다 따로 할당하지 않음 (트리를 복사해서 옮기면 안 됨)
+//
+// 만들어지는 API (N = name)
+//   void     N_init(N *t)                          빈 트리로 초기화
+//   void     N_clear(N *t)                         모든 노드 해제
+//   size_t   N_size(const N *t)
+//   N_node * N_insert(N *t, key, value)            새 노드 반환, 메모리 부족 시 NULL
+//   N_node * N_find(const N *t, key)               없으면 NULL
+//   N_node * N_lower_bound(const N *t, key)        key 이상인 첫 노드, 없으면 NULL
+//   N_node * N_min / N_max(const N *t)             비어 있으면 NULL
+//   N_node * N_next / N_prev(const N *t, N_node *) 끝이면 NULL
+//   void     N_erase(N *t, N_node *p)              p 를 삭제하고 해제
+
+// 정수, 실수처럼 <, > 로 비교할 수 있는 키용 기본 비교
+#define RBTREE_CMP_NUMERIC(a, b) (((a) > (b)) - ((a) < (b)))
+
+#define RBTREE_DEFINE(name, key_type, value_type, cmp)                                     \
+  typedef struct name##_node name##_node;                                                  \
+  struct name##_node {                                                                     \
+    name##_node *parent, *left, *right;                                                    \
+    int red;                                                                               \
+    key_type key;                                                                          \
+    value_type value;                                                                      \
+  };                                                                                       \
+  typedef struct {                                                                         \
+    name##_node *root;                                                                     \
+    name##_node nil;                                                                       \
+    size_t size;                                                                           \
+  } name;                                                                                  \
+                                                                                           \
+  static inline void name##_init(name *t) {                                                \
+    t->nil.parent = t->nil.left = t->nil.right = &t->nil;                                  \
+    t->nil.red = 0;                                                                        \
+    t->root = &t->nil;                                                                     \
+    t->size = 0;                                                                           \
+  }                                                                                        \
+                                                                                           \
+  static inline void name##_clear(name *t) {                                               \
+    /* free_subtree 와 같은 방식: 왼쪽 자식을 끌어올리며 재귀 없이 해제 */                 \
+    name##_node *n = t->root;                                                              \
+    while (n != &t->nil) {                                                                 \
+      if (n->left != &t->nil) {                                                            \
+        name##_node *l = n->left;                                                          \
+        n->left = l->right;                                                                \
+        l->right = n;                                                                      \
+        n = l;                                                                             \
+      } else {                                                                             \
+        name##_node *next = n->right;                                                      \
+        free(n);                                                                           \
+        n = next;                                                                          \
+      }                                                                                    \
+    }                                                                                      \
+    name##_init(t);                                                                        \
+  }                                                                                        \
+                                                                                           \
+  static inline size_t name##_size(const name *t) {                                        \
+    return t->size;                                                                        \
+  }                                                                                        \
+                                                                                           \
+  static inline void name##_rotate_left(name *t, name##_node *x) {                         \
+    name##_node *y = x->right;                                                             \
+    x->right = y->left;                                                                    \
+    if (y->left != &t->nil) {                                                              \
+      y->left->parent = x;                                                                 \
+    }                                                                                      \
+    y->parent = x->parent;                                                                 \
+    if (x->parent == &t->nil) {                                                            \
+      t->root = y;                                                                         \
+    } else if (x == x->parent->left) {                                                     \
+      x->parent->left = y;                                                                 \
+    } else {                                                                               \
+      x->parent->right = y;                                                                \
+    }                                                                                      \
+    y->left = x;                                                                           \
+    x->parent = y;                                                                         \
+  }                                                                                        \
+                                                                                           \
+  static inline void name##_rotate_right(name *t, name##_node *x) {                        \
+    name##_node *y = x->left;                                                              \
+    x->left = y->right;                                                                    \
+    if (y->right != &t->nil) {                                                             \
+      y->right->parent = x;                                                                \
+    }                                                                                      \
+    y->parent = x->parent;                                                                 \
+    if (x->parent == &t->nil) {                                                            \
+      t->root = y;                                                                         \
+    } else if (x == x->parent->right) {                                                    \
+      x->parent->right = y;                                                                \
+    } else {                                                                               \
+      x->parent->left = y;                                                                 \
+    }                                                                                      \
+    y->right = x;                                                                          \
+    x->parent = y;                                                                         \
+  }                                                                                        \
+                                                                                           \
+  static inline name##_node *name##_insert(name *t, key_type key, value_type value) {      \
+    name##_node *z = (name##_node *)malloc(sizeof(name##_node));                           \
+    if (z == NULL) {                                                                       \
+      return NULL;                                                                         \
+    }                                                                                      \
+    z->key = key;                                                                          \
+    z->value = value;                                                                      \
+    z->left = z->right = &t->nil;                                                          \
+    z->red = 1;                                                                            \
+                                                                                           \
+    /* 같은 키는 오른쪽으로 (rbtree_insert 와 같음) */                                     \
+    name##_node *p = &t->nil, *cur = t->root;                                              \
+    int go_left = 0;                                                                       \
+    while (cur != &t->nil) {                                                               \
+      p = cur;                                                                             \
+      go_left = cmp(key, cur->key) < 0;                                                    \
+      cur = go_left ? cur->left : cur->right;                                              \
+    }                                                                                      \
+    z->parent = p;                                                                         \
+    if (p == &t->nil) {                                                                    \
+      t->root = z;                                                                         \
+    } else if (go_left) {                                                                  \
+      p->left = z;                                                                         \
+    } else {                                                                               \
+      p->right = z;                                                                        \
+    }                                                                                      \
+                                                                                           \
+    /* rb_insert_fixup 과 같은 세 가지 경우 */                                             \
+    name##_node *x = z;                                                                    \
+    while (x->parent->red) {                                                               \
+      name##_node *g = x->parent->parent;                                                  \
+      if (x->parent == g->left) {                                                          \
+        name##_node *u = g->right;                                                         \
+        if (u->red) {                                                                      \
+          x->parent->red = u->red = 0;                                                     \
+          g->red = 1;                                                                      \
+          x = g;                                                                           \
+        } else {                                                                           \
+          if (x == x->parent->right) {                                                     \
+            x = x->parent;                                                                 \
+            name##_rotate_left(t, x);                                                      \
+          }                                                                                \
+          x->parent->red = 0;                                                              \
+          g->red = 1;                                                                      \
+          name##_rotate_right(t, g);                                                       \
+        }                                                                                  \
+      } else {                                                                             \
+        name##_node *u = g->left;                                                          \
+        if (u->red) {                                                                      \
+          x->parent->red = u->red = 0;                                                     \
+          g->red = 1;                                                                      \
+          x = g;                                                                           \
+        } else {                                                                           \
+          if (x == x->parent->left) {                                                      \
+            x = x->parent;                                                                 \
+            name##_rotate_right(t, x);                                                     \
+          }                                                                                \
+          x->parent->red = 0;                                                              \
+          g->red = 1;                                                                      \
+          name##_rotate_left(t, g);                                                        \
+        }                                                                                  \
+      }                                                                                    \
+    }                                                                                      \
+    t->root->red = 0;                                                                      \
+    t->size++;                                                                             \
+    return z;                                                                              \
+  }                                                                                        \
+                                                                                           \
+  static inline name##_node *name##_find(const name *t, key_type key) {                    \
+    name##_node *cur = t->root;                                                            \
+    while (cur != &t->nil) {                                                               \
+      const int c = cmp(key, cur->key);                                                    \
+      if (c == 0) {                                                                        \
+        return cur;                                                                        \
+      }                                                                                    \
+      cur = c < 0 ? cur->left : cur->right;                                                \
+    }                                                                                      \
+    return NULL;                                                                           \
+  }                                                                                        \
+                                                                                           \
+  static inline name##_node *name##_lower_bound(const name *t, key_type key) {             \
+    name##_node *res = NULL, *cur = t->root;                                               \
+    while (cur != &t->nil) {                                                               \
+      if (cmp(cur->key, key) >= 0) {                                                       \
+        res = cur;                                                                         \
+        cur = cur->left;                                                                   \
+      } else {                                                                             \
+        cur = cur->right;                                                                  \
+      }                                                                                    \
+    }                                                                                      \
+    return res;                                                                            \
+  }                                                                                        \
+                                                                                           \
+  static inline name##_node *name##_min(const name *t) {                                   \
+    name##_node *cur = t->root;                                                            \
+    if (cur == &t->nil) {                                                                  \
+      return NULL;                                                                         \
+    }                                                                                      \
+    while (cur->left != &t->nil) {                                                         \
+      cur = cur->left;                                                                     \
+    }                                                                                      \
+    return cur;                                                                            \
+  }                                                                                        \
+                                                                                           \
+  static inline name##_node *name##_max(const name *t) {                                   \
+    name##_node *cur = t->root;                                                            \
+    if (cur == &t->nil) {                                                                  \
+      return NULL;                                                                         \
+    }                                                                                      \
+    while (cur->right != &t->nil) {                                                        \
+      cur = cur->right;                                                                    \
+    }                                                                                      \
+    return cur;                                                                            \
+  }                                                                                        \
+                                                                                           \
+  static inline name##_node *name##_next(const name *t, name##_node *p) {                  \
+    if (p->right != &t->nil) {                                                             \
+      p = p->right;                                                                        \
+      while (p->left != &t->nil) {                                                         \
+        p = p->left;                                                                       \
+      }                                                                                    \
+      return p;                                                                            \
+    }                                                                                      \
+    name##_node *q = p->parent;                                                            \
+    while (q != &t->nil && p == q->right) {                                                \
+      p = q;                                                                               \
+      q = q->parent;                                                                       \
+    }                                                                                      \
+    return q == &t->nil ? NULL : q;                                                        \
+  }                                                                                        \
+                                                                                           \
+  static inline name##_node *name##_prev(const name *t, name##_node *p) {                  \
+    if (p->left != &t->nil) {                                                              \
+      p = p->left;                                                                         \
+      while (p->right != &t->nil) {                                                        \
+        p = p->right;                                                                      \
+      }                                                                                    \
+      return p;                                                                            \
+    }                                                                                      \
+    name##_node *q = p->parent;                                                            \
+    while (q != &t->nil && p == q->left) {                                                 \
+      p = q;                                                                               \
+      q = q->parent;                                                                       \
+    }                                                                                      \
+    return q == &t->nil ? NULL : q;                                                        \
+  }                                                                                        \
+                                                                                           \
+  /* u 자리에 v 를 연결 (rb_node_change 와 같음) */                                        \
+  static inline void name##_transplant(name *t, name##_node *u, name##_node *v) {          \
+    if (u->parent == &t->nil) {                                                            \
+      t->root = v;                                                                         \
+    } else if (u == u->parent->left) {                                                     \
+      u->parent->left = v;                                                                 \
+    } else {                                                                               \
+      u->parent->right = v;                                                                \
+    }                                                                                      \
+    v->parent = u->parent;                                                                 \
+  }                                                                                        \
+                                                                                           \
+  static inline void name##_erase(name *t, name##_node *p) {                               \
+    name##_node *y = p, *x;                                                                \
+    int y_red = y->red;                                                                    \
+    if (p->left == &t->nil) {                                                              \
+      x = p->right;                                                                        \
+      name##_transplant(t, p, x);                                                          \
+    } else if (p->right == &t->nil) {                                                      \
+      x = p->left;                                                                         \
+      name##_transplant(t, p, x);                                                          \
+    } else {                                                                               \
+      y = p->right;                                                                        \
+      while (y->left != &t->nil) {                                                         \
+        y = y->left;                                                                       \
+      }                                                                                    \
+      y_red = y->red;                                                                      \
+      x = y->right;                                                                        \
+      if (y->parent == p) {                                                                \
+        x->parent = y;                                                                     \
+      } else {                                                                             \
+        name##_transplant(t, y, x);                                                        \
+        y->right = p->right;                                                               \
+        y->right->parent = y;                                                              \
+      }                                                                                    \
+      name##_transplant(t, p, y);                                                          \
+      y->left = p->left;                                                                   \
+      y->left->parent = y;                                                                 \
+      y->red = p->red;                                                                     \
+    }                                                                                      \
+                                                                                           \
+    /* rb_delete_fixup 과 같은 네 가지 경우 */                                             \
+    if (!y_red) {                                                                          \
+      while (x != t->root && !x->red) {                                                    \
+        if (x == x->parent->left) {                                                        \
+          name##_node *w = x->parent->right;                                               \
+          if (w->red) {                                                                    \
+            w->red = 0;                                                                    \
+            x->parent->red = 1;                                                            \
+            name##_rotate_left(t, x->parent);                                              \
+            w = x->parent->right;                                                          \
+          }                                                                                \
+          if (!w->left->red && !w->right->red) {                                           \
+            w->red = 1;                                                                    \
+            x = x->parent;                                                                 \
+          } else {                                                                         \
+            if (!w->right->red) {                                                          \
+              w->left->red = 0;                                                            \
+              w->red = 1;                                                                  \
+              name##_rotate_right(t, w);                                                   \
+              w = x->parent->right;                                                        \
+            }                                                                              \
+            w->red = x->parent->red;                                                       \
+            x->parent->red = 0;                                                            \
+            w->right->red = 0;                                                             \
+            name##_rotate_left(t, x->parent);                                              \
+            x = t->root;                                                                   \
+          }                                                                                \
+        } else {                                                                           \
+          name##_node *w = x->parent->left;                                                \
+          if (w->red) {                                                                    \
+            w->red = 0;                                                                    \
+            x->parent->red = 1;                                                            \
+            name##_rotate_right(t, x->parent);                                             \
+            w = x->parent->left;                                                           \
+          }                                                                                \
+          if (!w->right->red && !w->left->red) {                                           \
+            w->red = 1;                                                                    \
+            x = x->parent;                                                                 \
+          } else {                                                                         \
+            if (!w->left->red) {                                                           \
+              w->right->red = 0;                                                           \
+              w->red = 1;                                                                  \
+              name##_rotate_left(t, w);                                                    \
+              w = x->parent->left;                                                         \
+            }                                                                              \
+            w->red = x->parent->red;                                                       \
+            x->parent->red = 0;                                                            \
+            w->left->red = 0;                                                              \
+            name##_rotate_right(t, x->parent);                                             \
+            x = t->root;                                                                   \
+          }                                                                                \
+        }                                                                                  \
+      }                                                                                    \
+      x->red = 0;                                                                          \
+    }                                                                                      \
+    free(p);                                                                               \
+    t->size--;                                                                             \
+  }
+
+#endif  // _RBTREE_GENERIC_H_
@@ -0,0 +1,234 @@
+#include "rbtree_parallel.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+// 노드가 이보다 적으면 스레드를 만드는 비용이 더 크므로 한 스레드로 처리
+#define RBTREE_PARALLEL_MIN_SIZE 4096
+
+// 스레드 하나당 작업 단위(서브트리) 수, 크기가 고르지 않아도 먼저 끝난 스레드가 나머지를 가져감
+#define RBTREE_PARALLEL_TASKS_PER_THREAD 8
+
+// 작업을 자르는 최대 깊이 (서브트리 최대 2^16 개)
+#define RBTREE_PARALLEL_MAX_DEPTH 16
+
+// 한 번에 쓰는 최대 스레드 수 (이보다 많이 주면 이 값으로 줄임, 스레드 id 배열을 스택에 고정 크기로 둠)
+#define RBTREE_PARALLEL_MAX_THREADS 256
+
+// 중위 순서로 늘어놓은 작업 단위: 서브트리 전체 또는 위쪽 노드 하나
+typedef struct {
+  node_t *root;
+  int whole;     // 1이면 root의 서브트리 전체, 0이면 root 노드 하나
+  size_t count;  // 담긴 키 수
+  size_t offset; // 출력 배열에서 시작 위치
+} rb_segment;
+
+typedef struct {
+  const rbtree *tree;
+  rb_segment *segs;
+  size_t nsegs;
+  size_t next; // 다음에 가져갈 작업 번호 (원자적으로 증가)
+  key_t *arr;
+  size_t n;
+  void (*work)(const rbtree *, rb_segment *, key_t *, size_t);
+} rb_job;
+
+// max_depth 아래는 서브트리 하나로, 위는 노드 하나씩 segs에 중위 순서로 추가
+static void collect(const rbtree *t, node_t *p, const int depth, const int max_depth, rb_segment *segs,
+                    size_t *nsegs) {
+  if (p == t->nil) {
+    return;
+  }
+  if (depth == max_depth) {
+    segs[(*nsegs)++] = (rb_segment){p, 1, 0, 0};
+    return;
+  }
+  collect(t, p->left, depth + 1, max_depth, segs, nsegs);
+  segs[(*nsegs)++] = (rb_segment){p, 0, rb_count(p), 0};
+  collect(t, p->right, depth + 1, max_depth, segs, nsegs);
+}
+
+// 서브트리 p의 키 수 (중위 순회가 p의 서브트리를 벗어나는 지점까지 셈, RBTREE_COUNTED 면 count 의 합)
+static size_t subtree_count(const rbtree *t, node_t *p) {
+#ifdef RBTREE_ORDER_STATS
+  return p->size;
+#else
+  node_t *end = rb_tree_successor(t, rb_tree_max_subtree(t, p));
+  size_t count = 0;
+  for (node_t *cur = rb_tree_min_subtree(t, p); cur != end; cur = rb_tree_successor(t, cur)) {
+    count += rb_count(cur);
+  }
+  return count;
+#endif
+}
+
+static void count_work(const rbtree *t, rb_segment *seg, key_t *arr, size_t n) {
+  if (seg->whole) {
+    seg->count = subtree_count(t, seg->root);
+  }
+}
+
+static void copy_work(const rbtree *t, rb_segment *seg, key_t *arr, size_t n) {
+  if (seg->offset >= n) {
+    return;
+  }
+  size_t count = seg->count < n - seg->offset ? seg->count : n - seg->offset;
+  key_t *out = arr + seg->offset;
+  node_t *cur = seg->whole ? rb_tree_min_subtree(t, seg->root) : seg->root;
+  // 노드 하나가 키 rb_count(cur) 개를 채움
+  size_t left = rb_count(cur);
+  for (size_t i = 0; i < count; i++) {
+    out[i] = cur->key;
+    if (--left == 0 && i + 1 < count) {
+      cur = rb_tree_successor(t, cur);
+      left = rb_count(cur);
+    }
+  }
+}
+
+// 위쪽 노드는 그대로 두고 서브트리만 해제 (free_subtree 는 부모 포인터를 쓰지 않음)
+static void free_work(const rbtree *t, rb_segment *seg, key_t *arr, size_t n) {
+  if (seg->whole) {
+    free_subtree((rbtree *)t, seg->root);
+  }
+}
+
+static void *job_worker(void *p) {
+  rb_job *job = p;
+  for (;;) {
+    size_t i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+    if (i >= job->nsegs) {
+      return NULL;
+    }
+    job->work(job->tree, &job->segs[i], job->arr, job->n);
+  }
+}
+
+// 호출한 스레드를 포함해 nthreads 개 스레드로 job 실행
+// 스레드 생성에 실패하면 만든 스레드만으로 진행 (최소한 호출한 스레드가 모두 처리)
+static void run_job(rb_job *job, const int nthreads) {
+  pthread_t tid[RBTREE_PARALLEL_MAX_THREADS];
+  int started = 0;
+  job->next = 0;
+  for (int i = 1; i < nthreads; i++) {
+    if (pthread_create(&tid[started], NULL, job_worker, job) == 0) {
+      started++;
+    }
+  }
+  job_worker(job);
+  for (int i = 0; i < started; i++) {
+    pthread_join(tid[i], NULL);
+  }
+}
+
+// 작업을 자를 깊이: 서브트리 수(2^depth)가 스레드당 작업 수를 채우는 가장 얕은 깊이
+static int split_depth(const int nthreads) {
+  int depth = 0;
+  while (depth < RBTREE_PARALLEL_MAX_DEPTH &&
+         ((size_t)1 << depth) < (size_t)nthreads * RBTREE_PARALLEL_TASKS_PER_THREAD) {
+    depth++;
+  }
+  return depth;
+}
+
+// 작업 목록 생성, 실패하면 NULL
+static rb_segment *make_segments(const rbtree *t, const int nthreads, size_t *nsegs) {
+  const int depth = split_depth(nthreads);
+  // 깊이 depth 까지의 노드 2^depth - 1 개 + 깊이 depth 의 서브트리 2^depth 개
+  rb_segment *segs = malloc((((size_t)2 << depth) - 1) * sizeof(rb_segment));
+  if (segs == NULL) {
+    return NULL;
+  }
+  *nsegs = 0;
+  collect(t, t->root, 0, depth, segs, nsegs);
+  return segs;
+}
+
+int rbtree_to_array_parallel(const rbtree *t, key_t *arr, const size_t n, int nthreads) {
+  if (nthreads > RBTREE_PARALLEL_MAX_THREADS) {
+    nthreads = RBTREE_PARALLEL_MAX_THREADS;
+  }
+  if (nthreads <= 1 || rbtree_size(t) < RBTREE_PARALLEL_MIN_SIZE) {
+    return rbtree_to_array(t, arr, n);
+  }
+  rb_job job = {t, NULL, 0, 0, arr, n, count_work};
+  job.segs = make_segments(t, nthreads, &job.nsegs);
+  if (job.segs == NULL) {
+    return rbtree_to_array(t, arr, n);
+  }
+
+  // 1) 서브트리 크기 (ORDER_STATS 면 바로 읽히므로 스레드를 쓰지 않음)
+#ifdef RBTREE_ORDER_STATS
+  job.next = 0;
+  job_worker(&job);
+#else
+  run_job(&job, nthreads);
+#endif
+
+  // 2) 앞선 작업들의 크기 합이 출력 위치
+  size_t offset = 0;
+  for (size_t i = 0; i < job.nsegs; i++) {
+    job.segs[i].offset = offset;
+    offset += job.segs[i].count;
+  }
+
+  // 3) 각자 자기 구간을 채움
+  job.work = copy_work;
+  run_job(&job, nthreads);
+
+  free(job.segs);
+  return (int)(offset < n ? offset : n);
+}
+
+void delete_rbtree_parallel(rbtree *t, int nthreads) {
+  if (t == NULL) {
+    return;
+  }
+  if (nthreads > RBTREE_PARALLEL_MAX_THREADS) {
+    nthreads = RBTREE_PARALLEL_MAX_THREADS;
+  }
+  if (t->pool != NULL || nthreads <= 1 || rbtree_size(t) < RBTREE_PARALLEL_MIN_SIZE) {
+    delete_rbtree(t);
+    return;
+  }
+  rb_job job = {t, NULL, 0, 0, NULL, 0, free_work};
+  job.segs = make_segments(t, nthreads, &job.nsegs);
+  if (job.segs == NULL) {
+    delete_rbtree(t);
+    return;
+  }
+
+  run_job(&job, nthreads);
+
+  // 남은 위쪽 노드들을 해제하고, 빈 트리가 된 t 는 delete_rbtree 로 정리
+  for (size_t i = 0; i < job.nsegs; i++) {
+    if (!job.segs[i].whole) {
+      rb_free_node(t, job.segs[i].root);
+    }
+  }
+  free(job.segs);
+  t->root = t->leftmost = t->rightmost = rb_nil(t);
+  delete_rbtree(t);
+}
+
+static void *delete_worker(void *p) {
+  rbtree_delete_step(p, SIZE_MAX);
+  return NULL;
+}
+
+int rbtree_delete_async(rbtree *t, pthread_t *thread) {
+  rbtree_reaper *r = rbtree_delete_begin(t);
+  if (r == NULL) {
+    return 0;
+  }
+  pthread_t tid;
+  if (pthread_create(&tid, NULL, delete_worker, r) != 0) {
+    rbtree_delete_step(r, SIZE_MAX);
+    return -1;
+  }
+  if (thread != NULL) {
+    *thread = tid;
+  } else {
+    pthread_detach(tid);
+  }
+  return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef _RBTREE_PARALLEL_H_
+#define _RBTREE_PARALLEL_H_
+
+#include "rbtree.h"
+#include <pthread.h>
+
+// 트리 전체를 훑는 작업을 여러 스레드로 나누어 처리
+//
+// 루트부터 몇 단계 아래의 서브트리들을 작업 단위로 잘라 스레드들이 나누어 가짐
+// 각 서브트리의 출력 위치는 앞선 서브트리들의 크기 합으로 미리 정해지므로 스레드끼리 동기화가 없음
+// (-DRBTREE_ORDER_STATS 면 node->size 를 바로 쓰고, 아니면 먼저 병렬로 크기를 셈)
+// 트리를 수정하는 다른 호출과 동시에 쓰면 안 됨
+// nthreads 는 256 개까지만 쓰고 그보다 크면 256 으로 줄임
+
+// rbtree_to_array 와 같은 결과를 nthreads 개 스레드로 만듦 (호출한 스레드도 작업에 참여)
+// nthreads 가 1 이하이거나 트리가 작으면 rbtree_to_array 와 동일
+int rbtree_to_array_parallel(const rbtree *t, key_t *arr, const size_t n, const int nthreads);
+
+// delete_rbtree 와 같지만 노드 해제를 nthreads 개 스레드로 나누어 수행
+// 풀을 쓰는 트리는 slab 해제만 하면 되므로 delete_rbtree 와 동일
+void delete_rbtree_parallel(rbtree *t, const int nthreads);
+
+// 트리를 O(1)에 떼어 내고 (rbtree_delete_begin) 노드 해제는 새 백그라운드 스레드에서 수행
+// thread 가 NULL 이 아니면 만든 스레드를 돌려주므로 호출한 쪽이 pthread_join 해야 하고, NULL 이면 detach 된 스레드
+// 성공 시 0, 스레드를 만들지 못하면 호출한 스레드에서 바로 해제하고 -1
+int rbtree_delete_async(rbtree *t, pthread_t *thread);
+
+#endif  // _RBTREE_PARALLEL_H_
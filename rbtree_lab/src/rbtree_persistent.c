@@ -0,0 +1,455 @@
+#include "rbtree_persistent.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// 경로 스택 크기 (레드-블랙 트리의 높이는 2 log2(n + 1) 이하이므로 64비트 크기에 충분)
+#define RBTREE_MAX_HEIGHT 128
+
+// 여러 버전이 공유하는 노드
+// 한 번 공개된 버전에서 닿는 노드는 절대 고치지 않고, 고칠 일이 생기면 복사본을 만듦
+// gen 은 노드를 만든 쓰기 연산 번호: 지금 진행 중인 연산이 만든 노드(gen 이 같음)는 아직 어느 버전에도
+// 공개되지 않았으므로 바로 고쳐도 됨
+typedef struct pnode_t {
+  key_t key;
+  color_t color;
+  uint32_t refs;           // 이 노드를 가리키는 부모 / 루트 수 (원자적으로 증감)
+  uint64_t gen;
+  struct pnode_t *child[2];
+} pnode_t;
+
+struct rbtree_persistent {
+  pthread_mutex_t lock;       // root / size 교체와 snapshot 의 참조 증가를 한 번에 하기 위한 짧은 구간
+  pthread_mutex_t write_lock; // writer 끼리의 직렬화 (새 버전을 만드는 동안 잡고 있음)
+  pnode_t *root;              // 현재 버전 (비어 있으면 NULL)
+  size_t size;
+  uint64_t gen;               // 마지막 쓰기 연산 번호 (write_lock 아래에서만 바뀜)
+};
+
+struct rbtree_version {
+  pnode_t *root;
+  size_t size;
+};
+
+// --- 참조 수 ---
+
+static inline void pnode_ref(pnode_t *n) {
+  if (n != NULL) {
+    __atomic_add_fetch(&n->refs, 1, __ATOMIC_RELAXED);
+  }
+}
+
+// 마지막 참조면 해제하고 자식들의 참조도 반납 (해제되는 노드만 따라 내려가므로 깊이는 트리 높이 이하)
+static void pnode_unref(pnode_t *n) {
+  while (n != NULL && __atomic_sub_fetch(&n->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+    pnode_t *l = n->child[0];
+    pnode_t *r = n->child[1];
+    free(n);
+    pnode_unref(l);
+    n = r;
+  }
+}
+
+static inline int is_red(const pnode_t *n) {
+  return n != NULL && n->color == RBTREE_RED;
+}
+
+// *link 가 가리키는 노드를 이번 연산 gen 에서 고칠 수 있게 만들어 반환 (메모리 부족 시 NULL, *link 그대로)
+// 이전 버전의 노드면 복사본으로 바꿔 끼우고, 자식은 복사본과 원본이 함께 가리키므로 참조를 늘림
+static pnode_t *own(const uint64_t gen, pnode_t **link) {
+  pnode_t *n = *link;
+  if (n == NULL || n->gen == gen) {
+    return n;
+  }
+  pnode_t *c = malloc(sizeof(pnode_t));
+  if (c == NULL) {
+    return NULL;
+  }
+  c->key = n->key;
+  c->color = n->color;
+  c->refs = 1;
+  c->gen = gen;
+  c->child[0] = n->child[0];
+  c->child[1] = n->child[1];
+  pnode_ref(c->child[0]);
+  pnode_ref(c->child[1]);
+  *link = c;
+  // 작업 중인 트리가 들고 있던 원본 참조를 반납 (다른 버전이 가리키고 있으면 살아 있음)
+  pnode_unref(n);
+  return c;
+}
+
+// *link 의 child[!dir] 를 올리고 *link 를 dir 방향으로 내림
+// 두 노드 모두 이번 gen 에서 고칠 수 있는 노드여야 하며, 옮겨지는 손자는 부모만 바뀌므로 참조 수는 그대로
+static void rotate(pnode_t **link, const int dir) {
+  pnode_t *n = *link;
+  pnode_t *s = n->child[!dir];
+  n->child[!dir] = s->child[dir];
+  s->child[dir] = n;
+  *link = s;
+}
+
+// 경로 스택에서 i 번째 노드를 가리키는 자리 (0 이면 루트)
+static inline pnode_t **path_link(pnode_t **root, pnode_t **stack, const int *dirs, const int i) {
+  return i == 0 ? root : &stack[i - 1]->child[dirs[i - 1]];
+}
+
+// --- 생성 / 해제 ---
+
+rbtree_persistent *new_rbtree_persistent(void) {
+  rbtree_persistent *p = malloc(sizeof(rbtree_persistent));
+  if (p == NULL) {
+    return NULL;
+  }
+  pthread_mutex_init(&p->lock, NULL);
+  pthread_mutex_init(&p->write_lock, NULL);
+  p->root = NULL;
+  p->size = 0;
+  p->gen = 0;
+  return p;
+}
+
+void delete_rbtree_persistent(rbtree_persistent *p) {
+  if (p == NULL) {
+    return;
+  }
+  pnode_unref(p->root);
+  pthread_mutex_destroy(&p->write_lock);
+  pthread_mutex_destroy(&p->lock);
+  free(p);
+}
+
+// 작업이 끝난 root 를 현재 버전으로 바꿔 끼움 (write_lock 을 잡은 상태에서 호출)
+static void publish(rbtree_persistent *p, pnode_t *root, const size_t size) {
+  pthread_mutex_lock(&p->lock);
+  pnode_t *old = p->root;
+  p->root = root;
+  p->size = size;
+  pthread_mutex_unlock(&p->lock);
+  // old 를 스냅샷으로 잡은 reader 가 있으면 마지막 release 에서 해제됨
+  pnode_unref(old);
+}
+
+// --- 쓰기 ---
+
+int rbtree_persistent_insert(rbtree_persistent *p, const key_t key) {
+  if (p == NULL) {
+    return -1;
+  }
+  pthread_mutex_lock(&p->write_lock);
+  const uint64_t gen = ++p->gen;
+  pnode_t *n = malloc(sizeof(pnode_t));
+  if (n == NULL) {
+    pthread_mutex_unlock(&p->write_lock);
+    return -1;
+  }
+  n->key = key;
+  n->color = RBTREE_RED;
+  n->refs = 1;
+  n->gen = gen;
+  n->child[0] = n->child[1] = NULL;
+
+  // 현재 버전의 루트를 하나 더 잡고 시작해서, 지나가는 노드를 own 으로 복사하며 내려감
+  pnode_t *root = p->root;
+  pnode_ref(root);
+  pnode_t *stack[RBTREE_MAX_HEIGHT];
+  int dirs[RBTREE_MAX_HEIGHT];
+  int top = 0;
+  pnode_t **link = &root;
+  while (*link != NULL) {
+    pnode_t *cur = own(gen, link);
+    if (cur == NULL) {
+      free(n);
+      pnode_unref(root);
+      pthread_mutex_unlock(&p->write_lock);
+      return -1;
+    }
+    // 같은 키는 오른쪽으로
+    const int dir = !(key < cur->key);
+    stack[top] = cur;
+    dirs[top] = dir;
+    top++;
+    link = &cur->child[dir];
+  }
+  *link = n;
+
+  // 아래에서 위로 올라가며 복구 (경로 위의 노드는 모두 이번 gen 이라 바로 고침)
+  while (top > 0 && is_red(stack[top - 1])) {
+    // 부모가 레드이면 루트가 아니므로 조부모가 있음
+    pnode_t *parent = stack[top - 1];
+    pnode_t *g = stack[top - 2];
+    const int pd = dirs[top - 2];
+    if (is_red(g->child[!pd])) {
+      // 삼촌도 레드: 색만 바꾸고 조부모에서 다시 확인 (삼촌은 경로 밖이므로 복사해서 칠함)
+      pnode_t *uncle = own(gen, &g->child[!pd]);
+      if (uncle == NULL) {
+        pnode_unref(root);
+        pthread_mutex_unlock(&p->write_lock);
+        return -1;
+      }
+      parent->color = RBTREE_BLACK;
+      uncle->color = RBTREE_BLACK;
+      g->color = RBTREE_RED;
+      top -= 2;
+      continue;
+    }
+    if (dirs[top - 1] != pd) {
+      // 안쪽 손자면 부모에서 한 번 돌려 바깥쪽으로 맞춤
+      rotate(&g->child[pd], pd);
+      parent = g->child[pd];
+    }
+    parent->color = RBTREE_BLACK;
+    g->color = RBTREE_RED;
+    rotate(path_link(&root, stack, dirs, top - 2), !pd);
+    break;
+  }
+  root->color = RBTREE_BLACK;
+
+  publish(p, root, p->size + 1);
+  pthread_mutex_unlock(&p->write_lock);
+  return 0;
+}
+
+int rbtree_persistent_erase(rbtree_persistent *p, const key_t key) {
+  if (p == NULL) {
+    return -1;
+  }
+  pthread_mutex_lock(&p->write_lock);
+  const uint64_t gen = ++p->gen;
+  pnode_t *root = p->root;
+  pnode_ref(root);
+  pnode_t *stack[RBTREE_MAX_HEIGHT + 1]; // 복구 1번 경우에서 한 칸 늘어남
+  int dirs[RBTREE_MAX_HEIGHT + 1];
+  int top = 0;
+
+  // key 를 가진 노드까지 복사하며 내려감
+  pnode_t **link = &root;
+  pnode_t *z;
+  for (;;) {
+    if (*link == NULL) {
+      // 없음: 복사해 둔 경로는 버림
+      goto fail;
+    }
+    z = own(gen, link);
+    if (z == NULL) {
+      goto fail;
+    }
+    if (z->key == key) {
+      break;
+    }
+    const int dir = z->key < key;
+    stack[top] = z;
+    dirs[top] = dir;
+    top++;
+    link = &z->child[dir];
+  }
+
+  // 자식이 둘이면 직후 노드의 키를 z 로 옮기고 직후 노드를 떼어 냄
+  pnode_t *y = z;
+  if (z->child[0] != NULL && z->child[1] != NULL) {
+    stack[top] = z;
+    dirs[top] = 1;
+    top++;
+    link = &z->child[1];
+    for (;;) {
+      y = own(gen, link);
+      if (y == NULL) {
+        goto fail;
+      }
+      if (y->child[0] == NULL) {
+        break;
+      }
+      stack[top] = y;
+      dirs[top] = 0;
+      top++;
+      link = &y->child[0];
+    }
+    z->key = y->key;
+  }
+
+  // y 는 자식이 하나 이하: 자식을 y 자리에 올림 (y 가 들고 있던 참조를 그대로 넘김)
+  pnode_t *x = y->child[y->child[0] == NULL];
+  *link = x;
+  const int removed_black = y->color == RBTREE_BLACK;
+  free(y);
+
+  if (removed_black) {
+    // x 자리가 블랙 하나 모자람 (x 는 stack[top - 1] 의 dirs[top - 1] 쪽 자식, top 이 0 이면 루트)
+    while (top > 0 && !is_red(x)) {
+      pnode_t *parent = stack[top - 1];
+      const int d = dirs[top - 1];
+      pnode_t *s = own(gen, &parent->child[!d]);
+      if (s == NULL) {
+        goto fail;
+      }
+      if (is_red(s)) {
+        // 1: 형제가 레드면 부모에서 돌려 블랙 형제를 만듦, 부모가 한 칸 내려가므로 스택에 s 를 끼움
+        s->color = RBTREE_BLACK;
+        parent->color = RBTREE_RED;
+        rotate(path_link(&root, stack, dirs, top - 1), d);
+        stack[top - 1] = s;
+        dirs[top - 1] = d;
+        stack[top] = parent;
+        dirs[top] = d;
+        top++;
+        continue;
+      }
+      if (!is_red(s->child[0]) && !is_red(s->child[1])) {
+        // 2: 조카가 모두 블랙이면 형제를 레드로 칠하고 모자란 블랙을 부모로 올림
+        s->color = RBTREE_RED;
+        x = parent;
+        top--;
+        continue;
+      }
+      if (!is_red(s->child[!d])) {
+        // 3: 먼 조카가 블랙이면 형제에서 돌려 가까운 조카를 올림
+        pnode_t *near = own(gen, &s->child[d]);
+        if (near == NULL) {
+          goto fail;
+        }
+        near->color = RBTREE_BLACK;
+        s->color = RBTREE_RED;
+        rotate(&parent->child[!d], !d);
+        s = near;
+      }
+      // 4: 먼 조카를 블랙으로 칠하고 부모에서 돌리면 끝
+      pnode_t *far = own(gen, &s->child[!d]);
+      if (far == NULL) {
+        goto fail;
+      }
+      s->color = parent->color;
+      parent->color = RBTREE_BLACK;
+      far->color = RBTREE_BLACK;
+      rotate(path_link(&root, stack, dirs, top - 1), d);
+      x = NULL;
+      break;
+    }
+    if (is_red(x)) {
+      // 레드 x 를 블랙으로 칠해 모자란 블랙을 채움 (y 의 자식이었다면 아직 이전 버전 노드일 수 있음)
+      x = own(gen, path_link(&root, stack, dirs, top));
+      if (x == NULL) {
+        goto fail;
+      }
+      x->color = RBTREE_BLACK;
+    }
+  }
+
+  publish(p, root, p->size - 1);
+  pthread_mutex_unlock(&p->write_lock);
+  return 0;
+
+fail:
+  // 작업 중인 트리를 버리면 복사본은 해제되고 공유하던 노드의 참조 수는 원래대로 돌아감
+  pnode_unref(root);
+  pthread_mutex_unlock(&p->write_lock);
+  return -1;
+}
+
+size_t rbtree_persistent_size(rbtree_persistent *p) {
+  pthread_mutex_lock(&p->lock);
+  const size_t size = p->size;
+  pthread_mutex_unlock(&p->lock);
+  return size;
+}
+
+// --- 스냅샷 ---
+
+rbtree_version *rbtree_snapshot(rbtree_persistent *p) {
+  rbtree_version *v = malloc(sizeof(rbtree_version));
+  if (v == NULL) {
+    return NULL;
+  }
+  pthread_mutex_lock(&p->lock);
+  v->root = p->root;
+  v->size = p->size;
+  pnode_ref(v->root);
+  pthread_mutex_unlock(&p->lock);
+  return v;
+}
+
+void rbtree_version_release(rbtree_version *v) {
+  if (v == NULL) {
+    return;
+  }
+  pnode_unref(v->root);
+  free(v);
+}
+
+size_t rbtree_version_size(const rbtree_version *v) {
+  return v->size;
+}
+
+int rbtree_version_find(const rbtree_version *v, const key_t key) {
+  const pnode_t *cur = v->root;
+  while (cur != NULL && cur->key != key) {
+    cur = cur->child[cur->key < key];
+  }
+  return cur != NULL;
+}
+
+int rbtree_version_lower_bound(const rbtree_version *v, const key_t key, key_t *out) {
+  const pnode_t *cur = v->root;
+  const pnode_t *best = NULL;
+  while (cur != NULL) {
+    if (cur->key < key) {
+      cur = cur->child[1];
+    } else {
+      best = cur;
+      cur = cur->child[0];
+    }
+  }
+  if (best == NULL) {
+    return -1;
+  }
+  *out = best->key;
+  return 0;
+}
+
+int rbtree_version_to_array(const rbtree_version *v, key_t *arr, const size_t n) {
+  if (v == NULL || arr == NULL) {
+    return 0;
+  }
+  // parent 포인터가 없으므로 지나온 노드를 스택에 쌓으며 중위 순회
+  const pnode_t *stack[RBTREE_MAX_HEIGHT];
+  int top = 0;
+  size_t count = 0;
+  const pnode_t *cur = v->root;
+  while (count < n && (cur != NULL || top > 0)) {
+    while (cur != NULL) {
+      stack[top++] = cur;
+      cur = cur->child[0];
+    }
+    cur = stack[--top];
+    arr[count++] = cur->key;
+    cur = cur->child[1];
+  }
+  return (int)count;
+}
+
+// 서브트리의 black height, 규칙이 어긋나면 -1 (키는 [*lo, hi] 안에 있어야 하고 중위 순서로 *lo 를 갱신)
+static int check_subtree(const pnode_t *n, const key_t **lo, const int red_parent) {
+  if (n == NULL) {
+    return 0;
+  }
+  if (__atomic_load_n(&n->refs, __ATOMIC_RELAXED) == 0 || (red_parent && n->color == RBTREE_RED)) {
+    return -1;
+  }
+  const int hl = check_subtree(n->child[0], lo, n->color == RBTREE_RED);
+  if (hl < 0 || (*lo != NULL && **lo > n->key)) {
+    return -1;
+  }
+  *lo = &n->key;
+  const int hr = check_subtree(n->child[1], lo, n->color == RBTREE_RED);
+  if (hr < 0 || hl != hr) {
+    return -1;
+  }
+  return hl + (n->color == RBTREE_BLACK);
+}
+
+int rbtree_version_check(const rbtree_version *v) {
+  if (is_red(v->root)) {
+    return -1;
+  }
+  const key_t *lo = NULL;
+  return check_subtree(v->root, &lo, 0);
+}
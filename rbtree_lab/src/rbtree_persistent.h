@@ -0,0 +1,56 @@
+#ifndef _RBTREE_PERSISTENT_H_
+#define _RBTREE_PERSISTENT_H_
+
+#include "rbtree.h"
+
+// 경로 복사(path copying) 방식의 영속 레드-블랙 트리
+//
+// - insert / erase 는 지나가는 O(log n) 노드(와 회전/색 바꾸기로 건드리는 형제)만 복사해 새 루트를 만들고,
+//   나머지 서브트리는 이전 버전과 그대로 공유함. 이전 루트는 바뀌지 않으므로 계속 유효
+// - rbtree_snapshot 은 현재 루트의 참조를 하나 늘릴 뿐이라 O(1)이고, 스냅샷은 락 없이 읽음
+// - 노드마다 참조 수(원자적 증감)를 두어, 어떤 버전에서도 닿지 않게 된 노드는 마지막 release 에서 해제
+// writer 끼리는 내부 mutex 로 하나씩 실행되며, 스냅샷을 잡고 있는 reader 가 writer 를 막지 않음
+// (루트를 바꿔 끼우는 짧은 구간만 snapshot 과 같은 락을 잡음)
+// 노드에 parent 포인터가 없으므로 rbtree 의 node_t 와는 다른 내부 노드를 씀
+
+typedef struct rbtree_persistent rbtree_persistent;
+typedef struct rbtree_version rbtree_version;
+
+// 빈 영속 트리 생성, 실패 시 NULL
+rbtree_persistent *new_rbtree_persistent(void);
+
+// 현재 버전의 참조를 반납하고 트리 해제 (이미 받은 스냅샷은 release 할 때까지 유효)
+void delete_rbtree_persistent(rbtree_persistent *p);
+
+// key 삽입으로 새 버전을 만들어 현재 버전으로 바꿈, 성공 시 0 / 메모리 부족 시 -1 (현재 버전 그대로)
+int rbtree_persistent_insert(rbtree_persistent *p, const key_t key);
+
+// key 하나를 지운 새 버전으로 바꿈, 성공 시 0 / 없거나 메모리 부족이면 -1 (현재 버전 그대로)
+int rbtree_persistent_erase(rbtree_persistent *p, const key_t key);
+
+// 현재 버전의 key 개수
+size_t rbtree_persistent_size(rbtree_persistent *p);
+
+// 현재 버전의 스냅샷 (O(1)), 다 쓰면 rbtree_version_release 로 반납, 실패 시 NULL
+// 스냅샷은 바뀌지 않으므로 여러 스레드가 락 없이 동시에 읽을 수 있음
+rbtree_version *rbtree_snapshot(rbtree_persistent *p);
+
+// 스냅샷 반납 (이 버전에서만 닿는 노드는 여기서 해제)
+void rbtree_version_release(rbtree_version *v);
+
+// 스냅샷의 key 개수
+size_t rbtree_version_size(const rbtree_version *v);
+
+// key가 있으면 1, 없으면 0 반환
+int rbtree_version_find(const rbtree_version *v, const key_t key);
+
+// key 이상인 첫 키를 *out에 쓰고 0 반환, 없으면 -1 반환
+int rbtree_version_lower_bound(const rbtree_version *v, const key_t key, key_t *out);
+
+// 스냅샷의 키들을 오름차순으로 최대 n개 복사하고 복사한 개수 반환
+int rbtree_version_to_array(const rbtree_version *v, key_t *arr, const size_t n);
+
+// 스냅샷이 탐색 트리 / 색 규칙을 지키는지 확인 (테스트용), 맞으면 black height, 어긋나면 -1
+int rbtree_version_check(const rbtree_version *v);
+
+#endif  // _RBTREE_PERSISTENT_H_
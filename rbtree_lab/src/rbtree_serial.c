@@ -0,0 +1,231 @@
+#include "rbtree_serial.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SERIAL_MAGIC "RBTS"
+#define SERIAL_VERSION 1
+#define SERIAL_HEADER_SIZE 8
+
+// 64비트 값의 varint 최대 길이
+#define VARINT_MAX_BYTES 10
+
+_Static_assert(sizeof(key_t) <= sizeof(int64_t), "키는 64비트 안에 들어가야 함");
+
+// 부호 있는 값을 작은 절댓값일수록 짧은 부호 없는 값으로 (0, -1, 1, -2 -> 0, 1, 2, 3)
+static inline uint64_t zigzag(const int64_t v) {
+  return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t unzigzag(const uint64_t u) {
+  return (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+}
+
+// 7비트씩 아래부터, 이어지는 바이트가 있으면 최상위 비트를 세움
+static inline size_t put_varint(uint8_t *out, uint64_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = (uint8_t)v;
+  return n;
+}
+
+// --- 직렬화 ---
+
+typedef struct {
+  rbtree_write_fn write;
+  void *ctx;
+  uint8_t buf[RBTREE_SERIAL_CHUNK];
+  size_t len;
+} serial_writer;
+
+// 모은 청크를 길이와 함께 내보냄
+static int flush_chunk(serial_writer *w) {
+  uint8_t head[VARINT_MAX_BYTES];
+  const size_t hn = put_varint(head, w->len);
+  if (w->write(w->ctx, head, hn) != 0 || w->write(w->ctx, w->buf, w->len) != 0) {
+    return -1;
+  }
+  w->len = 0;
+  return 0;
+}
+
+int rbtree_serialize(const rbtree *t, rbtree_write_fn write, void *ctx) {
+  if (t == NULL || write == NULL) {
+    return -1;
+  }
+  uint8_t head[SERIAL_HEADER_SIZE + VARINT_MAX_BYTES] = {0};
+  memcpy(head, SERIAL_MAGIC, 4);
+  head[4] = SERIAL_VERSION;
+  head[5] = sizeof(key_t);
+  const size_t hn = SERIAL_HEADER_SIZE + put_varint(head + SERIAL_HEADER_SIZE, rbtree_size(t));
+  if (write(ctx, head, hn) != 0) {
+    return -1;
+  }
+
+  serial_writer w;
+  w.write = write;
+  w.ctx = ctx;
+  w.len = 0;
+  key_t prev = 0;
+  for (node_t *cur = rbtree_min(t); cur != t->nil; cur = rb_tree_successor(t, cur)) {
+    // RBTREE_COUNTED 의 묶인 같은 키도 하나씩 내보내므로 형식은 빌드 모드와 무관 (반복은 차이 0 으로 1바이트)
+    for (size_t c = rb_count(cur); c > 0; c--) {
+      // 키가 청크 경계에 걸치지 않게 남은 칸이 모자라면 먼저 내보냄
+      if (RBTREE_SERIAL_CHUNK - w.len < VARINT_MAX_BYTES && flush_chunk(&w) != 0) {
+        return -1;
+      }
+      // 청크마다 첫 키는 절댓값이라 청크를 따로 풀 수 있음, 나머지는 오름차순이므로 차이가 0 이상
+      const uint64_t v = w.len == 0 ? zigzag(cur->key) : (uint64_t)((int64_t)cur->key - (int64_t)prev);
+      w.len += put_varint(w.buf + w.len, v);
+      prev = cur->key;
+    }
+  }
+  if (w.len > 0 && flush_chunk(&w) != 0) {
+    return -1;
+  }
+  // 길이 0 인 청크로 끝을 표시
+  const uint8_t end = 0;
+  return write(ctx, &end, 1);
+}
+
+// --- 역직렬화 ---
+
+typedef struct {
+  rbtree_read_fn read;
+  void *ctx;
+  uint8_t buf[RBTREE_SERIAL_CHUNK];
+  size_t pos;  // 청크에서 다음에 읽을 위치
+  size_t len;  // 청크 길이
+  key_t prev;
+} serial_reader;
+
+// 정확히 len 바이트를 읽어 0, 그 전에 스트림이 끝나면 -1
+static int read_exact(serial_reader *r, void *buf, size_t len) {
+  uint8_t *p = buf;
+  while (len > 0) {
+    const size_t got = r->read(r->ctx, p, len);
+    if (got == 0 || got > len) {
+      return -1;
+    }
+    p += got;
+    len -= got;
+  }
+  return 0;
+}
+
+// 청크 밖(헤더, 청크 길이)의 varint 는 이 트리 뒤의 바이트를 건드리지 않도록 한 바이트씩 읽음
+static int read_stream_varint(serial_reader *r, uint64_t *out) {
+  uint64_t v = 0;
+  for (int i = 0; i < VARINT_MAX_BYTES; i++) {
+    uint8_t b;
+    if (read_exact(r, &b, 1) != 0) {
+      return -1;
+    }
+    v |= (uint64_t)(b & 0x7f) << (7 * i);
+    if (!(b & 0x80)) {
+      *out = v;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+// 청크 안의 varint, 청크 끝을 넘으면 -1
+static int read_chunk_varint(serial_reader *r, uint64_t *out) {
+  uint64_t v = 0;
+  for (int i = 0; i < VARINT_MAX_BYTES && r->pos < r->len; i++) {
+    const uint8_t b = r->buf[r->pos++];
+    v |= (uint64_t)(b & 0x7f) << (7 * i);
+    if (!(b & 0x80)) {
+      *out = v;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+// 다음 청크를 읽음, 끝 표시(길이 0)이거나 길이가 맞지 않으면 -1
+static int next_chunk(serial_reader *r) {
+  uint64_t len;
+  if (read_stream_varint(r, &len) != 0 || len == 0 || len > RBTREE_SERIAL_CHUNK) {
+    return -1;
+  }
+  if (read_exact(r, r->buf, len) != 0) {
+    return -1;
+  }
+  r->pos = 0;
+  r->len = len;
+  return 0;
+}
+
+// rbtree_from_sorted_source 에 넘기는 키 공급 함수
+static int next_key(void *p, key_t *out) {
+  serial_reader *r = p;
+  const int first = r->pos == r->len;
+  if (first && next_chunk(r) != 0) {
+    return -1;
+  }
+  uint64_t v;
+  if (read_chunk_varint(r, &v) != 0) {
+    return -1;
+  }
+  // 범위를 벗어나는 값은 손상된 스트림
+  int64_t key;
+  if (first) {
+    key = unzigzag(v);
+  } else if (v > (uint64_t)((int64_t)INT_MAX - INT_MIN)) {
+    return -1;
+  } else {
+    key = (int64_t)r->prev + (int64_t)v;
+  }
+  if (key < INT_MIN || key > INT_MAX) {
+    return -1;
+  }
+  *out = r->prev = (key_t)key;
+  return 0;
+}
+
+rbtree *rbtree_deserialize(rbtree_read_fn read, void *ctx) {
+  if (read == NULL) {
+    return NULL;
+  }
+  serial_reader *r = malloc(sizeof(serial_reader));
+  if (r == NULL) {
+    return NULL;
+  }
+  r->read = read;
+  r->ctx = ctx;
+  r->pos = r->len = 0;
+  r->prev = 0;
+
+  uint8_t head[SERIAL_HEADER_SIZE];
+  uint64_t n;
+  rbtree *t = NULL;
+  // 헤더의 키 수는 믿지 않음: 노드로 담을 수 없는 수는 키를 읽기 전에 거절하고, 그 아래라도 키가 모자라면
+  // rbtree_from_sorted_source 가 끊기는 즉시 멈추므로 받은 키 수에 비례하는 메모리만 씀
+  if (read_exact(r, head, sizeof(head)) == 0 && memcmp(head, SERIAL_MAGIC, 4) == 0 &&
+      head[4] == SERIAL_VERSION && head[5] == sizeof(key_t) && read_stream_varint(r, &n) == 0 &&
+      n <= SIZE_MAX / sizeof(node_t)) {
+    t = rbtree_from_sorted_source((size_t)n, next_key, r);
+  }
+  // 키 n 개를 다 쓴 뒤에는 청크가 남지 않고 바로 끝 표시가 와야 함
+  uint64_t end;
+  if (t != NULL && (r->pos != r->len || read_stream_varint(r, &end) != 0 || end != 0)) {
+    delete_rbtree(t);
+    t = NULL;
+  }
+  free(r);
+  return t;
+}
+
+int rbtree_serial_fwrite(void *fp, const void *buf, size_t len) {
+  return fwrite(buf, 1, len, fp) == len ? 0 : -1;
+}
+
+size_t rbtree_serial_fread(void *fp, void *buf, size_t len) {
+  return fread(buf, 1, len, fp);
+}
@@ -0,0 +1,37 @@
+#ifndef _RBTREE_SERIAL_H_
+#define _RBTREE_SERIAL_H_
+
+#include "rbtree.h"
+
+// 트리를 정렬된 키 스트림으로 직렬화 / 역직렬화
+//
+// 키는 중위 순서로 청크(최대 RBTREE_SERIAL_CHUNK 바이트) 단위로 나가며, 청크 안에서 첫 키는 zigzag varint,
+// 나머지는 앞 키와의 차이를 varint 로 씀. 정렬된 키는 차이가 작으므로 빽빽한 키는 1바이트, 고르게 퍼진
+// 키도 보통 2~3바이트면 됨 (int 배열은 4바이트)
+// varint 는 바이트 단위라 기계의 바이트 순서와 무관함
+//
+// 형식: "RBTS" | 버전(1) | sizeof(key_t) | 0 | 0 | varint 키 수 | { varint 청크 길이 | 청크 }* | varint 0
+
+// 한 청크의 최대 바이트 수 (write 콜백 한 번에 넘기는 크기)
+#define RBTREE_SERIAL_CHUNK 4096
+
+// buf 의 len 바이트를 모두 내보내고 0, 실패하면 -1 반환
+typedef int (*rbtree_write_fn)(void *ctx, const void *buf, size_t len);
+
+// 최대 len 바이트를 buf 에 읽고 읽은 바이트 수 반환 (fread 처럼 더 적게 읽어도 되며, 0 이면 끝 / 오류)
+// 역직렬화는 스트림에서 이 트리의 마지막 바이트까지만 읽으므로 뒤에 다른 데이터가 이어져도 됨
+typedef size_t (*rbtree_read_fn)(void *ctx, void *buf, size_t len);
+
+// 트리의 키를 오름차순으로 write 에 흘려 보냄, 성공 시 0 / write 가 실패하면 -1
+int rbtree_serialize(const rbtree *t, rbtree_write_fn write, void *ctx);
+
+// read 에서 스트림을 받아 트리를 만듦, 형식이 어긋나거나 스트림이 중간에 끊기면 NULL
+// 헤더의 키 수가 노드로 담을 수 없을 만큼 크면 키를 읽지 않고 NULL, 실제 키보다 크면 키가 끊기는 곳에서 바로 NULL
+// 받은 키를 중간 배열 없이 바로 O(n) 일괄 생성(rbtree_from_sorted_source)에 넣으므로 트리는 노드 풀 하나에 담김
+rbtree *rbtree_deserialize(rbtree_read_fn read, void *ctx);
+
+// FILE * 를 ctx 로 쓰는 콜백 (파이프, 소켓을 fdopen 한 스트림 등)
+int rbtree_serial_fwrite(void *fp, const void *buf, size_t len);
+size_t rbtree_serial_fread(void *fp, void *buf, size_t len);
+
+#endif  // _RBTREE_SERIAL_H_
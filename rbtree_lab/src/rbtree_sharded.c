@@ -0,0 +1,170 @@
+#include "rbtree_sharded.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// shard 하나가 차지하는 크기 (이웃 shard의 lock과 캐시 라인을 공유하지 않도록)
+#define RBTREE_CACHE_LINE 64
+
+typedef struct {
+  _Alignas(RBTREE_CACHE_LINE) pthread_mutex_t lock;
+  rbtree *tree;
+} rbtree_shard;
+
+struct rbtree_sharded {
+  rbtree_shard *shards;
+  key_t *splits; // shard 경계, nshards - 1 개
+  size_t nshards;
+};
+
+rbtree_sharded *new_rbtree_sharded(const key_t *splits, const size_t nsplits) {
+  return new_rbtree_sharded_with_options(splits, nsplits, NULL);
+}
+
+rbtree_sharded *new_rbtree_sharded_with_options(const key_t *splits, const size_t nsplits, const rbtree_options *opts) {
+  for (size_t i = 1; i < nsplits; i++) {
+    if (splits[i - 1] >= splits[i]) {
+      return NULL;
+    }
+  }
+
+  rbtree_sharded *s = calloc(1, sizeof(rbtree_sharded));
+  if (s == NULL) {
+    return NULL;
+  }
+  s->nshards = nsplits + 1;
+  s->splits = malloc((nsplits ? nsplits : 1) * sizeof(key_t));
+  s->shards = aligned_alloc(RBTREE_CACHE_LINE, s->nshards * sizeof(rbtree_shard));
+  if (s->splits == NULL || s->shards == NULL) {
+    free(s->splits);
+    free(s->shards);
+    free(s);
+    return NULL;
+  }
+  if (nsplits > 0) {
+    memcpy(s->splits, splits, nsplits * sizeof(key_t));
+  }
+
+  for (size_t i = 0; i < s->nshards; i++) {
+    s->shards[i].tree = opts != NULL ? new_rbtree_with_options(&opts[i]) : new_rbtree();
+    if (s->shards[i].tree == NULL) {
+      // 이미 만든 shard까지만 정리
+      s->nshards = i;
+      delete_rbtree_sharded(s);
+      return NULL;
+    }
+    pthread_mutex_init(&s->shards[i].lock, NULL);
+  }
+  return s;
+}
+
+void delete_rbtree_sharded(rbtree_sharded *s) {
+  if (s == NULL) {
+    return;
+  }
+  for (size_t i = 0; i < s->nshards; i++) {
+    delete_rbtree(s->shards[i].tree);
+    pthread_mutex_destroy(&s->shards[i].lock);
+  }
+  free(s->shards);
+  free(s->splits);
+  free(s);
+}
+
+size_t rbtree_sharded_count(const rbtree_sharded *s) {
+  return s->nshards;
+}
+
+// key가 속한 shard: splits 에서 key 보다 큰 첫 경계의 위치를 이분 탐색
+static rbtree_shard *route(rbtree_sharded *s, const key_t key) {
+  size_t lo = 0, hi = s->nshards - 1;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (key < s->splits[mid]) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return &s->shards[lo];
+}
+
+int rbtree_sharded_insert(rbtree_sharded *s, const key_t key) {
+  rbtree_shard *sh = route(s, key);
+  pthread_mutex_lock(&sh->lock);
+  node_t *node = rbtree_insert(sh->tree, key);
+  pthread_mutex_unlock(&sh->lock);
+  return node == NULL ? -1 : 0;
+}
+
+int rbtree_sharded_find(rbtree_sharded *s, const key_t key) {
+  rbtree_shard *sh = route(s, key);
+  pthread_mutex_lock(&sh->lock);
+  int found = rbtree_find(sh->tree, key) != NULL;
+  pthread_mutex_unlock(&sh->lock);
+  return found;
+}
+
+int rbtree_sharded_erase(rbtree_sharded *s, const key_t key) {
+  rbtree_shard *sh = route(s, key);
+  pthread_mutex_lock(&sh->lock);
+  node_t *p = rbtree_find(sh->tree, key);
+  if (p != NULL) {
+    rbtree_erase(sh->tree, p);
+  }
+  pthread_mutex_unlock(&sh->lock);
+  return p == NULL ? -1 : 0;
+}
+
+// 비어 있지 않은 첫 shard의 min (앞에서부터) 또는 마지막 shard의 max (뒤에서부터)
+static int edge_key(rbtree_sharded *s, const int want_max, key_t *out) {
+  for (size_t i = 0; i < s->nshards; i++) {
+    rbtree_shard *sh = &s->shards[want_max ? s->nshards - 1 - i : i];
+    pthread_mutex_lock(&sh->lock);
+    int found = rbtree_size(sh->tree) > 0;
+    if (found) {
+      *out = (want_max ? rbtree_max(sh->tree) : rbtree_min(sh->tree))->key;
+    }
+    pthread_mutex_unlock(&sh->lock);
+    if (found) {
+      return 0;
+    }
+  }
+  return -1;
+}
+
+int rbtree_sharded_min(rbtree_sharded *s, key_t *out) {
+  return edge_key(s, 0, out);
+}
+
+int rbtree_sharded_max(rbtree_sharded *s, key_t *out) {
+  return edge_key(s, 1, out);
+}
+
+int rbtree_sharded_to_array(rbtree_sharded *s, key_t *arr, const size_t n) {
+  // 항상 같은 순서(0, 1, ...)로 잠그므로 여러 스냅샷이 동시에 돌아도 교착이 없음
+  for (size_t i = 0; i < s->nshards; i++) {
+    pthread_mutex_lock(&s->shards[i].lock);
+  }
+
+  // shard 구간이 겹치지 않고 오름차순이므로 병합 없이 차례로 이어 붙임
+  size_t copied = 0;
+  for (size_t i = 0; i < s->nshards && copied < n; i++) {
+    copied += rbtree_to_array(s->shards[i].tree, arr + copied, n - copied);
+  }
+
+  for (size_t i = s->nshards; i-- > 0;) {
+    pthread_mutex_unlock(&s->shards[i].lock);
+  }
+  return (int)copied;
+}
+
+size_t rbtree_sharded_size(rbtree_sharded *s) {
+  size_t total = 0;
+  for (size_t i = 0; i < s->nshards; i++) {
+    pthread_mutex_lock(&s->shards[i].lock);
+    total += rbtree_size(s->shards[i].tree);
+    pthread_mutex_unlock(&s->shards[i].lock);
+  }
+  return total;
+}
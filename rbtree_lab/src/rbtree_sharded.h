@@ -0,0 +1,50 @@
+#ifndef _RBTREE_SHARDED_H_
+#define _RBTREE_SHARDED_H_
+
+#include "rbtree.h"
+
+// 키 구간별로 독립된 rbtree 여러 개(shard)에 나누어 담는 컨테이너
+//
+// - shard마다 자기 mutex를 가지므로 서로 다른 구간에 쓰는 writer들은 동시에 진행됨
+// - shard는 키 구간 순서대로 놓이므로 min / max / to_array 는 shard를 순서대로 이어 붙이면 됨
+// - 구간 경계는 생성할 때 고정 (키 분포를 알고 고르게 나눌수록 경합이 줄어듦)
+
+typedef struct rbtree_sharded rbtree_sharded;
+
+// splits[0] < splits[1] < ... < splits[nsplits - 1] 를 경계로 nsplits + 1 개의 shard 생성
+// shard i 는 splits[i - 1] <= key < splits[i] 인 키를 담음 (nsplits 가 0이면 shard 하나)
+// 경계가 오름차순이 아니거나 메모리가 부족하면 NULL 반환
+rbtree_sharded *new_rbtree_sharded(const key_t *splits, const size_t nsplits);
+
+// new_rbtree_sharded 와 같되 shard i 의 트리를 new_rbtree_with_options(&opts[i]) 로 만듦 (opts 는 nsplits + 1 개)
+// shard 마다 그 shard 를 맡는 worker 스레드가 도는 소켓의 numa_node 를 주면 노드가 그 소켓 메모리에 놓임
+// opts 가 NULL 이면 new_rbtree_sharded 와 같고, 하나라도 만들지 못하면 NULL 반환
+rbtree_sharded *new_rbtree_sharded_with_options(const key_t *splits, const size_t nsplits, const rbtree_options *opts);
+
+// 모든 shard와 노드를 해제
+void delete_rbtree_sharded(rbtree_sharded *s);
+
+// shard 개수
+size_t rbtree_sharded_count(const rbtree_sharded *s);
+
+// key 삽입, 성공 시 0 / 메모리 부족 시 -1
+int rbtree_sharded_insert(rbtree_sharded *s, const key_t key);
+
+// key가 있으면 1, 없으면 0 반환
+int rbtree_sharded_find(rbtree_sharded *s, const key_t key);
+
+// key 하나를 삭제, 성공 시 0 / 없으면 -1
+int rbtree_sharded_erase(rbtree_sharded *s, const key_t key);
+
+// 가장 작은 / 큰 키를 *out에 쓰고 0 반환, 비어 있으면 -1
+int rbtree_sharded_min(rbtree_sharded *s, key_t *out);
+int rbtree_sharded_max(rbtree_sharded *s, key_t *out);
+
+// 전체 키를 오름차순으로 최대 n개 복사하고 복사한 개수 반환
+// 모든 shard를 잠근 상태에서 복사하므로 한 시점의 일관된 스냅샷
+int rbtree_sharded_to_array(rbtree_sharded *s, key_t *arr, const size_t n);
+
+// 저장된 key 개수 (모든 shard의 합)
+size_t rbtree_sharded_size(rbtree_sharded *s);
+
+#endif  // _RBTREE_SHARDED_H_
@@ -0,0 +1,298 @@
+#include "rbtree.h"
+#include <stdlib.h>
+
+// 중위 순회에 쓰는 고정 크기 스택 (레드-블랙 트리의 높이는 2 log2(n + 1) 이하이므로 64비트 크기에 충분)
+#define RBTREE_MAX_HEIGHT 128
+
+// NULL 자식은 블랙으로 취급
+static inline int is_red(const node_t *n) {
+  return n != NULL && n->color == RBTREE_RED;
+}
+
+// root 를 dir 방향으로 회전하고 새 서브트리 루트를 반환
+// 올라온 노드는 블랙, 내려간 root 는 레드가 됨 (top-down 패스에서 쓰는 색 배치)
+static node_t *rotate_single(node_t *root, const int dir) {
+  node_t *save = root->child[!dir];
+  root->child[!dir] = save->child[dir];
+  save->child[dir] = root;
+  root->color = RBTREE_RED;
+  save->color = RBTREE_BLACK;
+  return save;
+}
+
+// root->child[!dir] 를 반대로 한 번 돌린 뒤 root 를 dir 방향으로 회전
+static node_t *rotate_double(node_t *root, const int dir) {
+  root->child[!dir] = rotate_single(root->child[!dir], !dir);
+  return rotate_single(root, dir);
+}
+
+rbtree *new_rbtree(void) {
+  rbtree *t = calloc(1, sizeof(rbtree));
+  if (t == NULL) {
+    return NULL;
+  }
+  t->nil = calloc(1, sizeof(node_t));
+  if (t->nil == NULL) {
+    free(t);
+    return NULL;
+  }
+  t->nil->color = RBTREE_BLACK;
+  return t;
+}
+
+rbtree *new_rbtree_with_pool(size_t initial_capacity) {
+  (void)initial_capacity;
+  return new_rbtree();
+}
+
+void delete_rbtree(rbtree *t) {
+  if (t == NULL) {
+    return;
+  }
+  // 왼쪽 자식이 있으면 오른쪽으로 회전해 왼쪽 사슬을 펴면서 해제 (스택 없이 O(n))
+  node_t *cur = t->root;
+  while (cur != NULL) {
+    node_t *l = cur->child[0];
+    if (l != NULL) {
+      cur->child[0] = l->child[1];
+      l->child[1] = cur;
+      cur = l;
+    } else {
+      node_t *r = cur->child[1];
+      free(cur);
+      cur = r;
+    }
+  }
+  free(t->nil);
+  free(t);
+}
+
+node_t *rbtree_insert(rbtree *t, const key_t key) {
+  if (t == NULL) {
+    return NULL;
+  }
+  node_t *n = malloc(sizeof(node_t));
+  if (n == NULL) {
+    return NULL;
+  }
+  n->key = key;
+  n->color = RBTREE_RED;
+  n->child[0] = n->child[1] = NULL;
+
+  if (t->root == NULL) {
+    t->root = n;
+  } else {
+    // 루트 위에 가짜 노드 head 를 두어 루트 회전도 다른 노드와 같이 처리
+    node_t head = {0};
+    node_t *gg = &head; // 증조부모
+    node_t *g = NULL;   // 조부모
+    node_t *p = NULL;   // 부모
+    node_t *q = t->root;
+    int dir = 0;
+    int last = 0;
+    head.child[1] = t->root;
+
+    for (;;) {
+      if (q == NULL) {
+        // 바닥에 도착: 새 레드 노드를 연결
+        p->child[dir] = q = n;
+      } else if (is_red(q->child[0]) && is_red(q->child[1])) {
+        // 내려가는 길의 4-노드를 미리 나눔 (색 바꾸기)
+        q->color = RBTREE_RED;
+        q->child[0]->color = RBTREE_BLACK;
+        q->child[1]->color = RBTREE_BLACK;
+      }
+
+      // 색 바꾸기나 연결로 레드가 연속되면 조부모에서 회전
+      if (is_red(q) && is_red(p)) {
+        const int dir2 = gg->child[1] == g;
+        if (q == p->child[last]) {
+          gg->child[dir2] = rotate_single(g, !last);
+        } else {
+          gg->child[dir2] = rotate_double(g, !last);
+        }
+      }
+      if (q == n) {
+        break;
+      }
+
+      // 같은 키는 오른쪽으로
+      last = dir;
+      dir = !(key < q->key);
+      if (g != NULL) {
+        gg = g;
+      }
+      g = p;
+      p = q;
+      q = q->child[dir];
+    }
+    t->root = head.child[1];
+  }
+  t->root->color = RBTREE_BLACK;
+  t->size++;
+  return n;
+}
+
+node_t *rbtree_find(const rbtree *t, const key_t key) {
+  if (t == NULL) {
+    return NULL;
+  }
+  node_t *cur = t->root;
+  while (cur != NULL && cur->key != key) {
+    cur = cur->child[cur->key < key];
+  }
+  return cur;
+}
+
+node_t *rbtree_min(const rbtree *t) {
+  if (t == NULL || t->root == NULL) {
+    return t == NULL ? NULL : t->nil;
+  }
+  node_t *cur = t->root;
+  while (cur->child[0] != NULL) {
+    cur = cur->child[0];
+  }
+  return cur;
+}
+
+node_t *rbtree_max(const rbtree *t) {
+  if (t == NULL || t->root == NULL) {
+    return t == NULL ? NULL : t->nil;
+  }
+  node_t *cur = t->root;
+  while (cur->child[1] != NULL) {
+    cur = cur->child[1];
+  }
+  return cur;
+}
+
+int rbtree_erase(rbtree *t, node_t *p) {
+  if (t == NULL || p == NULL || p == t->nil || t->root == NULL) {
+    return -1;
+  }
+  const key_t key = p->key;
+
+  // 내려가면서 현재 노드 q 를 항상 레드로 만들어 두면, 바닥에서 떼어 낼 노드가 레드이므로 복구가 필요 없음
+  node_t head = {0};
+  node_t *g = NULL;   // 조부모
+  node_t *par = NULL; // 부모
+  node_t *q = &head;
+  node_t *found = NULL;
+  int dir = 1;
+  head.child[1] = t->root;
+
+  // key 이상인 쪽으로(같으면 왼쪽) 내려가므로 key 를 가진 노드가 있으면 반드시 지나감
+  while (q->child[dir] != NULL) {
+    const int last = dir;
+    g = par;
+    par = q;
+    q = q->child[dir];
+    dir = q->key < key;
+    if (q->key == key) {
+      found = q;
+    }
+
+    if (is_red(q) || is_red(q->child[dir])) {
+      continue;
+    }
+    if (is_red(q->child[!dir])) {
+      // 반대쪽 레드 자식을 올려서 q 를 레드로 내림 (q 아래 dir 쪽 경로는 그대로)
+      par = par->child[last] = rotate_single(q, dir);
+      continue;
+    }
+    node_t *s = par->child[!last];
+    if (s == NULL) {
+      continue;
+    }
+    if (!is_red(s->child[0]) && !is_red(s->child[1])) {
+      // 형제도 2-노드면 부모와 합침 (색 바꾸기)
+      par->color = RBTREE_BLACK;
+      s->color = RBTREE_RED;
+      q->color = RBTREE_RED;
+    } else {
+      // 형제에게서 키 하나를 빌려 옴 (회전)
+      const int dir2 = g->child[1] == par;
+      if (is_red(s->child[last])) {
+        g->child[dir2] = rotate_double(par, last);
+      } else {
+        g->child[dir2] = rotate_single(par, last);
+      }
+      node_t *top = g->child[dir2];
+      q->color = RBTREE_RED;
+      top->color = RBTREE_RED;
+      top->child[0]->color = RBTREE_BLACK;
+      top->child[1]->color = RBTREE_BLACK;
+    }
+  }
+
+  if (found == NULL) {
+    t->root = head.child[1];
+    if (t->root != NULL) {
+      t->root->color = RBTREE_BLACK;
+    }
+    return -1;
+  }
+  // q 는 found 의 중위 순서 직전 노드(또는 found 자신)이며 자식이 하나 이하
+  found->key = q->key;
+  par->child[par->child[1] == q] = q->child[q->child[0] == NULL];
+  free(q);
+
+  t->root = head.child[1];
+  if (t->root != NULL) {
+    t->root->color = RBTREE_BLACK;
+  }
+  t->size--;
+  return 0;
+}
+
+int rbtree_to_array(const rbtree *t, key_t *arr, const size_t n) {
+  if (t == NULL || arr == NULL) {
+    return 0;
+  }
+  // parent 포인터가 없으므로 지나온 노드를 스택에 쌓으며 중위 순회
+  const node_t *stack[RBTREE_MAX_HEIGHT];
+  int top = 0;
+  size_t count = 0;
+  const node_t *cur = t->root;
+  while (count < n && (cur != NULL || top > 0)) {
+    while (cur != NULL) {
+      stack[top++] = cur;
+      cur = cur->child[0];
+    }
+    cur = stack[--top];
+    arr[count++] = cur->key;
+    cur = cur->child[1];
+  }
+  return (int)count;
+}
+
+// p 서브트리의 black height, 어긋나면 -1 (*prev 는 중위 순서로 직전 노드, *count 는 센 노드 수)
+static int validate_subtree(const node_t *p, const node_t **prev, size_t *count, const int depth) {
+  if (p == NULL) {
+    return 0;
+  }
+  if (depth > RBTREE_MAX_HEIGHT || (is_red(p) && (is_red(p->child[0]) || is_red(p->child[1])))) {
+    return -1;
+  }
+  const int lh = validate_subtree(p->child[0], prev, count, depth + 1);
+  if (lh < 0 || (*prev != NULL && (*prev)->key > p->key)) {
+    return -1;
+  }
+  *prev = p;
+  (*count)++;
+  const int rh = validate_subtree(p->child[1], prev, count, depth + 1);
+  if (rh != lh) {
+    return -1;
+  }
+  return lh + (p->color == RBTREE_BLACK);
+}
+
+int rbtree_validate(const rbtree *t) {
+  if (t == NULL || t->nil->color != RBTREE_BLACK || is_red(t->root)) {
+    return -1;
+  }
+  const node_t *prev = NULL;
+  size_t count = 0;
+  const int h = validate_subtree(t->root, &prev, &count, 0);
+  return h >= 0 && count == t->size ? h : -1;
+}
@@ -0,0 +1,67 @@
+#ifndef _RBTREE_TOPDOWN_H_
+#define _RBTREE_TOPDOWN_H_
+
+// src/rbtree.h 와 같은 API를 제공하는 top-down 레드-블랙 트리 (Guibas-Sedgewick 방식)
+// 삽입/삭제가 루트에서 내려가는 한 번의 패스 안에서 색 바꾸기와 회전을 끝내므로
+// fixup 으로 다시 올라오지 않고, 노드에 parent 포인터가 없음 (노드 하나 24바이트, 기존 32바이트)
+// -I src/topdown 으로 include 경로를 바꾸고 src/topdown/rbtree.o 를 링크하면 그대로 교체됨
+//
+// 삭제는 찾은 노드에 중위 순서 직전 노드의 키를 옮겨 담고 직전 노드를 해제하므로,
+// rbtree_find / min / max / insert 가 돌려준 node_t * 는 다음 erase 전까지만 유효함
+
+#include <stddef.h>
+
+// 색상 정보를 나타내는 열거형
+// RBTREE_RED: 레드 노드
+// RBTREE_BLACK: 블랙 노드
+typedef enum { RBTREE_RED, RBTREE_BLACK } color_t;
+
+// 키 타입 정의 (정수형)
+typedef int key_t;
+
+// 트리의 노드를 정의하는 구조체 (parent 없음)
+// 회전과 삭제 경로가 왼쪽/오른쪽을 방향 값(0/1)으로 다루므로 자식을 배열로 둠
+struct node_t {
+  key_t key;               // 노드에 저장된 키 값
+  color_t color;           // 노드의 색상
+  struct node_t *child[2]; // child[0]: 왼쪽 자식, child[1]: 오른쪽 자식 (없으면 NULL)
+};
+typedef struct node_t node_t;
+
+// 레드-블랙 트리 전체를 나타내는 구조체
+typedef struct {
+  node_t *root; // 루트 노드 (비어 있으면 NULL)
+  node_t *nil;  // rbtree_min / rbtree_max 가 빈 트리에서 돌려주는 센티넬 (트리에 연결되지 않음)
+  size_t size;  // 저장된 키 개수
+} rbtree;
+
+// 새로운 레드-블랙 트리를 생성하고 초기화하여 반환
+rbtree *new_rbtree(void);
+
+// src/rbtree.h 와 맞춘 생성 함수 (노드를 미리 잡아 두지 않으므로 new_rbtree 와 동일)
+rbtree *new_rbtree_with_pool(size_t initial_capacity);
+
+// 레드-블랙 트리의 모든 노드와 트리 구조체를 해제
+void delete_rbtree(rbtree *);
+
+// 키 값을 트리에 삽입하고 삽입된 노드 포인터를 반환 (메모리 부족 시 NULL)
+node_t *rbtree_insert(rbtree *, const key_t);
+
+// 특정 키 값을 가진 노드를 검색하여 반환, 찾지 못하면 NULL 반환
+node_t *rbtree_find(const rbtree *, const key_t);
+
+// 트리 내에서 가장 작은 / 큰 키를 가진 노드를 반환, 트리가 비어 있으면 nil을 반환
+node_t *rbtree_min(const rbtree *);
+node_t *rbtree_max(const rbtree *);
+
+// p->key 와 같은 키 하나를 삭제 (multiset 이므로 같은 키끼리는 구분하지 않음)
+// 성공 시 0, p가 NULL / nil 이거나 키가 없으면 -1
+int rbtree_erase(rbtree *, node_t *);
+
+// 레드-블랙 트리에 저장된 키들을 오름차순으로 배열에 복사, 복사된 요소의 개수 반환
+int rbtree_to_array(const rbtree *, key_t *, const size_t);
+
+// 키 순서, 색 규칙, 모든 경로의 black 수, 키 개수를 O(n)에 확인, 맞으면 black height / 어긋나면 -1
+int rbtree_validate(const rbtree *);
+
+#endif  // _RBTREE_TOPDOWN_H_
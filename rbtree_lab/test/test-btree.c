@@ -0,0 +1,268 @@
+#include <assert.h>
+#include <rbtree.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Tests for the B+ tree engine in src/btree.
+// The public API is the same as src/rbtree.h, so the cases mirror
+// test-compact.c; the invariant checks walk wide nodes instead of colors.
+
+static void insert_arr(rbtree *t, const key_t *arr, const size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    rbtree_insert(t, arr[i]);
+  }
+}
+
+static int comp(const void *p1, const void *p2)
+{
+  const key_t *e1 = (const key_t *)p1;
+  const key_t *e2 = (const key_t *)p2;
+  if (*e1 < *e2)
+  {
+    return -1;
+  }
+  else if (*e1 > *e2)
+  {
+    return 1;
+  }
+  else
+  {
+    return 0;
+  }
+};
+
+// keys must start on a cache line so SIMD loads are aligned
+void test_node_layout(void)
+{
+  rbtree *t = new_rbtree();
+  assert(((uintptr_t)t->root->keys & 63) == 0);
+  assert(t->root->leaf && t->root->n == 0);
+  delete_rbtree(t);
+}
+
+void test_init(void)
+{
+  rbtree *t = new_rbtree();
+  assert(t != NULL);
+  assert(t->nil != NULL);
+  assert(t->size == 0);
+  assert(rbtree_min(t) == t->nil);
+  assert(rbtree_max(t) == t->nil);
+  assert(rbtree_erase(t, t->nil) == -1);
+  delete_rbtree(t);
+}
+
+void test_insert_find_single(const key_t key, const key_t wrong_key)
+{
+  rbtree *t = new_rbtree();
+  node_t *p = rbtree_insert(t, key);
+  assert(p != NULL);
+  assert(p->key == key);
+  assert(rbtree_find(t, key) == p);
+  assert(rbtree_find(t, wrong_key) == NULL);
+
+  assert(rbtree_erase(t, p) == 0);
+  assert(t->size == 0 && t->root->leaf);
+  assert(rbtree_find(t, key) == NULL);
+  delete_rbtree(t);
+}
+
+// checks key order, separator bounds and fill of the subtree under x
+// returns the leaf depth, or -1 if a constraint is broken
+static int node_traverse(const btree_node *x, const bool is_root, const key_t *lo, const key_t *hi,
+                         const btree_node **prev_leaf, size_t *count)
+{
+  if (!is_root && x->n < BTREE_MIN_KEYS - 1)
+  {
+    return -1;
+  }
+  if (x->n > BTREE_MAX_KEYS)
+  {
+    return -1;
+  }
+  for (uint32_t i = 0; i < x->n; i++)
+  {
+    if ((i > 0 && x->keys[i - 1] > x->keys[i]) || (lo && x->keys[i] < *lo) || (hi && x->keys[i] > *hi))
+    {
+      return -1;
+    }
+  }
+  if (x->leaf)
+  {
+    // leaves are chained left to right
+    if (*prev_leaf != NULL && (*prev_leaf)->next != x)
+    {
+      return -1;
+    }
+    *prev_leaf = x;
+    *count += x->n;
+    return 0;
+  }
+  int depth = -1;
+  for (uint32_t i = 0; i <= x->n; i++)
+  {
+    const key_t *clo = i > 0 ? &x->keys[i - 1] : lo;
+    const key_t *chi = i < x->n ? &x->keys[i] : hi;
+    int d = node_traverse(x->children[i], false, clo, chi, prev_leaf, count);
+    if (d < 0 || (depth >= 0 && d != depth))
+    {
+      return -1;
+    }
+    depth = d;
+  }
+  return depth + 1;
+}
+
+static void test_constraints(const rbtree *t)
+{
+  const btree_node *prev = NULL;
+  size_t count = 0;
+  const int depth = node_traverse(t->root, true, NULL, NULL, &prev, &count);
+  assert(depth >= 0 && rbtree_validate(t) == depth);
+  assert(prev->next == NULL);
+  assert(count == t->size);
+}
+
+void test_minmax_to_array(key_t *arr, const size_t n)
+{
+  rbtree *t = new_rbtree();
+  insert_arr(t, arr, n);
+  test_constraints(t);
+
+  qsort((void *)arr, n, sizeof(key_t), comp);
+  key_t *res = calloc(n, sizeof(key_t));
+  assert(rbtree_to_array(t, res, n) == n);
+  for (int i = 0; i < n; i++)
+  {
+    assert(arr[i] == res[i]);
+  }
+  assert(rbtree_to_array(t, res, n / 2) == n / 2);
+
+  node_t *p = rbtree_min(t);
+  assert(p->key == arr[0]);
+  rbtree_erase(t, p);
+  node_t *q = rbtree_max(t);
+  assert(q->key == arr[n - 1]);
+  rbtree_erase(t, q);
+  assert(rbtree_min(t)->key == arr[1]);
+  assert(rbtree_max(t)->key == arr[n - 2]);
+  test_constraints(t);
+
+  free(res);
+  delete_rbtree(t);
+}
+
+void test_find_erase(rbtree *t, const key_t *arr, const size_t n)
+{
+  for (int i = 0; i < n; i++)
+  {
+    assert(rbtree_insert(t, arr[i]) != NULL);
+  }
+  test_constraints(t);
+
+  for (int i = 0; i < n; i++)
+  {
+    node_t *p = rbtree_find(t, arr[i]);
+    assert(p != NULL);
+    assert(p->key == arr[i]);
+    assert(rbtree_erase(t, p) == 0);
+    if (i % 512 == 0)
+    {
+      test_constraints(t);
+    }
+  }
+  assert(t->size == 0 && t->root->leaf);
+
+  for (int i = 0; i < n; i++)
+  {
+    assert(rbtree_find(t, arr[i]) == NULL);
+  }
+}
+
+void test_find_erase_rand(const size_t n, const unsigned int seed, const size_t range)
+{
+  srand(seed);
+  rbtree *t = new_rbtree();
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++)
+  {
+    arr[i] = rand() % range;
+  }
+
+  test_find_erase(t, arr, n);
+  test_find_erase(t, arr, n);
+
+  free(arr);
+  delete_rbtree(t);
+}
+
+// long runs of one key span several leaves and separators
+void test_duplicate_runs(const size_t n)
+{
+  rbtree *t = new_rbtree();
+  for (int i = 0; i < n; i++)
+  {
+    rbtree_insert(t, i % 3);
+  }
+  test_constraints(t);
+  key_t *res = calloc(n, sizeof(key_t));
+  assert(rbtree_to_array(t, res, n) == n);
+  for (int i = 1; i < n; i++)
+  {
+    assert(res[i - 1] <= res[i]);
+  }
+  for (int i = 0; i < n; i++)
+  {
+    node_t *p = rbtree_find(t, (i * 7) % 3);
+    assert(p != NULL);
+    assert(rbtree_erase(t, p) == 0);
+    if (i % 97 == 0)
+    {
+      test_constraints(t);
+    }
+  }
+  assert(t->size == 0);
+  free(res);
+  delete_rbtree(t);
+}
+
+// rbtree_validate should accept a valid tree and reject a key out of order
+void test_validate(const size_t n)
+{
+  rbtree *t = new_rbtree();
+  assert(rbtree_validate(NULL) == -1);
+  assert(rbtree_validate(t) == 0);
+  for (int i = 0; i < n; i++)
+  {
+    rbtree_insert(t, i * 7 % 1001);
+  }
+  assert(rbtree_validate(t) > 0);
+  node_t *min = rbtree_min(t);
+  const key_t key = min->key;
+  min->key = rbtree_max(t)->key + 1;
+  assert(rbtree_validate(t) == -1);
+  min->key = key;
+  assert(rbtree_validate(t) > 0);
+  delete_rbtree(t);
+}
+
+int main(void)
+{
+  test_node_layout();
+  test_init();
+  test_insert_find_single(512, 1024);
+
+  key_t entries[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12, 24, 36, 990, 25};
+  test_minmax_to_array(entries, sizeof(entries) / sizeof(entries[0]));
+
+  test_find_erase_rand(10000, 17, 5001);
+  test_find_erase_rand(200000, 29, 1u << 30);
+  test_find_erase_rand(50000, 31, 10);
+  test_duplicate_runs(10000);
+  test_validate(5000);
+  printf("Passed all tests!\n");
+}
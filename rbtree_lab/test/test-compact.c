@@ -0,0 +1,240 @@
+#include <assert.h>
+#include <rbtree.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Tests for the compact (32-bit index) rbtree in src/compact.
+// The public API is the same as src/rbtree.h, so the cases mirror
+// test-rbtree.c; only the invariant checks walk indices instead of pointers.
+
+static void insert_arr(rbtree *t, const key_t *arr, const size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    rbtree_insert(t, arr[i]);
+  }
+}
+
+static int comp(const void *p1, const void *p2)
+{
+  const key_t *e1 = (const key_t *)p1;
+  const key_t *e2 = (const key_t *)p2;
+  if (*e1 < *e2)
+  {
+    return -1;
+  }
+  else if (*e1 > *e2)
+  {
+    return 1;
+  }
+  else
+  {
+    return 0;
+  }
+};
+
+// a node should be four 32-bit words
+void test_node_size(void)
+{
+  assert(sizeof(node_t) == 16);
+}
+
+void test_init(void)
+{
+  rbtree *t = new_rbtree();
+  assert(t != NULL);
+  assert(t->nil != NULL);
+  assert(t->root == 0);
+  assert(rbtree_min(t) == t->nil);
+  assert(rbtree_max(t) == t->nil);
+  delete_rbtree(t);
+}
+
+void test_insert_find_single(const key_t key, const key_t wrong_key)
+{
+  rbtree *t = new_rbtree();
+  node_t *p = rbtree_insert(t, key);
+  assert(p != NULL);
+  assert(rb_node_at(t, t->root) == p);
+  assert(p->key == key);
+  assert(rb_color(p) == RBTREE_BLACK);
+  assert(p->left == 0 && p->right == 0 && rb_parent_idx(p) == 0);
+
+  assert(rbtree_find(t, key) == p);
+  assert(rbtree_find(t, wrong_key) == NULL);
+
+  rbtree_erase(t, p);
+  assert(t->root == 0);
+  delete_rbtree(t);
+}
+
+static bool search_traverse(const rbtree *t, node_idx_t i, key_t *min, key_t *max)
+{
+  if (i == 0)
+  {
+    return true;
+  }
+  const node_t *p = rb_node_at(t, i);
+  key_t l_min, l_max, r_min, r_max;
+  l_min = l_max = r_min = r_max = p->key;
+
+  if (p->left != 0 && rb_parent_idx(rb_node_at(t, p->left)) != i)
+  {
+    return false;
+  }
+  if (p->right != 0 && rb_parent_idx(rb_node_at(t, p->right)) != i)
+  {
+    return false;
+  }
+  if (!search_traverse(t, p->left, &l_min, &l_max) || l_max > p->key)
+  {
+    return false;
+  }
+  if (!search_traverse(t, p->right, &r_min, &r_max) || r_min < p->key)
+  {
+    return false;
+  }
+  *min = l_min;
+  *max = r_max;
+  return true;
+}
+
+// returns black height, or -1 if a color constraint is broken
+static int color_traverse(const rbtree *t, node_idx_t i, const color_t parent_color)
+{
+  if (i == 0)
+  {
+    return 0;
+  }
+  const node_t *p = rb_node_at(t, i);
+  if (parent_color == RBTREE_RED && rb_color(p) == RBTREE_RED)
+  {
+    return -1;
+  }
+  int l = color_traverse(t, p->left, rb_color(p));
+  int r = color_traverse(t, p->right, rb_color(p));
+  if (l < 0 || l != r)
+  {
+    return -1;
+  }
+  return l + (rb_color(p) == RBTREE_BLACK ? 1 : 0);
+}
+
+static void test_constraints(const rbtree *t)
+{
+  key_t min, max;
+  assert(t->root == 0 || rb_color(rb_node_at(t, t->root)) == RBTREE_BLACK);
+  assert(search_traverse(t, t->root, &min, &max));
+  const int h = color_traverse(t, t->root, RBTREE_BLACK);
+  assert(h >= 0 && rbtree_validate(t) == h);
+}
+
+void test_minmax_to_array(key_t *arr, const size_t n)
+{
+  rbtree *t = new_rbtree();
+  insert_arr(t, arr, n);
+  test_constraints(t);
+
+  qsort((void *)arr, n, sizeof(key_t), comp);
+  key_t *res = calloc(n, sizeof(key_t));
+  assert(rbtree_to_array(t, res, n) == n);
+  for (int i = 0; i < n; i++)
+  {
+    assert(arr[i] == res[i]);
+  }
+  assert(rbtree_to_array(t, res, n / 2) == n / 2);
+
+  node_t *p = rbtree_min(t);
+  node_t *q = rbtree_max(t);
+  assert(p->key == arr[0]);
+  assert(q->key == arr[n - 1]);
+  rbtree_erase(t, p);
+  rbtree_erase(t, q);
+  assert(rbtree_min(t)->key == arr[1]);
+  assert(rbtree_max(t)->key == arr[n - 2]);
+  test_constraints(t);
+
+  free(res);
+  delete_rbtree(t);
+}
+
+void test_find_erase(rbtree *t, const key_t *arr, const size_t n)
+{
+  for (int i = 0; i < n; i++)
+  {
+    assert(rbtree_insert(t, arr[i]) != NULL);
+  }
+  test_constraints(t);
+
+  for (int i = 0; i < n; i++)
+  {
+    node_t *p = rbtree_find(t, arr[i]);
+    assert(p != NULL);
+    assert(p->key == arr[i]);
+    rbtree_erase(t, p);
+    if (i % 512 == 0)
+    {
+      test_constraints(t);
+    }
+  }
+  assert(t->root == 0);
+
+  for (int i = 0; i < n; i++)
+  {
+    assert(rbtree_find(t, arr[i]) == NULL);
+  }
+}
+
+void test_find_erase_rand(const size_t n, const unsigned int seed, const bool pooled)
+{
+  srand(seed);
+  rbtree *t = pooled ? new_rbtree_with_pool(n) : new_rbtree();
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++)
+  {
+    arr[i] = rand() % (n / 2 + 1);
+  }
+
+  test_find_erase(t, arr, n);
+  // freed indices are reused by the next round
+  test_find_erase(t, arr, n);
+
+  free(arr);
+  delete_rbtree(t);
+}
+
+// rbtree_validate should accept a valid tree and reject a key out of order
+void test_validate(const size_t n)
+{
+  rbtree *t = new_rbtree();
+  assert(rbtree_validate(NULL) == -1);
+  assert(rbtree_validate(t) == 0);
+  for (int i = 0; i < n; i++)
+  {
+    rbtree_insert(t, i * 7 % 1001);
+  }
+  assert(rbtree_validate(t) > 0);
+  node_t *min = rbtree_min(t);
+  const key_t key = min->key;
+  min->key = rbtree_max(t)->key + 1;
+  assert(rbtree_validate(t) == -1);
+  min->key = key;
+  assert(rbtree_validate(t) > 0);
+  delete_rbtree(t);
+}
+
+int main(void)
+{
+  test_node_size();
+  test_init();
+  test_insert_find_single(512, 1024);
+
+  key_t entries[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12, 24, 36, 990, 25};
+  test_minmax_to_array(entries, sizeof(entries) / sizeof(entries[0]));
+
+  test_find_erase_rand(10000, 17, false);
+  test_find_erase_rand(200000, 29, true);
+  test_validate(5000);
+  printf("Passed all tests!\n");
+}
@@ -1,8 +1,19 @@
 #include <assert.h>
+#include <limits.h>
+#include <pthread.h>
 #include <rbtree.h>
+#include <rbtree_concurrent.h>
+#include <rbtree_frozen.h>
+#include <rbtree_generic.h>
+#include <rbtree_parallel.h>
+#include <rbtree_persistent.h>
+#include <rbtree_serial.h>
+#include <rbtree_sharded.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 // new_rbtree should return rbtree struct with null root node
 void test_init(void)
@@ -14,6 +25,17 @@ void test_init(void)
   assert(t->root == t->nil);
 #else
   assert(t->root == NULL);
+#endif
+#ifdef RBTREE_PACKED_COLOR
+  // color lives in the parent pointer, so the key follows the three links
+  assert(offsetof(node_t, key) == 3 * sizeof(void *));
+  // the node does not shrink: key plus padding still fills a pointer-sized slot,
+  // and that padding is where the COUNTED count goes
+  size_t node_size = 4 * sizeof(void *);
+#ifdef RBTREE_ORDER_STATS
+  node_size += sizeof(size_t);
+#endif
+  assert(sizeof(node_t) == node_size);
 #endif
   delete_rbtree(t);
 }
@@ -26,15 +48,15 @@ void test_insert_single(const key_t key)
   assert(p != NULL);
   assert(t->root == p);
   assert(p->key == key);
-  // assert(p->color == RBTREE_BLACK);  // color of root node should be black
+  // assert(rb_color(p) == RBTREE_BLACK);  // color of root node should be black
 #ifdef SENTINEL
   assert(p->left == t->nil);
   assert(p->right == t->nil);
-  assert(p->parent == t->nil);
+  assert(rb_parent(p) == t->nil);
 #else
   assert(p->left == NULL);
   assert(p->right == NULL);
-  assert(p->parent == NULL);
+  assert(rb_parent(p) == NULL);
 #endif
   delete_rbtree(t);
 }
@@ -157,6 +179,207 @@ void test_to_array(rbtree *t, const key_t *arr, const size_t n)
   free(res);
 }
 
+// to_array should stop after n keys even when the tree holds more
+void test_to_array_prefix()
+{
+  rbtree *t = new_rbtree();
+  assert(t != NULL);
+  key_t res[4];
+  assert(rbtree_to_array(t, res, 4) == 0);
+
+  key_t entries[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12, 24, 36, 990, 25};
+  const size_t n = sizeof(entries) / sizeof(entries[0]);
+  insert_arr(t, entries, n);
+  qsort((void *)entries, n, sizeof(key_t), comp);
+
+  assert(rbtree_to_array(t, res, 4) == 4);
+  for (int i = 0; i < 4; i++)
+  {
+    assert(entries[i] == res[i]);
+  }
+  assert(rbtree_to_array(t, res, 0) == 0);
+
+  // inorder_search copies one subtree and continues at the given index
+  key_t sub_res[16];
+  int idx = 1;
+  sub_res[0] = -1;
+  inorder_search(t, sub_res, 16, &idx, t->root->left);
+  assert(idx > 1);
+  assert(sub_res[0] == -1);
+  for (int i = 1; i < idx; i++)
+  {
+    assert(sub_res[i] == entries[i - 1]);
+  }
+  // the left subtree stops right before the root
+  assert(entries[idx - 1] == t->root->key);
+  idx = 0;
+  inorder_search(t, res, 4, &idx, t->root);
+  assert(idx == 4);
+  idx = 0;
+  inorder_search(t, res, 4, &idx, rb_nil(t));
+  assert(idx == 0);
+
+  delete_rbtree(t);
+}
+
+// next/prev and the cursor should visit every key in order without a copy
+void test_iterator(const size_t n, const unsigned int seed)
+{
+  srand(seed);
+  rbtree *t = new_rbtree();
+  assert(t != NULL);
+
+  rbtree_cursor c;
+  rbtree_cursor_first(&c, t);
+  assert(!rbtree_cursor_valid(&c));
+  assert(rbtree_next(t, rb_nil(t)) == t->nil);
+  assert(rbtree_prev(t, rb_nil(t)) == t->nil);
+
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++)
+  {
+    arr[i] = rand() % (n / 4 + 1);
+  }
+  insert_arr(t, arr, n);
+  qsort((void *)arr, n, sizeof(key_t), comp);
+
+  // a node holds rb_count(p) copies of its key (always 1 unless -DRBTREE_COUNTED)
+  int i = 0;
+  for (node_t *p = rbtree_min(t); p != t->nil; p = rbtree_next(t, p))
+  {
+    for (size_t k = rb_count(p); k > 0; k--)
+    {
+      assert(p->key == arr[i++]);
+    }
+  }
+  assert(i == n);
+
+  for (node_t *p = rbtree_max(t); p != t->nil; p = rbtree_prev(t, p))
+  {
+    for (size_t k = rb_count(p); k > 0; k--)
+    {
+      assert(p->key == arr[--i]);
+    }
+  }
+  assert(i == 0);
+
+  for (rbtree_cursor_first(&c, t); rbtree_cursor_valid(&c); rbtree_cursor_next(&c))
+  {
+    for (size_t k = rb_count(c.node); k > 0; k--)
+    {
+      assert(c.node->key == arr[i++]);
+    }
+  }
+  assert(i == n);
+
+  for (rbtree_cursor_last(&c, t); rbtree_cursor_valid(&c); rbtree_cursor_prev(&c))
+  {
+    for (size_t k = rb_count(c.node); k > 0; k--)
+    {
+      assert(c.node->key == arr[--i]);
+    }
+  }
+  assert(i == 0);
+
+  free(arr);
+  delete_rbtree(t);
+}
+
+// lower/upper bound and range should agree with a binary search on the
+// sorted keys, including runs of duplicates and bounds outside the tree
+void test_bounds_range(const size_t n, const unsigned int seed)
+{
+  srand(seed);
+  rbtree *t = new_rbtree();
+  assert(t != NULL);
+  assert(rbtree_lower_bound(t, 0) == t->nil);
+  assert(rbtree_upper_bound(t, 0) == t->nil);
+
+  key_t *arr = calloc(n, sizeof(key_t));
+  key_t *res = calloc(n, sizeof(key_t));
+  const key_t span = n / 8 + 1;
+  for (int i = 0; i < n; i++)
+  {
+    arr[i] = rand() % span * 2;
+  }
+  insert_arr(t, arr, n);
+  qsort((void *)arr, n, sizeof(key_t), comp);
+
+  for (key_t key = -1; key <= span * 2 + 1; key++)
+  {
+    int lo = 0;
+    while (lo < n && arr[lo] < key)
+    {
+      lo++;
+    }
+    int hi = lo;
+    while (hi < n && arr[hi] <= key)
+    {
+      hi++;
+    }
+
+    node_t *p = rbtree_lower_bound(t, key);
+    if (lo == n)
+    {
+      assert(p == t->nil);
+    }
+    else
+    {
+      assert(p->key == arr[lo]);
+      // lower_bound is the first of the duplicates
+      assert(rbtree_prev(t, p) == t->nil || rbtree_prev(t, p)->key < key);
+    }
+
+    node_t *q = rbtree_upper_bound(t, key);
+    if (hi == n)
+    {
+      assert(q == t->nil);
+    }
+    else
+    {
+      assert(q->key == arr[hi]);
+      assert(rbtree_prev(t, q) == t->nil || rbtree_prev(t, q)->key <= key);
+    }
+
+    // keys in [key, key + 3]
+    int end = lo;
+    while (end < n && arr[end] <= key + 3)
+    {
+      end++;
+    }
+    assert(rbtree_range(t, key, key + 3, res, n) == end - lo);
+    for (int i = lo; i < end; i++)
+    {
+      assert(res[i - lo] == arr[i]);
+    }
+    if (end - lo > 1)
+    {
+      assert(rbtree_range(t, key, key + 3, res, 1) == 1);
+    }
+  }
+  assert(rbtree_range(t, 5, 4, res, n) == 0);
+
+  rbtree_cursor c;
+  rbtree_cursor_seek(&c, t, arr[n / 2]);
+  int i = 0;
+  while (arr[i] < arr[n / 2])
+  {
+    i++;
+  }
+  for (; rbtree_cursor_valid(&c); rbtree_cursor_next(&c))
+  {
+    for (size_t k = rb_count(c.node); k > 0; k--)
+    {
+      assert(c.node->key == arr[i++]);
+    }
+  }
+  assert(i == n);
+
+  free(res);
+  free(arr);
+  delete_rbtree(t);
+}
+
 void test_multi_instance()
 {
   rbtree *t1 = new_rbtree();
@@ -234,7 +457,7 @@ void test_search_constraint(const rbtree *t)
   node_t *p = t->root;
   key_t min, max;
 #ifdef SENTINEL
-  node_t *nil = t->nil;
+  node_t *nil = rb_nil(t);
 #else
   node_t *nil = NULL;
 #endif
@@ -273,25 +496,25 @@ static bool color_traverse(const node_t *p, const color_t parent_color,
     }
     return true;
   }
-  if (parent_color == RBTREE_RED && p->color == RBTREE_RED)
+  if (parent_color == RBTREE_RED && rb_color(p) == RBTREE_RED)
   {
     return false;
   }
-  int next_depth = ((p->color == RBTREE_BLACK) ? 1 : 0) + black_depth;
-  return color_traverse(p->left, p->color, next_depth, nil) &&
-         color_traverse(p->right, p->color, next_depth, nil);
+  int next_depth = ((rb_color(p) == RBTREE_BLACK) ? 1 : 0) + black_depth;
+  return color_traverse(p->left, rb_color(p), next_depth, nil) &&
+         color_traverse(p->right, rb_color(p), next_depth, nil);
 }
 
 void test_color_constraint(const rbtree *t)
 {
   assert(t != NULL);
 #ifdef SENTINEL
-  node_t *nil = t->nil;
+  node_t *nil = rb_nil(t);
 #else
   node_t *nil = NULL;
 #endif
   node_t *p = t->root;
-  assert(p == nil || p->color == RBTREE_BLACK);
+  assert(p == nil || rb_color(p) == RBTREE_BLACK);
 
   init_color_traverse();
   assert(color_traverse(p, RBTREE_BLACK, 0, nil));
@@ -308,7 +531,79 @@ void test_rb_constraints(const key_t arr[], const size_t n)
 
   test_color_constraint(t);
   test_search_constraint(t);
+  assert(rbtree_validate(t) > 0);
+
+  delete_rbtree(t);
+}
+
+// rbtree_validate should agree with the traversals above and catch each kind
+// of broken invariant (every corruption is undone right after the check)
+void test_validate(const size_t n, const unsigned int seed)
+{
+  srand(seed);
+  rbtree *t = new_rbtree();
+  assert(rbtree_validate(NULL) == -1);
+  assert(rbtree_validate(t) == 0);
+  for (int i = 0; i < n; i++)
+  {
+    rbtree_insert(t, rand() % (n / 4 + 1));
+  }
+  init_color_traverse();
+  assert(color_traverse(t->root, RBTREE_BLACK, 0, rb_nil(t)));
+  assert(rbtree_validate(t) == max_black_depth);
+
+  node_t *red_leaf = rb_nil(t);
+  for (node_t *p = rbtree_min(t); p != t->nil && red_leaf == t->nil; p = rbtree_next(t, p))
+  {
+    if (rb_color(p) == RBTREE_RED && p->left == t->nil && p->right == t->nil)
+    {
+      red_leaf = p;
+    }
+  }
+  assert(red_leaf != t->nil);
 
+  // red root
+  rb_set_color(t->root, RBTREE_RED);
+  assert(rbtree_validate(t) == -1);
+  rb_set_color(t->root, RBTREE_BLACK);
+
+  // red node under a red node
+  node_t *parent = rb_parent(red_leaf);
+  rb_set_color(parent, RBTREE_RED);
+  assert(rbtree_validate(t) == -1);
+  rb_set_color(parent, RBTREE_BLACK);
+
+  // one path with an extra black node
+  rb_set_color(red_leaf, RBTREE_BLACK);
+  assert(rbtree_validate(t) == -1);
+  rb_set_color(red_leaf, RBTREE_RED);
+
+  // key out of order
+  const key_t key = t->leftmost->key;
+  t->leftmost->key = t->rightmost->key + 1;
+  assert(rbtree_validate(t) == -1);
+  t->leftmost->key = key;
+
+  // child pointing to the wrong parent
+  rb_set_parent(red_leaf, red_leaf);
+  assert(rbtree_validate(t) == -1);
+  rb_set_parent(red_leaf, parent);
+
+  // stale size and extreme caches
+  t->size++;
+  assert(rbtree_validate(t) == -1);
+  t->size--;
+  node_t *leftmost = t->leftmost;
+  t->leftmost = t->root;
+  assert(rbtree_validate(t) == -1);
+  t->leftmost = leftmost;
+#ifdef RBTREE_ORDER_STATS
+  t->root->size++;
+  assert(rbtree_validate(t) == -1);
+  t->root->size--;
+#endif
+
+  assert(rbtree_validate(t) == max_black_depth);
   delete_rbtree(t);
 }
 
@@ -412,18 +707,1956 @@ void test_find_erase_rand(const size_t n, const unsigned int seed)
   delete_rbtree(t);
 }
 
-int main(void)
+// rbtree built on a node pool should behave like the calloc based one,
+// including after the pool has to grow and reuse freed nodes
+void test_pool(const size_t n, const unsigned int seed)
 {
-  test_init();
-  test_insert_single(1024);
-  test_find_single(512, 1024);
-  test_erase_root(128);
-  test_find_erase_fixed();
-  test_minmax_suite();
-  test_to_array_suite();
-  test_distinct_values();
-  test_duplicate_values();
-  test_multi_instance();
-  test_find_erase_rand(10000, 17);
+  srand(seed);
+  rbtree *t = new_rbtree_with_pool(4);
+  assert(t != NULL);
+  assert(t->pool != NULL);
+  // a capacity whose slab size does not fit in size_t is refused, not wrapped
+  assert(new_rbtree_with_pool(SIZE_MAX / 2) == NULL);
+  assert(new_rbtree_with_pool(SIZE_MAX / sizeof(node_t)) == NULL);
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++)
+  {
+    arr[i] = rand() % 1000;
+  }
+
+  test_find_erase(t, arr, n);
+
+  insert_arr(t, arr, n);
+  test_color_constraint(t);
+  test_search_constraint(t);
+
+  qsort((void *)arr, n, sizeof(key_t), comp);
+  key_t *res = calloc(n, sizeof(key_t));
+  assert(rbtree_to_array(t, res, n) == n);
+  for (int i = 0; i < n; i++)
+  {
+    assert(arr[i] == res[i]);
+  }
+
+  free(res);
+  free(arr);
+  delete_rbtree(t);
+}
+
+// pools built with huge page / NUMA options should behave like the plain pool
+void test_pool_options(const size_t n, const unsigned int seed)
+{
+  const rbtree_options variants[] = {
+      {.initial_capacity = 4, .flags = RBTREE_POOL_HUGEPAGE, .numa_node = -1},
+      {.initial_capacity = 0, .flags = RBTREE_POOL_HUGETLB, .numa_node = -1},
+      {.initial_capacity = n, .flags = RBTREE_POOL_HUGEPAGE | RBTREE_POOL_HUGETLB, .numa_node = -1},
+      {.initial_capacity = 16, .flags = 0, .numa_node = 0},
+      {.initial_capacity = 16, .flags = RBTREE_POOL_HUGEPAGE, .numa_node = 0},
+  };
+  key_t *arr = calloc(n, sizeof(key_t));
+  key_t *res = calloc(n, sizeof(key_t));
+  for (int v = 0; v < sizeof(variants) / sizeof(variants[0]); v++)
+  {
+    rbtree *t = new_rbtree_with_options(&variants[v]);
+    if (t == NULL)
+    {
+      // binding to node 0 can fail on kernels without NUMA or in containers that block mbind
+      assert(variants[v].numa_node >= 0);
+      continue;
+    }
+    assert(t->pool != NULL);
+    srand(seed + v);
+    for (int i = 0; i < n; i++)
+    {
+      arr[i] = rand() % 1000;
+    }
+    test_find_erase(t, arr, n);
+    insert_arr(t, arr, n);
+    test_color_constraint(t);
+    test_search_constraint(t);
+    qsort((void *)arr, n, sizeof(key_t), comp);
+    assert(rbtree_to_array(t, res, n) == n);
+    for (int i = 0; i < n; i++)
+    {
+      assert(arr[i] == res[i]);
+    }
+    delete_rbtree(t);
+  }
+
+  // unknown node numbers are refused
+  const rbtree_options bad = {.initial_capacity = 0, .flags = 0, .numa_node = RBTREE_MAX_NUMA_NODES};
+  assert(new_rbtree_with_options(&bad) == NULL);
+  // slab sizes that only overflow once rounded up to a (huge) page are refused too
+  const rbtree_options too_big[] = {
+      {.initial_capacity = SIZE_MAX / sizeof(node_t) - 1, .flags = 0, .numa_node = 0},
+      {.initial_capacity = SIZE_MAX / sizeof(node_t) - 1, .flags = RBTREE_POOL_HUGEPAGE, .numa_node = -1},
+  };
+  assert(new_rbtree_with_options(&too_big[0]) == NULL);
+  assert(new_rbtree_with_options(&too_big[1]) == NULL);
+  // NULL gives the default pool
+  rbtree *t = new_rbtree_with_options(NULL);
+  assert(t != NULL && t->pool != NULL);
+  insert_arr(t, arr, n);
+  assert(rbtree_size(t) == n);
+  delete_rbtree(t);
+
+  // different options per shard
+  const key_t splits[] = {500};
+  const rbtree_options per_shard[] = {
+      {.initial_capacity = 0, .flags = RBTREE_POOL_HUGEPAGE, .numa_node = -1},
+      {.initial_capacity = 0, .flags = 0, .numa_node = -1},
+  };
+  rbtree_sharded *s = new_rbtree_sharded_with_options(splits, 1, per_shard);
+  assert(s != NULL && rbtree_sharded_count(s) == 2);
+  for (int i = 0; i < n; i++)
+  {
+    assert(rbtree_sharded_insert(s, arr[i]) == 0);
+  }
+  assert(rbtree_sharded_to_array(s, res, n) == n);
+  for (int i = 0; i < n; i++)
+  {
+    assert(arr[i] == res[i]);
+  }
+  delete_rbtree_sharded(s);
+  const rbtree_options bad_shards[] = {per_shard[0], bad};
+  assert(new_rbtree_sharded_with_options(splits, 1, bad_shards) == NULL);
+
+  free(res);
+  free(arr);
+}
+
+// freeing a little at a time must still release every node (ASan leak check); one step only spends its budget
+void test_delete_step(const size_t n, const unsigned int seed)
+{
+  srand(seed);
+  rbtree *t = new_rbtree();
+  for (int i = 0; i < n; i++)
+  {
+    rbtree_insert(t, rand());
+  }
+  rbtree_reaper *r = rbtree_delete_begin(t);
+  assert(r != NULL);
+  // one free per node, and at most one rotation per node
+  size_t steps = 0;
+  while (rbtree_delete_step(r, 64))
+  {
+    steps++;
+  }
+  assert(steps >= n / 64 && steps <= 2 * n / 64);
+
+  // empty tree and budget 0
+  r = rbtree_delete_begin(new_rbtree());
+  assert(rbtree_delete_step(r, 0) == 0);
+  assert(rbtree_delete_begin(NULL) == NULL && rbtree_delete_step(NULL, 1) == 0);
+
+  // pool trees free whole slabs: slabs of 4, 8, 16, ... nodes go back a budget's worth per step
+  t = new_rbtree_with_pool(4);
+  for (int i = 0; i < n; i++)
+  {
+    rbtree_insert(t, i);
+  }
+  r = rbtree_delete_begin(t);
+  steps = 0;
+  while (rbtree_delete_step(r, 1))
+  {
+    steps++;
+  }
+  assert(steps > 4);
+  const rbtree_options huge = {.initial_capacity = n, .flags = RBTREE_POOL_HUGEPAGE, .numa_node = -1};
+  t = new_rbtree_with_options(&huge);
+  insert_arr(t, (const key_t[]){3, 1, 2}, 3);
+  r = rbtree_delete_begin(t);
+  assert(rbtree_delete_step(r, n) == 0);
+
+  // freeing on a background thread
+  t = new_rbtree();
+  for (int i = 0; i < n; i++)
+  {
+    rbtree_insert(t, i);
+  }
+  pthread_t tid;
+  assert(rbtree_delete_async(t, &tid) == 0);
+  pthread_join(tid, NULL);
+  t = rbtree_from_sorted_array((const key_t[]){1, 2, 3}, 3);
+  assert(rbtree_delete_async(t, &tid) == 0);
+  pthread_join(tid, NULL);
+  assert(rbtree_delete_async(NULL, NULL) == 0);
+}
+
+// a tree bulk loaded from a sorted array should satisfy every constraint,
+// give the array back from to_array and still accept inserts and erases
+void test_from_sorted_array(const size_t max_n)
+{
+  key_t *arr = calloc(max_n, sizeof(key_t));
+  key_t *res = calloc(max_n, sizeof(key_t));
+  for (int i = 0; i < max_n; i++)
+  {
+    arr[i] = i / 3;
+  }
+
+  for (size_t n = 0; n <= max_n; n += (n < 300 ? 1 : n))
+  {
+    rbtree *t = rbtree_from_sorted_array(arr, n);
+    assert(t != NULL);
+    test_color_constraint(t);
+    test_search_constraint(t);
+    assert(rbtree_to_array(t, res, max_n) == n);
+    for (int i = 0; i < n; i++)
+    {
+      assert(res[i] == arr[i]);
+    }
+
+    if (n > 0)
+    {
+      rbtree_erase(t, rbtree_min(t));
+      rbtree_insert(t, arr[n - 1]);
+      rbtree_insert(t, -1);
+      test_color_constraint(t);
+      test_search_constraint(t);
+      assert(rbtree_min(t)->key == -1);
+    }
+    delete_rbtree(t);
+  }
+
+  // unsorted input is rejected
+  const key_t unsorted[] = {1, 3, 2};
+  assert(rbtree_from_sorted_array(unsorted, 3) == NULL);
+
+  free(res);
+  free(arr);
+}
+
+static void check_contents(const rbtree *t, key_t *expect, const size_t n)
+{
+  qsort((void *)expect, n, sizeof(key_t), comp);
+  key_t *res = calloc(n + 1, sizeof(key_t));
+  assert(rbtree_size(t) == n);
+  assert(rbtree_to_array(t, res, n + 1) == n);
+  for (int i = 0; i < n; i++)
+  {
+    assert(res[i] == expect[i]);
+  }
+  free(res);
+  test_color_constraint(t);
+  test_search_constraint(t);
+  assert(rbtree_validate(t) >= 0);
+}
+
+// batch insert/erase should give the same multiset as one-by-one calls on
+// both the finger path (small batch) and the merge path (large batch)
+void test_batch(const unsigned int seed)
+{
+  srand(seed);
+  const size_t base = 10000, small = 100, large = 5000;
+  key_t *expect = calloc(base + small + large, sizeof(key_t));
+  size_t n = 0;
+
+  rbtree *t = new_rbtree();
+  assert(rbtree_insert_batch(t, NULL, 0) == 0);
+  for (int i = 0; i < base; i++)
+  {
+    expect[n++] = rand() % 5000 + 10;
+  }
+  // empty tree: merge path builds the whole tree
+  assert(rbtree_insert_batch(t, expect, base) == 0);
+  check_contents(t, expect, n);
+
+  // existing nodes survive a merge
+  node_t *first = rbtree_min(t);
+  const key_t first_key = first->key;
+
+  key_t batch[5000];
+  for (int i = 0; i < small; i++)
+  {
+    batch[i] = expect[n++] = rand() % 6000 + 10;
+  }
+  assert(rbtree_insert_batch(t, batch, small) == 0);
+  check_contents(t, expect, n);
+
+  for (int i = 0; i < large; i++)
+  {
+    batch[i] = expect[n++] = rand() % 6000 + 10;
+  }
+  assert(rbtree_insert_batch(t, batch, large) == 0);
+  check_contents(t, expect, n);
+  assert(rbtree_min(t) == first && first->key == first_key);
+
+  // erase: a few present keys, a duplicate and a missing one (small batch)
+  key_t gone[4] = {expect[0], expect[0], expect[n - 1], -5};
+  int dup = expect[1] == expect[0];
+  assert(rbtree_erase_batch(t, gone, 4) == 2 + dup);
+  memmove(expect, expect + 1 + dup, (n - 1 - dup) * sizeof(key_t));
+  n -= 2 + dup;
+  check_contents(t, expect, n);
+
+  // erase every other key in one large batch
+  size_t kept = 0, erased = 0;
+  for (int i = 0; i < n; i++)
+  {
+    if (i % 2 && erased < large)
+    {
+      batch[erased++] = expect[i];
+    }
+    else
+    {
+      expect[kept++] = expect[i];
+    }
+  }
+  assert(rbtree_erase_batch(t, batch, erased) == erased);
+  check_contents(t, expect, kept);
+
+  free(expect);
+  delete_rbtree(t);
+}
+
+#ifdef RBTREE_ORDER_STATS
+// every node should store the size of its own subtree
+static size_t size_traverse(const node_t *p, const node_t *nil)
+{
+  if (p == nil)
+  {
+    return 0;
+  }
+  size_t n = size_traverse(p->left, nil) + size_traverse(p->right, nil) + rb_count(p);
+  assert(p->size == n);
+  return n;
+}
+
+// rank/select should agree with positions in the sorted keys while the
+// tree goes through inserts, erases, batches and a bulk load
+void test_order_stats(const size_t n, const unsigned int seed)
+{
+  srand(seed);
+  rbtree *t = new_rbtree();
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++)
+  {
+    arr[i] = rand() % (n / 2);
+    rbtree_insert(t, arr[i]);
+  }
+  for (int i = 0; i < n / 2; i++)
+  {
+    rbtree_erase(t, rbtree_find(t, arr[i]));
+  }
+  assert(rbtree_insert_batch(t, arr, n / 2) == 0);
+  assert(size_traverse(t->root, t->nil) == n);
+  assert(rbtree_size(t) == n);
+
+  qsort((void *)arr, n, sizeof(key_t), comp);
+  for (int i = 0; i < n; i++)
+  {
+    node_t *p = rbtree_select(t, i);
+    assert(p != t->nil && p->key == arr[i]);
+    size_t first = i;
+    while (first > 0 && arr[first - 1] == arr[i])
+    {
+      first--;
+    }
+    assert(rbtree_rank(t, arr[i]) == first);
+  }
+  assert(rbtree_select(t, n) == t->nil);
+  assert(rbtree_rank(t, arr[n - 1] + 1) == n);
+  assert(rbtree_rank(t, arr[0] - 1) == 0);
+  delete_rbtree(t);
+
+  t = rbtree_from_sorted_array(arr, n);
+  assert(size_traverse(t->root, t->nil) == n);
+  assert(rbtree_erase_batch(t, arr, n / 3) == n / 3);
+  assert(size_traverse(t->root, t->nil) == n - n / 3);
+  assert(rbtree_select(t, 0)->key == arr[n / 3]);
+  delete_rbtree(t);
+  free(arr);
+}
+#endif
+
+#ifdef RBTREE_STATS
+void test_stats(const size_t n)
+{
+  rbtree *t = new_rbtree();
+  rbtree_stats s;
+  rbtree_get_stats(t, &s);
+  assert(s.finds == 0 && s.left_rotations == 0 && s.black_height == 0);
+
+  // ascending inserts only cause left rotations, never right ones
+  for (int i = 0; i < n; i++)
+  {
+    rbtree_insert(t, i);
+  }
+  rbtree_get_stats(t, &s);
+  assert(s.left_rotations > 0 && s.right_rotations == 0);
+  assert(s.insert_case1 > 0 && s.insert_case3 > 0);
+  assert(s.left_rotations == s.insert_case2 + s.insert_case3);
+
+  // the depth from the root to the deepest node stays within 2 * log2(n + 1)
+  size_t bound = 0;
+  while ((1u << bound) <= n)
+  {
+    bound++;
+  }
+  for (int i = 0; i < n; i++)
+  {
+    assert(rbtree_find(t, i) != NULL);
+  }
+  assert(rbtree_find(t, -1) == NULL);
+  rbtree_get_stats(t, &s);
+  assert(s.finds == n + 1);
+  assert(s.max_find_depth >= 1 && s.max_find_depth <= 2 * bound);
+  assert(s.find_comparisons >= n && s.find_comparisons <= (n + 1) * s.max_find_depth);
+  assert(s.black_height >= bound / 2 && s.black_height <= bound);
+
+  rbtree_reset_stats(t);
+  for (int i = 0; i < n; i++)
+  {
+    rbtree_erase(t, rbtree_find(t, i));
+  }
+  rbtree_get_stats(t, &s);
+  assert(s.finds == n);
+  assert(s.delete_case2 + s.delete_case4 > 0);
+  assert(s.black_height == 0);
+  delete_rbtree(t);
+}
+#endif
+
+// multiples of 4 stay in the tree throughout, and 4k + 2 keys are inserted and erased by the writer
+typedef struct
+{
+  rbtree_concurrent *c;
+  int n;
+  int stop;
+} concurrent_arg;
+
+static void *concurrent_reader(void *p)
+{
+  concurrent_arg *arg = p;
+  rbtree_reader *r = rbtree_reader_register(arg->c);
+  assert(r != NULL);
+  unsigned int seed = 7;
+  while (!__atomic_load_n(&arg->stop, __ATOMIC_ACQUIRE))
+  {
+    const key_t k = rand_r(&seed) % arg->n;
+    if (k % 4 == 0)
+    {
+      assert(rbtree_concurrent_find(r, k) == 1);
+    }
+    else if (k % 2 == 1)
+    {
+      assert(rbtree_concurrent_find(r, k) == 0);
+    }
+    key_t lb;
+    if (rbtree_concurrent_lower_bound(r, k, &lb) == 0)
+    {
+      assert(lb >= k && lb <= k + 4);
+    }
+  }
+  rbtree_reader_unregister(r);
+  return NULL;
+}
+
+void test_concurrent(const int n, const int readers, const int rounds)
+{
+  // the tree uses calloc/free without a pool, so ASan catches a free before reclamation
+  rbtree *t = new_rbtree();
+  for (int k = 0; k < n; k += 4)
+  {
+    rbtree_insert(t, k);
+  }
+  concurrent_arg arg = {new_rbtree_concurrent(t), n, 0};
+  assert(arg.c != NULL);
+
+  pthread_t tid[readers];
+  for (int i = 0; i < readers; i++)
+  {
+    assert(pthread_create(&tid[i], NULL, concurrent_reader, &arg) == 0);
+  }
+  for (int round = 0; round < rounds; round++)
+  {
+    for (int k = 2; k < n; k += 4)
+    {
+      assert(rbtree_concurrent_insert(arg.c, k) == 0);
+    }
+    for (int k = 2; k < n; k += 4)
+    {
+      assert(rbtree_concurrent_erase(arg.c, k) == 0);
+    }
+  }
+  assert(rbtree_concurrent_erase(arg.c, 1) == -1);
+  __atomic_store_n(&arg.stop, 1, __ATOMIC_RELEASE);
+  for (int i = 0; i < readers; i++)
+  {
+    pthread_join(tid[i], NULL);
+  }
+  assert(rbtree_concurrent_size(arg.c) == (n + 3) / 4);
+  delete_rbtree_concurrent(arg.c);
+
+  // NULL when the registration slots run out
+  rbtree_concurrent *c = new_rbtree_concurrent(new_rbtree());
+  rbtree_reader *slots[RBTREE_CONCURRENT_MAX_READERS];
+  for (int i = 0; i < RBTREE_CONCURRENT_MAX_READERS; i++)
+  {
+    slots[i] = rbtree_reader_register(c);
+    assert(slots[i] != NULL);
+  }
+  assert(rbtree_reader_register(c) == NULL);
+  rbtree_reader_unregister(slots[3]);
+  assert(rbtree_reader_register(c) == slots[3]);
+  delete_rbtree_concurrent(c);
+}
+
+typedef struct
+{
+  rbtree_sharded *s;
+  int id, writers, n;
+} sharded_arg;
+
+// writer id inserts id, id + writers, id + 2 * writers, ... and erases half of them again
+static void *sharded_writer(void *p)
+{
+  sharded_arg *arg = p;
+  for (int k = arg->id; k < arg->n; k += arg->writers)
+  {
+    assert(rbtree_sharded_insert(arg->s, k) == 0);
+  }
+  for (int k = arg->id; k < arg->n; k += 2 * arg->writers)
+  {
+    assert(rbtree_sharded_find(arg->s, k) == 1);
+    assert(rbtree_sharded_erase(arg->s, k) == 0);
+  }
+  return NULL;
+}
+
+void test_sharded(const int n, const int writers)
+{
+  const key_t bad[] = {10, 10};
+  assert(new_rbtree_sharded(bad, 2) == NULL);
+
+  const key_t splits[] = {n / 4, n / 2, 3 * (n / 4)};
+  rbtree_sharded *s = new_rbtree_sharded(splits, 3);
+  assert(s != NULL && rbtree_sharded_count(s) == 4);
+  key_t k;
+  assert(rbtree_sharded_min(s, &k) == -1 && rbtree_sharded_max(s, &k) == -1);
+
+  pthread_t tid[writers];
+  sharded_arg args[writers];
+  for (int i = 0; i < writers; i++)
+  {
+    args[i] = (sharded_arg){s, i, writers, n};
+    assert(pthread_create(&tid[i], NULL, sharded_writer, &args[i]) == 0);
+  }
+  for (int i = 0; i < writers; i++)
+  {
+    pthread_join(tid[i], NULL);
+  }
+
+  // the keys left are those where (k / writers) is odd
+  key_t *expect = calloc(n, sizeof(key_t));
+  size_t m = 0;
+  for (int key = 0; key < n; key++)
+  {
+    if ((key / writers) % 2 == 1)
+    {
+      expect[m++] = key;
+    }
+  }
+  assert(rbtree_sharded_size(s) == m);
+  key_t *res = calloc(n, sizeof(key_t));
+  assert(rbtree_sharded_to_array(s, res, n) == m);
+  for (size_t i = 0; i < m; i++)
+  {
+    assert(res[i] == expect[i]);
+  }
+  assert(rbtree_sharded_to_array(s, res, m / 2) == m / 2);
+  assert(rbtree_sharded_min(s, &k) == 0 && k == expect[0]);
+  assert(rbtree_sharded_max(s, &k) == 0 && k == expect[m - 1]);
+
+  // keys outside the split points go to the first / last shard
+  assert(rbtree_sharded_insert(s, -5) == 0 && rbtree_sharded_insert(s, 10 * n) == 0);
+  assert(rbtree_sharded_min(s, &k) == 0 && k == -5);
+  assert(rbtree_sharded_max(s, &k) == 0 && k == 10 * n);
+  assert(rbtree_sharded_erase(s, -6) == -1);
+  delete_rbtree_sharded(s);
+  free(res);
+  free(expect);
+}
+
+void test_parallel(const size_t n, const unsigned int seed)
+{
+  srand(seed);
+  rbtree *t = new_rbtree();
+  key_t *expect = calloc(n, sizeof(key_t));
+  key_t *res = calloc(n + 1, sizeof(key_t));
+  for (int i = 0; i < n; i++)
+  {
+    rbtree_insert(t, rand() % (n / 2));
+  }
+  assert(rbtree_to_array(t, expect, n) == n);
+
+  const int threads[] = {1, 2, 3, 8};
+  for (int i = 0; i < 4; i++)
+  {
+    // a limit below the total fills only that many keys from the front
+    const size_t limits[] = {n + 1, n, n / 3, 1};
+    for (int j = 0; j < 4; j++)
+    {
+      const size_t expect_count = limits[j] < n ? limits[j] : n;
+      memset(res, 0xff, (n + 1) * sizeof(key_t));
+      assert(rbtree_to_array_parallel(t, res, limits[j], threads[i]) == expect_count);
+      assert(memcmp(res, expect, expect_count * sizeof(key_t)) == 0);
+      assert(res[expect_count] == (key_t)-1);
+    }
+  }
+  // a huge thread count is capped, not used to size an array on the stack
+  assert(rbtree_to_array_parallel(t, res, n, 1 << 20) == n);
+  assert(memcmp(res, expect, n * sizeof(key_t)) == 0);
+  delete_rbtree_parallel(t, 1 << 20);
+
+  // small trees and pool-backed trees take the single-thread path
+  t = new_rbtree_with_pool(0);
+  for (int i = 0; i < n; i++)
+  {
+    rbtree_insert(t, expect[i]);
+  }
+  assert(rbtree_to_array_parallel(t, res, n, 4) == n);
+  assert(memcmp(res, expect, n * sizeof(key_t)) == 0);
+  delete_rbtree_parallel(t, 4);
+  t = new_rbtree();
+  assert(rbtree_to_array_parallel(t, res, n, 4) == 0);
+  delete_rbtree_parallel(t, 4);
+
+  free(res);
+  free(expect);
+}
+
+void test_frozen(const size_t max_n, const unsigned int seed)
+{
+  srand(seed);
+  key_t *res = calloc(max_n, sizeof(key_t));
+  key_t *expect = calloc(max_n, sizeof(key_t));
+  // include sizes that are not complete binary trees
+  for (size_t n = 0; n <= max_n; n = n * 3 + 1)
+  {
+    rbtree *t = new_rbtree();
+    for (int i = 0; i < n; i++)
+    {
+      rbtree_insert(t, rand() % (n + 1) * 2);
+    }
+    rbtree_frozen *f = rbtree_freeze(t);
+    assert(f != NULL && rbtree_frozen_size(f) == n);
+    assert(rbtree_frozen_range(f, -1, 2 * n + 2, res, max_n) == n);
+    assert(rbtree_to_array(t, expect, max_n) == n);
+    assert(memcmp(res, expect, n * sizeof(key_t)) == 0);
+
+    for (key_t key = -1; key <= 2 * n + 3; key++)
+    {
+      node_t *p = rbtree_lower_bound(t, key);
+      key_t lb;
+      if (p == t->nil)
+      {
+        assert(rbtree_frozen_lower_bound(f, key, &lb) == -1);
+      }
+      else
+      {
+        assert(rbtree_frozen_lower_bound(f, key, &lb) == 0 && lb == p->key);
+      }
+      assert(rbtree_frozen_find(f, key) == (rbtree_find(t, key) != NULL));
+      assert(rbtree_frozen_range(f, key, key + 6, res, 3) == rbtree_range(t, key, key + 6, expect, 3));
+    }
+    assert(rbtree_frozen_range(f, 5, 4, res, max_n) == 0);
+
+    // the snapshot stays intact when the source tree changes or goes away
+    rbtree_frozen_holder *h = new_rbtree_frozen_holder(f);
+    rbtree_frozen *r = rbtree_frozen_acquire(h);
+    assert(r == f);
+    delete_rbtree(t);
+    t = new_rbtree();
+    rbtree_insert(t, 7);
+    rbtree_frozen_publish(h, rbtree_freeze(t));
+    assert(rbtree_frozen_size(r) == n);
+    rbtree_frozen_release(r);
+    r = rbtree_frozen_acquire(h);
+    assert(rbtree_frozen_size(r) == 1 && rbtree_frozen_find(r, 7));
+    rbtree_frozen_release(r);
+    delete_rbtree_frozen_holder(h);
+    delete_rbtree(t);
+  }
+  free(expect);
+  free(res);
+}
+
+// version v of the published snapshot holds exactly the keys 0 .. v - 1
+typedef struct
+{
+  rbtree_frozen_holder *h;
+  int stop;
+} frozen_holder_arg;
+
+static void *frozen_holder_reader(void *p)
+{
+  frozen_holder_arg *arg = p;
+  size_t last = 0;
+  while (!__atomic_load_n(&arg->stop, __ATOMIC_ACQUIRE))
+  {
+    rbtree_frozen *f = rbtree_frozen_acquire(arg->h);
+    const size_t v = rbtree_frozen_size(f);
+    // versions only move forward, and each one is complete
+    assert(v >= last);
+    last = v;
+    assert(rbtree_frozen_find(f, 0) && rbtree_frozen_find(f, (key_t)v - 1) && !rbtree_frozen_find(f, (key_t)v));
+    rbtree_frozen_release(f);
+  }
+  return NULL;
+}
+
+// readers acquire and release without a lock while the writer keeps publishing;
+// a snapshot freed under a reader shows up as a use-after-free under ASan
+void test_frozen_holder_threads(const int versions, const int readers)
+{
+  rbtree *t = new_rbtree();
+  rbtree_insert(t, 0);
+  frozen_holder_arg arg = {new_rbtree_frozen_holder(rbtree_freeze(t)), 0};
+  assert(arg.h != NULL);
+
+  pthread_t tid[readers];
+  for (int i = 0; i < readers; i++)
+  {
+    assert(pthread_create(&tid[i], NULL, frozen_holder_reader, &arg) == 0);
+  }
+  for (int v = 2; v <= versions; v++)
+  {
+    rbtree_insert(t, v - 1);
+    rbtree_frozen_publish(arg.h, rbtree_freeze(t));
+  }
+  __atomic_store_n(&arg.stop, 1, __ATOMIC_RELEASE);
+  for (int i = 0; i < readers; i++)
+  {
+    pthread_join(tid[i], NULL);
+  }
+  rbtree_frozen *f = rbtree_frozen_acquire(arg.h);
+  assert(rbtree_frozen_size(f) == versions);
+  rbtree_frozen_release(f);
+  delete_rbtree_frozen_holder(arg.h);
+  delete_rbtree(t);
+}
+
+static void *frozen_churn_reader(void *p)
+{
+  frozen_holder_arg *arg = p;
+  while (!__atomic_load_n(&arg->stop, __ATOMIC_ACQUIRE))
+  {
+    rbtree_frozen *f = rbtree_frozen_acquire(arg->h);
+    assert(rbtree_frozen_size(f) == 1 && rbtree_frozen_find(f, 0));
+    rbtree_frozen_release(f);
+  }
+  return NULL;
+}
+
+// back-to-back publishes of prebuilt snapshots flip the holder's phase as fast as possible, so a reader
+// that read the phase before one publish and counts itself after the next must not keep using a freed snapshot
+void test_frozen_holder_churn(const int publishes, const int readers)
+{
+  rbtree *t = new_rbtree();
+  rbtree_insert(t, 0);
+  rbtree_frozen **next = calloc(publishes, sizeof(rbtree_frozen *));
+  for (int i = 0; i < publishes; i++)
+  {
+    next[i] = rbtree_freeze(t);
+  }
+  frozen_holder_arg arg = {new_rbtree_frozen_holder(rbtree_freeze(t)), 0};
+  assert(arg.h != NULL);
+
+  pthread_t tid[readers];
+  for (int i = 0; i < readers; i++)
+  {
+    assert(pthread_create(&tid[i], NULL, frozen_churn_reader, &arg) == 0);
+  }
+  for (int i = 0; i < publishes; i++)
+  {
+    rbtree_frozen_publish(arg.h, next[i]);
+  }
+  __atomic_store_n(&arg.stop, 1, __ATOMIC_RELEASE);
+  for (int i = 0; i < readers; i++)
+  {
+    pthread_join(tid[i], NULL);
+  }
+  delete_rbtree_frozen_holder(arg.h);
+  free(next);
+  delete_rbtree(t);
+}
+
+void test_frozen_file(const size_t n, const unsigned int seed)
+{
+  srand(seed);
+  const char *path = "test-frozen.bin";
+  rbtree *t = new_rbtree();
+  for (int i = 0; i < n; i++)
+  {
+    rbtree_insert(t, rand() % n);
+  }
+  rbtree_frozen *f = rbtree_freeze(t);
+  assert(rbtree_frozen_save(f, path) == 0);
+
+  rbtree_frozen *m = rbtree_frozen_map(path);
+  assert(m != NULL && rbtree_frozen_size(m) == n);
+  for (key_t key = -1; key <= n; key++)
+  {
+    key_t a, b;
+    assert(rbtree_frozen_find(m, key) == rbtree_frozen_find(f, key));
+    int ra = rbtree_frozen_lower_bound(m, key, &a), rb = rbtree_frozen_lower_bound(f, key, &b);
+    assert(ra == rb && (ra != 0 || a == b));
+  }
+
+  // a mapped snapshot can be turned back into a mutable tree
+  rbtree *u = rbtree_frozen_thaw(m);
+  key_t *x = calloc(n, sizeof(key_t)), *y = calloc(n, sizeof(key_t));
+  assert(rbtree_to_array(u, x, n) == n && rbtree_to_array(t, y, n) == n);
+  assert(memcmp(x, y, n * sizeof(key_t)) == 0);
+  rbtree_insert(u, -3);
+  assert(rbtree_min(u)->key == -3);
+  delete_rbtree(u);
+  rbtree_frozen_release(m);
+  rbtree_frozen_release(f);
+
+  // an empty snapshot and a file with the wrong format
+  delete_rbtree(t);
+  t = new_rbtree();
+  f = rbtree_freeze(t);
+  // a path with a directory part syncs that directory, one that cannot be created fails
+  assert(rbtree_frozen_save(f, "./test-frozen.bin") == 0);
+  assert(rbtree_frozen_save(f, "no-such-dir/x.bin") == -1);
+  m = rbtree_frozen_map(path);
+  assert(m != NULL && rbtree_frozen_size(m) == 0 && rbtree_frozen_find(m, 0) == 0);
+  u = rbtree_frozen_thaw(m);
+  assert(u != NULL && rbtree_size(u) == 0);
+  delete_rbtree(u);
+  rbtree_frozen_release(m);
+  rbtree_frozen_release(f);
+  FILE *fp = fopen(path, "wb");
+  fputs("not a snapshot", fp);
+  fclose(fp);
+  assert(rbtree_frozen_map(path) == NULL);
+  assert(rbtree_frozen_map("no-such-dir/x.bin") == NULL);
+  remove(path);
+
+  delete_rbtree(t);
+  free(x);
+  free(y);
+}
+
+RBTREE_DEFINE(kv_tree, long, double, RBTREE_CMP_NUMERIC)
+RBTREE_DEFINE(str_tree, const char *, int, strcmp)
+
+// returns black height, or -1 if a constraint is broken
+static int kv_check(const kv_tree *t, const kv_tree_node *p)
+{
+  if (p == &t->nil)
+  {
+    return 0;
+  }
+  if ((p->left != &t->nil && (p->left->parent != p || p->left->key > p->key)) ||
+      (p->right != &t->nil && (p->right->parent != p || p->right->key < p->key)) ||
+      (p->red && (p->left->red || p->right->red)))
+  {
+    return -1;
+  }
+  int l = kv_check(t, p->left), r = kv_check(t, p->right);
+  if (l < 0 || l != r)
+  {
+    return -1;
+  }
+  return l + !p->red;
+}
+
+void test_generic(const size_t n, const unsigned int seed)
+{
+  srand(seed);
+  kv_tree t;
+  kv_tree_init(&t);
+  assert(kv_tree_min(&t) == NULL && kv_tree_find(&t, 1) == NULL);
+  long *keys = calloc(n, sizeof(long));
+  for (int i = 0; i < n; i++)
+  {
+    keys[i] = (long)(rand() % n) * 100000L;
+    kv_tree_node *p = kv_tree_insert(&t, keys[i], keys[i] / 2.0);
+    assert(p != NULL && p->key == keys[i]);
+  }
+  assert(kv_tree_size(&t) == n);
+  assert(!t.root->red && kv_check(&t, t.root) >= 0);
+
+  // the value lives in the node, so it is read straight from the found node
+  for (int i = 0; i < n; i++)
+  {
+    kv_tree_node *p = kv_tree_find(&t, keys[i]);
+    assert(p != NULL && p->value == keys[i] / 2.0);
+    kv_tree_node *lb = kv_tree_lower_bound(&t, keys[i] - 1);
+    assert(lb != NULL && lb->key == keys[i]);
+  }
+  size_t count = 0;
+  for (kv_tree_node *p = kv_tree_min(&t); p != NULL; p = kv_tree_next(&t, p))
+  {
+    kv_tree_node *q = kv_tree_next(&t, p);
+    assert(q == NULL || q->key >= p->key);
+    assert(q == NULL || kv_tree_prev(&t, q) == p);
+    count++;
+  }
+  assert(count == n);
+
+  for (int i = 0; i < n; i++)
+  {
+    kv_tree_erase(&t, kv_tree_find(&t, keys[i]));
+    if (i % 256 == 0)
+    {
+      assert(kv_check(&t, t.root) >= 0);
+    }
+  }
+  assert(kv_tree_size(&t) == 0 && t.root == &t.nil);
+  kv_tree_insert(&t, 1, 1.0);
+  kv_tree_clear(&t);
+  assert(kv_tree_size(&t) == 0);
+
+  // swap the comparison to use string keys
+  str_tree s;
+  str_tree_init(&s);
+  const char *words[] = {"pear", "apple", "fig", "kiwi", "banana"};
+  for (int i = 0; i < 5; i++)
+  {
+    str_tree_insert(&s, words[i], i);
+  }
+  assert(strcmp(str_tree_min(&s)->key, "apple") == 0);
+  assert(strcmp(str_tree_max(&s)->key, "pear") == 0);
+  assert(str_tree_find(&s, "fig")->value == 2);
+  assert(str_tree_find(&s, "grape") == NULL);
+  assert(strcmp(str_tree_lower_bound(&s, "grape")->key, "kiwi") == 0);
+  str_tree_clear(&s);
+  free(keys);
+}
+
+typedef struct
+{
+  int id;
+  node_t node; // tree links live inside the object
+  const char *name;
+} intrusive_obj;
+
+// link the node_t embedded in each object directly, with no node allocation
+static void intrusive_insert(rbtree *t, intrusive_obj *obj)
+{
+  node_t **link = &t->root, *parent = rb_nil(t);
+  while (*link != t->nil)
+  {
+    parent = *link;
+    link = obj->id < rb_entry(parent, intrusive_obj, node)->id ? &parent->left : &parent->right;
+  }
+  obj->node.key = obj->id;
+  rb_link_node(t, &obj->node, parent, link);
+  rb_insert_color(t, &obj->node);
+}
+
+void test_intrusive(const size_t n)
+{
+  rbtree *t = new_rbtree();
+  intrusive_obj *objs = calloc(n, sizeof(intrusive_obj));
+  for (int i = 0; i < n; i++)
+  {
+    objs[i].id = (int)((i * 7919L) % n);
+    objs[i].name = "obj";
+    intrusive_insert(t, &objs[i]);
+  }
+  assert(rbtree_size(t) == n);
+  test_color_constraint(t);
+  test_search_constraint(t);
+
+  int expect = 0;
+  for (node_t *p = rbtree_min(t); p != t->nil; p = rbtree_next(t, p))
+  {
+    intrusive_obj *obj = rb_entry(p, intrusive_obj, node);
+    assert(obj->id == expect++ && obj->name[0] == 'o');
+  }
+  assert(expect == n);
+  assert(rb_entry(rbtree_find(t, 5), intrusive_obj, node)->id == 5);
+
+  // unlinked nodes are not freed, so they can be inserted again
+  for (int i = 0; i < n; i += 2)
+  {
+    rb_unlink_node(t, &objs[i].node);
+  }
+  assert(rbtree_size(t) == n / 2);
+  test_color_constraint(t);
+  test_search_constraint(t);
+  for (int i = 0; i < n; i += 2)
+  {
+    intrusive_insert(t, &objs[i]);
+  }
+  test_color_constraint(t);
+  test_search_constraint(t);
+#ifdef RBTREE_ORDER_STATS
+  assert(rbtree_select(t, 10)->key == 10);
+#endif
+  for (int i = 0; i < n; i++)
+  {
+    rb_unlink_node(t, &objs[i].node);
+  }
+  assert(t->root == t->nil);
+  delete_rbtree(t);
+  free(objs);
+}
+
+void test_insert_hint(const size_t n, const unsigned seed)
+{
+  srand(seed);
+  rbtree *t = new_rbtree();
+
+  node_t *a = rbtree_insert(t, 5);
+  node_t *b = rbtree_insert(t, 5);
+  node_t *c = rbtree_insert_hint(t, a, 5);
+#ifdef RBTREE_COUNTED
+  // equal keys collect in one node's count
+  assert(a == b && b == c && a->count == 3);
+#else
+  // insert returns a new node, so equal keys get distinct nodes
+  assert(a != b && b != c && a != c);
+#endif
+  assert(a->key == 5 && b->key == 5 && c->key == 5);
+  assert(rbtree_size(t) == 3);
+  delete_rbtree(t);
+
+  // nearly sorted keys, using the previous node as the hint
+  t = new_rbtree();
+  key_t *expect = calloc(n, sizeof(key_t));
+  key_t *res = calloc(n, sizeof(key_t));
+  node_t *hint = NULL;
+  for (int i = 0; i < n; i++)
+  {
+    expect[i] = i - rand() % 4;
+    hint = rbtree_insert_hint(t, hint, expect[i]);
+    assert(hint != NULL && hint->key == expect[i]);
+  }
+  assert(rbtree_size(t) == n);
+  test_color_constraint(t);
+  test_search_constraint(t);
+  qsort(expect, n, sizeof(key_t), comp);
+  rbtree_to_array(t, res, n);
+  for (int i = 0; i < n; i++)
+  {
+    assert(res[i] == expect[i]);
+  }
+
+  // a wrong hint still puts the key in the right place
+  node_t *lo = rbtree_min(t);
+  node_t *hi = rbtree_max(t);
+  assert(rbtree_insert_hint(t, lo, (key_t)n + 10) == rbtree_max(t));
+  assert(rbtree_insert_hint(t, hi, -10) == rbtree_min(t));
+  assert(rbtree_insert_hint(t, hi, (key_t)n / 2)->key == (key_t)n / 2);
+  assert(rbtree_insert_hint(t, lo, (key_t)n / 3)->key == (key_t)n / 3);
+  assert(rbtree_size(t) == n + 4);
+  test_color_constraint(t);
+  test_search_constraint(t);
+  delete_rbtree(t);
+
+  // nearly reversed keys with the previous node as the hint (a miss climbs from the hint on its predecessor side)
+  t = new_rbtree();
+  hint = NULL;
+  for (int i = 0; i < n; i++)
+  {
+    expect[i] = (key_t)n - i + rand() % 4;
+    hint = rbtree_insert_hint(t, hint, expect[i]);
+    assert(hint != NULL && hint->key == expect[i]);
+  }
+  assert(rbtree_size(t) == n);
+  assert(rbtree_validate(t) > 0);
+  qsort(expect, n, sizeof(key_t), comp);
+  rbtree_to_array(t, res, n);
+  for (int i = 0; i < n; i++)
+  {
+    assert(res[i] == expect[i]);
+  }
+
+  free(expect);
+  free(res);
+  delete_rbtree(t);
+}
+
+// check that the cached extremes match a descent from the root
+static void test_extremes(const rbtree *t)
+{
+  if (t->root == t->nil)
+  {
+    assert(rbtree_min(t) == t->nil && rbtree_max(t) == t->nil);
+    return;
+  }
+  assert(rbtree_min(t) == rb_tree_min_subtree(t, t->root));
+  assert(rbtree_max(t) == rb_tree_max_subtree(t, t->root));
+}
+
+void test_pop_minmax(const size_t n, const unsigned seed)
+{
+  srand(seed);
+  rbtree *t = new_rbtree();
+  key_t out;
+  assert(rbtree_pop_min(t, &out) == -1 && rbtree_pop_max(t, &out) == -1);
+  assert(rbtree_erase_key(t, 1) == -1);
+
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++)
+  {
+    arr[i] = rand() % (n / 4 + 1);
+    rbtree_insert(t, arr[i]);
+  }
+  test_extremes(t);
+  qsort(arr, n, sizeof(key_t), comp);
+
+  // popping from both ends alternately reads the sorted array from both ends
+  size_t lo = 0, hi = n;
+  while (lo < hi)
+  {
+    if ((lo + n - hi) % 3 == 2)
+    {
+      assert(rbtree_pop_max(t, &out) == 0);
+      assert(out == arr[--hi]);
+    }
+    else
+    {
+      assert(rbtree_pop_min(t, &out) == 0);
+      assert(out == arr[lo++]);
+    }
+    if ((lo + n - hi) % 512 == 0)
+    {
+      test_extremes(t);
+      test_color_constraint(t);
+    }
+  }
+  assert(rbtree_size(t) == 0 && t->root == t->nil);
+  test_extremes(t);
+  assert(rbtree_pop_min(t, &out) == -1);
+
+  // erase_key removes only one of the duplicates
+  for (int i = 0; i < 3; i++)
+  {
+    rbtree_insert(t, 7);
+  }
+  rbtree_insert(t, 3);
+  assert(rbtree_erase_key(t, 7) == 0 && rbtree_size(t) == 3);
+  assert(rbtree_erase_key(t, 4) == -1);
+  assert(rbtree_erase_key(t, 3) == 0 && rbtree_min(t)->key == 7);
+  test_extremes(t);
+
+  // the rebuild paths (large batch, sorted array) and hinted insert also update the cache
+  assert(rbtree_insert_batch(t, arr, n) == 0);
+  test_extremes(t);
+  assert(rbtree_erase_batch(t, arr, n / 2) == n / 2);
+  test_extremes(t);
+  assert(rbtree_insert_hint(t, rbtree_max(t), arr[n - 1] + 1) == rbtree_max(t));
+  assert(rbtree_insert_hint(t, rbtree_min(t), -1) == rbtree_min(t));
+  test_extremes(t);
+  delete_rbtree(t);
+
+  t = rbtree_from_sorted_array(arr, n);
+  test_extremes(t);
+  assert(rbtree_pop_max(t, &out) == 0 && out == arr[n - 1]);
+  test_extremes(t);
+  delete_rbtree(t);
+  free(arr);
+}
+
+void test_find_batch(const size_t n, const unsigned seed)
+{
+  srand(seed);
+  rbtree *t = new_rbtree();
+  // all NULL on an empty tree
+  key_t probe = 3;
+  node_t *one = rb_nil(t);
+  assert(rbtree_find_batch(t, &probe, 1, &one) == 0 && one == NULL);
+
+  for (int i = 0; i < n; i++)
+  {
+    rbtree_insert(t, rand() % (2 * n));
+  }
+  // a count that is not a multiple of the group size gives the same results as rbtree_find
+  const size_t m = 3 * n + 5;
+  key_t *keys = calloc(m, sizeof(key_t));
+  node_t **out = calloc(m, sizeof(node_t *));
+  for (int i = 0; i < m; i++)
+  {
+    keys[i] = rand() % (2 * n + 10) - 5;
+  }
+  size_t found = rbtree_find_batch(t, keys, m, out);
+  size_t expect = 0;
+  for (int i = 0; i < m; i++)
+  {
+    node_t *p = rbtree_find(t, keys[i]);
+    assert(out[i] == p);
+    expect += p != NULL;
+  }
+  assert(found == expect && found > 0);
+  assert(rbtree_find_batch(t, keys, 0, out) == 0);
+
+  free(keys);
+  free(out);
+  delete_rbtree(t);
+}
+
+// check that parent pointers agree with child pointers (split / join relink many parents)
+static void parent_traverse(const rbtree *t, const node_t *p)
+{
+  if (p == t->nil)
+  {
+    return;
+  }
+  if (p->left != t->nil)
+  {
+    assert(rb_parent(p->left) == p);
+  }
+  if (p->right != t->nil)
+  {
+    assert(rb_parent(p->right) == p);
+  }
+  parent_traverse(t, p->left);
+  parent_traverse(t, p->right);
+}
+
+static void check_split_tree(const rbtree *t, key_t *expect, const size_t n)
+{
+  check_contents(t, expect, n);
+  test_extremes(t);
+  assert(t->root == t->nil || rb_parent(t->root) == t->nil);
+  parent_traverse(t, t->root);
+#ifdef RBTREE_ORDER_STATS
+  assert(size_traverse(t->root, t->nil) == n);
+#endif
+}
+
+void test_split_join(const size_t n, const unsigned seed)
+{
+  srand(seed);
+  key_t *arr = calloc(n, sizeof(key_t));
+  key_t *buf = calloc(n, sizeof(key_t));
+  rbtree *t = new_rbtree();
+  for (int i = 0; i < n; i++)
+  {
+    arr[i] = rand() % (n / 2);
+    rbtree_insert(t, arr[i]);
+  }
+  qsort(arr, n, sizeof(key_t), comp);
+
+  // splitting out of range, at duplicate keys and at random points, then joining back, gives the original contents
+  const key_t cuts[] = {-1, 0, arr[n / 2], arr[n / 3] + 1, arr[n - 1], arr[n - 1] + 1, (key_t)(n / 7)};
+  for (int c = 0; c < sizeof(cuts) / sizeof(cuts[0]); c++)
+  {
+    rbtree *lo, *hi;
+    assert(rbtree_split(t, cuts[c], &lo, &hi) == 0);
+    assert(t->root == t->nil && rbtree_size(t) == 0);
+    size_t nl = 0;
+    while (nl < n && arr[nl] < cuts[c])
+    {
+      nl++;
+    }
+#ifndef RBTREE_ORDER_STATS
+    // split does not count the halves (that would be linear), rbtree_size counts them when asked
+    if (nl > 0 && nl < n)
+    {
+      assert(lo->size_stale && hi->size_stale);
+    }
+#endif
+    assert(rbtree_size(lo) == nl && rbtree_size(hi) == n - nl);
+    memcpy(buf, arr, nl * sizeof(key_t));
+    check_split_tree(lo, buf, nl);
+    memcpy(buf, arr + nl, (n - nl) * sizeof(key_t));
+    check_split_tree(hi, buf, n - nl);
+
+    assert(rbtree_join(t, lo) == 0 && rbtree_size(lo) == 0);
+    assert(rbtree_join(t, hi) == 0 && rbtree_size(hi) == 0);
+    check_split_tree(t, arr, n);
+    delete_rbtree(lo);
+    delete_rbtree(hi);
+  }
+
+#ifndef RBTREE_ORDER_STATS
+  // single inserts and erases keep an uncounted size right, and a batch counts it once
+  assert(t->size_stale);
+  assert(rbtree_insert(t, -5) != NULL && rbtree_erase_key(t, -5) == 0 && rbtree_size(t) == n);
+  assert(rbtree_insert_batch(t, (const key_t[]){-7}, 1) == 0 && !t->size_stale && rbtree_size(t) == n + 1);
+  assert(rbtree_erase_key(t, -7) == 0 && rbtree_size(t) == n);
+#endif
+
+  // joining trees of very different sizes matches their black heights
+  rbtree *small = new_rbtree();
+  for (int i = 0; i < 5; i++)
+  {
+    rbtree_insert(small, -10 + i);
+  }
+  // overlapping key ranges are refused and both trees are left unchanged
+  rbtree_insert(small, arr[n - 1] + 1);
+  assert(rbtree_join(t, small) == -1 && rbtree_size(small) == 6);
+  assert(rbtree_erase_key(small, arr[n - 1] + 1) == 0);
+  assert(rbtree_join(small, t) == 0 && rbtree_size(t) == 0);
+  key_t *all = calloc(n + 5, sizeof(key_t));
+  for (int i = 0; i < 5; i++)
+  {
+    all[i] = -10 + i;
+  }
+  memcpy(all + 5, arr, n * sizeof(key_t));
+  check_split_tree(small, all, n + 5);
+
+  // a joined tree supports insert/erase like any other tree
+  for (int i = 0; i < n; i += 3)
+  {
+    assert(rbtree_erase_key(small, arr[i]) == 0);
+  }
+  test_color_constraint(small);
+  test_search_constraint(small);
+  parent_traverse(small, small->root);
+
+  // a pooled tree splits into two trees sharing its slabs, which outlive whichever tree is deleted first
+  rbtree *pooled = rbtree_from_sorted_array(arr, n);
+  rbtree *lo, *hi;
+  const key_t cut = arr[n / 2];
+  size_t nl = 0;
+  while (arr[nl] < cut)
+  {
+    nl++;
+  }
+  assert(rbtree_split(pooled, cut, &lo, &hi) == 0);
+  assert(rbtree_insert(pooled, cut) != NULL && rbtree_size(pooled) == 1);
+  delete_rbtree(pooled);
+  check_split_tree(lo, arr, nl);
+  delete_rbtree(lo);
+  check_split_tree(hi, arr + nl, n - nl);
+
+  // the split-off tree frees into and allocates from its own pool
+  for (size_t i = nl; i < n; i += 2)
+  {
+    assert(rbtree_erase_key(hi, arr[i]) == 0);
+  }
+  for (size_t i = nl; i < n; i += 2)
+  {
+    assert(rbtree_insert(hi, arr[i]) != NULL);
+  }
+  check_split_tree(hi, arr + nl, n - nl);
+
+  // pooled trees join into a tree that keeps the moved nodes alive, but never join a calloc tree
+  rbtree *front = new_rbtree_with_pool(4);
+  for (size_t i = 0; i < nl; i++)
+  {
+    rbtree_insert(front, arr[i]);
+  }
+  assert(rbtree_join(front, small) == -1 && rbtree_join(small, front) == -1);
+  assert(rbtree_join(front, hi) == 0 && rbtree_size(hi) == 0);
+  delete_rbtree(hi);
+  check_split_tree(front, arr, n);
+  for (size_t i = 0; i < n; i += 3)
+  {
+    assert(rbtree_erase_key(front, arr[i]) == 0);
+  }
+  for (size_t i = 0; i < n; i += 3)
+  {
+    assert(rbtree_insert(front, arr[i]) != NULL);
+  }
+  check_split_tree(front, arr, n);
+  rbtree_reaper *reaper = rbtree_delete_begin(front);
+  while (rbtree_delete_step(reaper, 1))
+  {
+  }
+
+  // nil is shared by every tree and never changes
+  assert(small->nil == t->nil);
+  assert(t->nil->left == t->nil && t->nil->right == t->nil && rb_color(t->nil) == RBTREE_BLACK);
+
+  free(all);
+  free(buf);
+  free(arr);
+  delete_rbtree(small);
+  delete_rbtree(t);
+}
+
+// check that one snapshot holds exactly expect[0 .. n) and keeps the color rules
+static void check_version(const rbtree_version *v, const key_t *expect, const size_t n)
+{
+  assert(rbtree_version_size(v) == n);
+  assert(rbtree_version_check(v) >= 0);
+  key_t *res = calloc(n + 1, sizeof(key_t));
+  assert(rbtree_version_to_array(v, res, n + 1) == n);
+  for (int i = 0; i < n; i++)
+  {
+    assert(res[i] == expect[i]);
+    assert(rbtree_version_find(v, expect[i]) == 1);
+  }
+  free(res);
+}
+
+typedef struct
+{
+  rbtree_persistent *p;
+  int stop;
+} persistent_arg;
+
+// snapshots taken while the writer keeps changing the tree must always show one complete version
+static void *persistent_reader(void *p)
+{
+  persistent_arg *arg = p;
+  while (!__atomic_load_n(&arg->stop, __ATOMIC_ACQUIRE))
+  {
+    rbtree_version *v = rbtree_snapshot(arg->p);
+    assert(v != NULL);
+    const size_t n = rbtree_version_size(v);
+    assert(rbtree_version_check(v) >= 0);
+    key_t *res = calloc(n + 1, sizeof(key_t));
+    assert(rbtree_version_to_array(v, res, n + 1) == n);
+    // the writer only inserts and erases even keys, so odd keys are in no version
+    for (int i = 0; i < n; i++)
+    {
+      assert(res[i] % 2 == 0 && (i == 0 || res[i - 1] <= res[i]));
+      assert(rbtree_version_find(v, res[i] + 1) == 0);
+    }
+    free(res);
+    rbtree_version_release(v);
+  }
+  return NULL;
+}
+
+void test_persistent(const size_t n, const unsigned seed)
+{
+  srand(seed);
+  rbtree_persistent *p = new_rbtree_persistent();
+  assert(p != NULL);
+  rbtree *ref = new_rbtree();
+
+  // empty version
+  enum { CHECKPOINTS = 16 };
+  rbtree_version *vs[CHECKPOINTS];
+  key_t *expect[CHECKPOINTS];
+  size_t sizes[CHECKPOINTS];
+  vs[0] = rbtree_snapshot(p);
+  expect[0] = NULL;
+  sizes[0] = 0;
+  assert(rbtree_version_check(vs[0]) == 0);
+  assert(rbtree_version_find(vs[0], 1) == 0);
+  key_t lb;
+  assert(rbtree_version_lower_bound(vs[0], 0, &lb) == -1);
+  assert(rbtree_persistent_erase(p, 1) == -1);
+
+  // take snapshots between random inserts/erases, and record the contents by running the same operations on a plain tree
+  const size_t ops = n * 2;
+  for (size_t op = 0, c = 1; op < ops; op++)
+  {
+    const key_t k = rand() % (n / 2);
+    if (rand() % 3 == 0)
+    {
+      node_t *q = rbtree_find(ref, k);
+      assert(rbtree_persistent_erase(p, k) == (q == NULL ? -1 : 0));
+      if (q != NULL)
+      {
+        rbtree_erase(ref, q);
+      }
+    }
+    else
+    {
+      assert(rbtree_persistent_insert(p, k) == 0);
+      rbtree_insert(ref, k);
+    }
+    assert(rbtree_persistent_size(p) == rbtree_size(ref));
+    if ((op + 1) % (ops / (CHECKPOINTS - 1)) == 0 && c < CHECKPOINTS)
+    {
+      vs[c] = rbtree_snapshot(p);
+      sizes[c] = rbtree_size(ref);
+      expect[c] = calloc(sizes[c] + 1, sizeof(key_t));
+      rbtree_to_array(ref, expect[c], sizes[c]);
+      c++;
+    }
+  }
+
+  // later operations do not change earlier snapshots
+  for (int c = 0; c < CHECKPOINTS; c++)
+  {
+    check_version(vs[c], expect[c], sizes[c]);
+  }
+  const rbtree_version *last = vs[CHECKPOINTS - 1];
+  const size_t nl = sizes[CHECKPOINTS - 1];
+  for (int i = 0; i < 1000; i++)
+  {
+    const key_t k = rand() % (n / 2 + 2) - 1;
+    const key_t *e = expect[CHECKPOINTS - 1];
+    size_t j = 0;
+    while (j < nl && e[j] < k)
+    {
+      j++;
+    }
+    if (j == nl)
+    {
+      assert(rbtree_version_lower_bound(last, k, &lb) == -1);
+    }
+    else
+    {
+      assert(rbtree_version_lower_bound(last, k, &lb) == 0 && lb == e[j]);
+    }
+  }
+
+  // emptying the current version leaves the snapshots intact, and nodes are freed in any release order (ASan leak check)
+  for (node_t *q = rbtree_min(ref); q != ref->nil; q = rbtree_min(ref))
+  {
+    assert(rbtree_persistent_erase(p, q->key) == 0);
+    rbtree_erase(ref, q);
+  }
+  assert(rbtree_persistent_size(p) == 0);
+  for (int c = CHECKPOINTS - 1; c >= 0; c -= 2)
+  {
+    check_version(vs[c], expect[c], sizes[c]);
+    rbtree_version_release(vs[c]);
+    free(expect[c]);
+  }
+  delete_rbtree_persistent(p);
+  for (int c = CHECKPOINTS - 2; c >= 0; c -= 2)
+  {
+    check_version(vs[c], expect[c], sizes[c]);
+    rbtree_version_release(vs[c]);
+    free(expect[c]);
+  }
+  delete_rbtree(ref);
+
+  // the writer keeps making new versions while reader threads hold and read snapshots
+  persistent_arg arg = {new_rbtree_persistent(), 0};
+  assert(arg.p != NULL);
+  pthread_t tid[2];
+  for (int i = 0; i < 2; i++)
+  {
+    assert(pthread_create(&tid[i], NULL, persistent_reader, &arg) == 0);
+  }
+  for (int round = 0; round < 10; round++)
+  {
+    for (int k = 0; k < 1000; k += 2)
+    {
+      assert(rbtree_persistent_insert(arg.p, k) == 0);
+    }
+    for (int k = 0; k < 1000; k += 4)
+    {
+      assert(rbtree_persistent_erase(arg.p, k) == 0);
+    }
+  }
+  __atomic_store_n(&arg.stop, 1, __ATOMIC_RELEASE);
+  for (int i = 0; i < 2; i++)
+  {
+    pthread_join(tid[i], NULL);
+  }
+  assert(rbtree_persistent_size(arg.p) == 10 * 500 - 10 * 250);
+  rbtree_version *v = rbtree_snapshot(arg.p);
+  assert(rbtree_version_check(v) >= 0);
+  rbtree_version_release(v);
+  delete_rbtree_persistent(arg.p);
+}
+
+// in-memory buffer that collects serialized bytes
+typedef struct
+{
+  unsigned char *data;
+  size_t len;
+  size_t cap;
+  size_t pos;     // read position
+  size_t max_read; // most bytes returned per read (to exercise fragmented reads)
+  size_t limit;   // reads return 0 after this many bytes, as if the stream were cut
+} mem_stream;
+
+static int mem_write(void *p, const void *buf, size_t len)
+{
+  mem_stream *m = p;
+  if (m->len + len > m->cap)
+  {
+    m->cap = (m->len + len) * 2;
+    m->data = realloc(m->data, m->cap);
+  }
+  memcpy(m->data + m->len, buf, len);
+  m->len += len;
+  return 0;
+}
+
+static size_t mem_read(void *p, void *buf, size_t len)
+{
+  mem_stream *m = p;
+  size_t avail = (m->limit < m->len ? m->limit : m->len) - m->pos;
+  if (len > avail)
+  {
+    len = avail;
+  }
+  if (m->max_read != 0 && len > m->max_read)
+  {
+    len = m->max_read;
+  }
+  memcpy(buf, m->data + m->pos, len);
+  m->pos += len;
+  return len;
+}
+
+static int fail_write(void *p, const void *buf, size_t len)
+{
+  return -1;
+}
+
+// keys counting down by 1 from *p
+static int descending_key(void *p, key_t *out)
+{
+  *out = (*(key_t *)p)--;
+  return 0;
+}
+
+void test_serialize(const size_t n, const unsigned int seed)
+{
+  srand(seed);
+  key_t *arr = calloc(n, sizeof(key_t));
+  const size_t sizes[] = {0, 1, 2, 100, n};
+  for (int c = 0; c < sizeof(sizes) / sizeof(sizes[0]); c++)
+  {
+    const size_t m = sizes[c];
+    // keys mixing duplicates, negatives and both extremes
+    rbtree *t = new_rbtree();
+    for (int i = 0; i < m; i++)
+    {
+      arr[i] = i % 7 == 0 ? (rand() % 2 ? INT_MAX : INT_MIN) : rand() - RAND_MAX / 2;
+      rbtree_insert(t, arr[i]);
+    }
+    mem_stream ms = {0};
+    assert(rbtree_serialize(t, mem_write, &ms) == 0);
+    // fragmented reads and whole reads give the same tree
+    for (size_t max_read = 1; max_read <= 4096; max_read *= 8)
+    {
+      ms.pos = 0;
+      ms.max_read = max_read;
+      ms.limit = SIZE_MAX;
+      rbtree *u = rbtree_deserialize(mem_read, &ms);
+      assert(u != NULL && u->pool != NULL);
+      assert(ms.pos == ms.len);
+      check_contents(u, arr, m);
+      test_extremes(u);
+#ifdef RBTREE_ORDER_STATS
+      assert(size_traverse(u->root, u->nil) == m);
+#endif
+      delete_rbtree(u);
+    }
+    // a stream cut short is refused
+    for (size_t cut = 0; cut < ms.len; cut += 1 + ms.len / 50)
+    {
+      ms.pos = 0;
+      ms.max_read = 0;
+      ms.limit = cut;
+      assert(rbtree_deserialize(mem_read, &ms) == NULL);
+    }
+    free(ms.data);
+    delete_rbtree(t);
+  }
+
+  // dense keys take a little over 1 byte each
+  rbtree *t = new_rbtree();
+  for (int i = 0; i < n; i++)
+  {
+    rbtree_insert(t, i / 2);
+  }
+  mem_stream ms = {0};
+  assert(rbtree_serialize(t, mem_write, &ms) == 0);
+  assert(ms.len < n + n / 64);
+
+  // two trees written back to back on one stream are read in turn (the first read does not consume the second tree's bytes)
+  rbtree *small = rbtree_from_sorted_array((const key_t[]){-3, 5, 5, 9}, 4);
+  assert(rbtree_serialize(small, mem_write, &ms) == 0);
+  ms.limit = SIZE_MAX;
+  rbtree *a = rbtree_deserialize(mem_read, &ms);
+  rbtree *b = rbtree_deserialize(mem_read, &ms);
+  assert(a != NULL && rbtree_size(a) == n && b != NULL && ms.pos == ms.len);
+  check_contents(b, (key_t[]){-3, 5, 5, 9}, 4);
+  delete_rbtree(a);
+  delete_rbtree(b);
+
+  // corrupted header / values
+  ms.pos = 0;
+  ms.data[0] = 'X';
+  assert(rbtree_deserialize(mem_read, &ms) == NULL);
+  free(ms.data);
+  assert(rbtree_serialize(small, fail_write, NULL) == -1);
+
+  // FILE streams
+  FILE *fp = tmpfile();
+  assert(fp != NULL);
+  assert(rbtree_serialize(t, rbtree_serial_fwrite, fp) == 0);
+  rewind(fp);
+  rbtree *u = rbtree_deserialize(rbtree_serial_fread, fp);
+  assert(u != NULL);
+  for (int i = 0; i < n; i++)
+  {
+    arr[i] = i / 2;
+  }
+  check_contents(u, arr, n);
+  fclose(fp);
+
+  // a source that yields unsorted keys is refused by the bulk build
+  key_t start = 10;
+  assert(rbtree_from_sorted_source(3, descending_key, &start) == NULL);
+  assert(rbtree_from_sorted_source(3, NULL, NULL) == NULL);
+  // a failing source stops the build at once instead of filling the remaining nodes
+  start = 10;
+  assert(rbtree_from_sorted_source((size_t)1 << 40, descending_key, &start) == NULL);
+  assert(start == 8);
+
+  // a header whose key count cannot fit in memory is refused before any key is read,
+  // and a count larger than the keys that follow fails as soon as the keys run out
+  const uint64_t claims[] = {UINT64_MAX / 2, (uint64_t)1 << 40};
+  for (int c = 0; c < 2; c++)
+  {
+    unsigned char forged[32] = {'R', 'B', 'T', 'S', 1, sizeof(key_t), 0, 0};
+    size_t len = 8;
+    for (uint64_t v = claims[c]; ; v >>= 7)
+    {
+      forged[len++] = (v & 0x7f) | (v >= 0x80 ? 0x80 : 0);
+      if (v < 0x80)
+      {
+        break;
+      }
+    }
+    const size_t header = len;
+    // one chunk of three keys (5, 6, 7), then the end mark
+    const unsigned char keys[] = {3, 10, 1, 1, 0};
+    memcpy(forged + len, keys, sizeof(keys));
+    len += sizeof(keys);
+    mem_stream fs = {forged, len, len, 0, 0, SIZE_MAX};
+    assert(rbtree_deserialize(mem_read, &fs) == NULL);
+    assert(fs.pos == (c == 0 ? header : len));
+  }
+
+  delete_rbtree(u);
+  delete_rbtree(small);
+  delete_rbtree(t);
+  free(arr);
+}
+
+#ifdef RBTREE_COUNTED
+static size_t count_nodes(const rbtree *t)
+{
+  size_t nodes = 0;
+  for (node_t *p = rbtree_min(t); p != t->nil; p = rbtree_next(t, p))
+  {
+    nodes++;
+  }
+  return nodes;
+}
+
+// equal keys collect in one node's count, and key-level operations match the expanded duplicates
+void test_counted(const size_t n, const unsigned seed)
+{
+  srand(seed);
+  const key_t span = 16;
+  key_t *arr = calloc(2 * n, sizeof(key_t));
+  key_t *expect = calloc(2 * n, sizeof(key_t));
+  rbtree *t = new_rbtree();
+  for (int i = 0; i < n; i++)
+  {
+    arr[i] = rand() % span;
+    node_t *p = rbtree_insert(t, arr[i]);
+    assert(p != NULL && p->key == arr[i]);
+  }
+  memcpy(expect, arr, n * sizeof(key_t));
+  check_contents(t, expect, n);
+  assert(count_nodes(t) <= span);
+  test_extremes(t);
+#ifdef RBTREE_ORDER_STATS
+  assert(size_traverse(t->root, t->nil) == n);
+  for (size_t k = 0; k < n; k += 97)
+  {
+    assert(rbtree_select(t, k)->key == expect[k]);
+  }
+  size_t below = 0;
+  while (expect[below] < span / 2)
+  {
+    below++;
+  }
+  assert(rbtree_rank(t, span / 2) == below);
+  assert(rbtree_select(t, n) == t->nil);
+#endif
+
+  // each erase lowers count, and the node goes away when the last one is removed
+  node_t *p = rbtree_find(t, expect[0]);
+  const size_t copies = p->count;
+  for (size_t i = 1; i < copies; i++)
+  {
+    assert(rbtree_erase_key(t, expect[0]) == 0);
+    assert(rbtree_find(t, expect[0]) == p);
+  }
+  assert(p->count == 1 && rbtree_erase_key(t, expect[0]) == 0);
+  assert(rbtree_find(t, expect[0]) == NULL);
+  size_t kept = n - copies;
+  memmove(expect, expect + copies, kept * sizeof(key_t));
+  check_contents(t, expect, kept);
+
+  // both large batches (merge path) and small batches (finger path) add to the existing node's count
+  for (int i = 0; i < n; i++)
+  {
+    arr[i] = rand() % span;
+  }
+  assert(rbtree_insert_batch(t, arr, n) == 0);
+  assert(rbtree_insert_batch(t, arr, 50) == 0);
+  memcpy(expect + kept, arr, n * sizeof(key_t));
+  memcpy(expect + kept + n, arr, 50 * sizeof(key_t));
+  kept += n + 50;
+  check_contents(t, expect, kept);
+  assert(count_nodes(t) <= span);
+#ifdef RBTREE_ORDER_STATS
+  assert(size_traverse(t->root, t->nil) == kept);
+#endif
+
+  // erasing more copies of a key than the tree holds removes only what is there
+  const key_t gone = expect[kept - 1];
+  size_t have = 0;
+  while (have < kept && expect[kept - 1 - have] == gone)
+  {
+    have++;
+  }
+  for (size_t i = 0; i < 2 * have; i++)
+  {
+    arr[i] = gone;
+  }
+  assert(rbtree_erase_batch(t, arr, 2 * have) == (int)have);
+  kept -= have;
+  check_contents(t, expect, kept);
+  assert(rbtree_find(t, gone) == NULL);
+
+  // pop takes one at a time
+  key_t out;
+  assert(rbtree_pop_min(t, &out) == 0 && out == expect[0]);
+  assert(rbtree_pop_max(t, &out) == 0 && out == expect[kept - 1]);
+  kept -= 2;
+  memmove(expect, expect + 1, kept * sizeof(key_t));
+  check_contents(t, expect, kept);
+
+  // rb_unlink_node removes the whole count at once (the middle key is likely a node with two children)
+  p = rbtree_find(t, expect[kept / 2]);
+  size_t first = kept / 2;
+  while (first > 0 && expect[first - 1] == p->key)
+  {
+    first--;
+  }
+  const size_t whole = p->count;
+  rb_unlink_node(t, p);
+  rb_free_node(t, p);
+  kept -= whole;
+  memmove(expect + first, expect + first + whole, (kept - first) * sizeof(key_t));
+  check_contents(t, expect, kept);
+#ifdef RBTREE_ORDER_STATS
+  assert(size_traverse(t->root, t->nil) == kept);
+#endif
+
+  // hinted inserts in nearly reverse order with repeats: a wrong hint climbs on its predecessor side,
+  // and must still reach an existing node with the same key instead of adding a second one
+  rbtree *hinted = new_rbtree();
+  node_t *hint = NULL;
+  size_t hinted_n = 0;
+  for (int round = 0; round < 3; round++)
+  {
+    for (key_t k = 2000; k > 0; k--)
+    {
+      arr[hinted_n] = k - rand() % 48;
+      hint = rbtree_insert_hint(hinted, hint, arr[hinted_n]);
+      assert(hint != NULL && hint->key == arr[hinted_n]);
+      hinted_n++;
+    }
+  }
+  check_contents(hinted, arr, hinted_n);
+  size_t distinct = 1;
+  for (size_t i = 1; i < hinted_n; i++)
+  {
+    distinct += arr[i] != arr[i - 1];
+  }
+  assert(count_nodes(hinted) == distinct);
+  assert(rbtree_validate(hinted) > 0);
+  delete_rbtree(hinted);
+
+  // the bulk build makes one node per distinct key, and expanding it gives back the original array
+  rbtree *bulk = rbtree_from_sorted_array(expect, kept);
+  assert(bulk != NULL && count_nodes(bulk) == count_nodes(t));
+  check_contents(bulk, expect, kept);
+#ifdef RBTREE_ORDER_STATS
+  assert(size_traverse(bulk->root, bulk->nil) == kept);
+#endif
+  mem_stream ms = {0};
+  ms.limit = SIZE_MAX;
+  assert(rbtree_serialize(bulk, mem_write, &ms) == 0);
+  rbtree *back = rbtree_deserialize(mem_read, &ms);
+  assert(back != NULL && count_nodes(back) == count_nodes(t));
+  check_contents(back, expect, kept);
+  free(ms.data);
+  delete_rbtree(back);
+  delete_rbtree(bulk);
+
+  // split keeps equal keys on one side, and join merges equal keys at the seam into one node
+  rbtree *lo, *hi;
+  const size_t nodes = count_nodes(t);
+  assert(rbtree_split(t, span / 2, &lo, &hi) == 0);
+  size_t nlo = 0;
+  while (expect[nlo] < span / 2)
+  {
+    nlo++;
+  }
+  check_split_tree(lo, expect, nlo);
+  check_split_tree(hi, expect + nlo, kept - nlo);
+  const key_t edge = expect[nlo];
+  assert(rbtree_insert(lo, edge) != NULL);
+  assert(rbtree_join(lo, hi) == 0);
+  assert(rbtree_size(hi) == 0 && count_nodes(lo) == nodes);
+  expect[kept++] = edge;
+  check_split_tree(lo, expect, kept);
+  delete_rbtree(hi);
+  delete_rbtree(lo);
+  delete_rbtree(t);
+
+  // copying a prefix stops in the middle of a run
+  t = rbtree_from_sorted_array((const key_t[]){1, 2, 2, 2, 3}, 5);
+  key_t res[5];
+  assert(count_nodes(t) == 3);
+  assert(rbtree_to_array(t, res, 3) == 3 && res[2] == 2);
+  assert(rbtree_range(t, 2, 3, res, 2) == 2 && res[0] == 2 && res[1] == 2);
+  delete_rbtree(t);
+
+  free(expect);
+  free(arr);
+}
+#endif
+
+int main(void)
+{
+  test_init();
+  test_insert_single(1024);
+  test_find_single(512, 1024);
+  test_erase_root(128);
+  test_find_erase_fixed();
+  test_minmax_suite();
+  test_to_array_suite();
+  test_to_array_prefix();
+  test_iterator(1000, 31);
+  test_bounds_range(1000, 37);
+  test_distinct_values();
+  test_duplicate_values();
+  test_validate(10000, 19);
+  test_multi_instance();
+  test_find_erase_rand(10000, 17);
+  test_pool(10000, 23);
+  test_pool_options(10000, 29);
+  test_delete_step(10000, 31);
+  test_from_sorted_array(10000);
+  test_batch(41);
+#ifdef RBTREE_ORDER_STATS
+  test_order_stats(10000, 43);
+#endif
+#ifdef RBTREE_STATS
+  test_stats(10000);
+#endif
+  test_concurrent(4000, 4, 20);
+  test_sharded(20000, 4);
+  test_parallel(50000, 47);
+  test_frozen(3000, 53);
+  test_frozen_holder_threads(2000, 4);
+  test_frozen_holder_churn(200000, 4);
+  test_frozen_file(5000, 59);
+  test_generic(10000, 61);
+  test_intrusive(5000);
+  test_insert_hint(10000, 67);
+  test_pop_minmax(10000, 71);
+  test_find_batch(10000, 73);
+  test_split_join(20000, 79);
+  test_persistent(10000, 83);
+  test_serialize(20000, 89);
+#ifdef RBTREE_COUNTED
+  test_counted(20000, 97);
+#endif
   printf("Passed all tests!\n");
 }
@@ -0,0 +1,264 @@
+#include <assert.h>
+#include <rbtree.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Tests for the top-down rbtree in src/topdown.
+// The public API is the same as src/rbtree.h, so the cases mirror
+// test-compact.c; nodes have no parent pointer and children may be NULL.
+
+static void insert_arr(rbtree *t, const key_t *arr, const size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    rbtree_insert(t, arr[i]);
+  }
+}
+
+static int comp(const void *p1, const void *p2)
+{
+  const key_t *e1 = (const key_t *)p1;
+  const key_t *e2 = (const key_t *)p2;
+  if (*e1 < *e2)
+  {
+    return -1;
+  }
+  else if (*e1 > *e2)
+  {
+    return 1;
+  }
+  else
+  {
+    return 0;
+  }
+};
+
+// no parent pointer: key, color and two children
+void test_node_size(void)
+{
+  assert(sizeof(node_t) == sizeof(key_t) + sizeof(color_t) + 2 * sizeof(node_t *));
+}
+
+void test_init(void)
+{
+  rbtree *t = new_rbtree();
+  assert(t != NULL);
+  assert(t->nil != NULL);
+  assert(t->root == NULL && t->size == 0);
+  assert(rbtree_min(t) == t->nil);
+  assert(rbtree_max(t) == t->nil);
+  assert(rbtree_erase(t, t->nil) == -1);
+  delete_rbtree(t);
+}
+
+void test_insert_find_single(const key_t key, const key_t wrong_key)
+{
+  rbtree *t = new_rbtree();
+  node_t *p = rbtree_insert(t, key);
+  assert(p != NULL);
+  assert(t->root == p);
+  assert(p->key == key);
+  assert(p->color == RBTREE_BLACK);
+  assert(p->child[0] == NULL && p->child[1] == NULL);
+
+  assert(rbtree_find(t, key) == p);
+  assert(rbtree_find(t, wrong_key) == NULL);
+
+  assert(rbtree_erase(t, p) == 0);
+  assert(t->root == NULL);
+  delete_rbtree(t);
+}
+
+static bool search_traverse(const node_t *p, key_t *min, key_t *max)
+{
+  if (p == NULL)
+  {
+    return true;
+  }
+  key_t l_min, l_max, r_min, r_max;
+  l_min = l_max = r_min = r_max = p->key;
+
+  if (!search_traverse(p->child[0], &l_min, &l_max) || l_max > p->key)
+  {
+    return false;
+  }
+  if (!search_traverse(p->child[1], &r_min, &r_max) || r_min < p->key)
+  {
+    return false;
+  }
+  *min = l_min;
+  *max = r_max;
+  return true;
+}
+
+// returns black height, or -1 if a color constraint is broken
+static int color_traverse(const node_t *p, const color_t parent_color, size_t *count)
+{
+  if (p == NULL)
+  {
+    return 0;
+  }
+  if (parent_color == RBTREE_RED && p->color == RBTREE_RED)
+  {
+    return -1;
+  }
+  (*count)++;
+  int l = color_traverse(p->child[0], p->color, count);
+  int r = color_traverse(p->child[1], p->color, count);
+  if (l < 0 || l != r)
+  {
+    return -1;
+  }
+  return l + (p->color == RBTREE_BLACK ? 1 : 0);
+}
+
+static void test_constraints(const rbtree *t)
+{
+  key_t min, max;
+  size_t count = 0;
+  assert(t->root == NULL || t->root->color == RBTREE_BLACK);
+  assert(search_traverse(t->root, &min, &max));
+  const int h = color_traverse(t->root, RBTREE_BLACK, &count);
+  assert(h >= 0 && rbtree_validate(t) == h);
+  assert(count == t->size);
+}
+
+void test_minmax_to_array(key_t *arr, const size_t n)
+{
+  rbtree *t = new_rbtree();
+  insert_arr(t, arr, n);
+  test_constraints(t);
+
+  qsort((void *)arr, n, sizeof(key_t), comp);
+  key_t *res = calloc(n, sizeof(key_t));
+  assert(rbtree_to_array(t, res, n) == n);
+  for (int i = 0; i < n; i++)
+  {
+    assert(arr[i] == res[i]);
+  }
+  assert(rbtree_to_array(t, res, n / 2) == n / 2);
+
+  node_t *p = rbtree_min(t);
+  node_t *q = rbtree_max(t);
+  assert(p->key == arr[0]);
+  assert(q->key == arr[n - 1]);
+  rbtree_erase(t, p);
+  rbtree_erase(t, q);
+  assert(rbtree_min(t)->key == arr[1]);
+  assert(rbtree_max(t)->key == arr[n - 2]);
+  test_constraints(t);
+
+  free(res);
+  delete_rbtree(t);
+}
+
+void test_find_erase(rbtree *t, const key_t *arr, const size_t n)
+{
+  for (int i = 0; i < n; i++)
+  {
+    assert(rbtree_insert(t, arr[i]) != NULL);
+  }
+  test_constraints(t);
+
+  for (int i = 0; i < n; i++)
+  {
+    node_t *p = rbtree_find(t, arr[i]);
+    assert(p != NULL);
+    assert(p->key == arr[i]);
+    assert(rbtree_erase(t, p) == 0);
+    if (i % 512 == 0)
+    {
+      test_constraints(t);
+    }
+  }
+  assert(t->root == NULL && t->size == 0);
+
+  for (int i = 0; i < n; i++)
+  {
+    assert(rbtree_find(t, arr[i]) == NULL);
+  }
+}
+
+void test_find_erase_rand(const size_t n, const unsigned int seed, const size_t range)
+{
+  srand(seed);
+  rbtree *t = new_rbtree();
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++)
+  {
+    arr[i] = rand() % range;
+  }
+
+  test_find_erase(t, arr, n);
+  test_find_erase(t, arr, n);
+
+  free(arr);
+  delete_rbtree(t);
+}
+
+// sorted input makes the insert pass split 4-nodes on every level
+void test_sorted_insert(const size_t n)
+{
+  rbtree *t = new_rbtree();
+  for (int i = 0; i < n; i++)
+  {
+    assert(rbtree_insert(t, i)->key == i);
+  }
+  test_constraints(t);
+  key_t *res = calloc(n, sizeof(key_t));
+  assert(rbtree_to_array(t, res, n) == n);
+  for (int i = 0; i < n; i++)
+  {
+    assert(res[i] == i);
+  }
+  // erase from the max end so every pass borrows from the left sibling
+  for (int i = n - 1; i >= 0; i--)
+  {
+    assert(rbtree_erase(t, rbtree_max(t)) == 0);
+    if (i % 256 == 0)
+    {
+      test_constraints(t);
+    }
+  }
+  assert(t->root == NULL);
+  free(res);
+  delete_rbtree(t);
+}
+
+// rbtree_validate should accept a valid tree and reject a key out of order
+void test_validate(const size_t n)
+{
+  rbtree *t = new_rbtree();
+  assert(rbtree_validate(NULL) == -1);
+  assert(rbtree_validate(t) == 0);
+  for (int i = 0; i < n; i++)
+  {
+    rbtree_insert(t, i * 7 % 1001);
+  }
+  assert(rbtree_validate(t) > 0);
+  node_t *min = rbtree_min(t);
+  const key_t key = min->key;
+  min->key = rbtree_max(t)->key + 1;
+  assert(rbtree_validate(t) == -1);
+  min->key = key;
+  assert(rbtree_validate(t) > 0);
+  delete_rbtree(t);
+}
+
+int main(void)
+{
+  test_node_size();
+  test_init();
+  test_insert_find_single(512, 1024);
+
+  key_t entries[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12, 24, 36, 990, 25};
+  test_minmax_to_array(entries, sizeof(entries) / sizeof(entries[0]));
+
+  test_find_erase_rand(10000, 17, 5001);
+  test_find_erase_rand(200000, 29, 1u << 30);
+  test_find_erase_rand(50000, 31, 10);
+  test_sorted_insert(10000);
+  test_validate(5000);
+  printf("Passed all tests!\n");
+}